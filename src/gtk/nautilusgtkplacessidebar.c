@@ -129,6 +129,16 @@ struct _NautilusGtkPlacesSidebar {
 
   GtkWidget *trash_row;
 
+  /* update_places() reuses the rows of the places that are still there.
+   * While it runs, the rows it hasn't seen yet are kept here, by place key,
+   * and the ones left at the end are removed. */
+  GHashTable *stale_places;
+  guint n_places;
+
+  /* Display name and icon of bookmarks and application shortcuts, by uri,
+   * so that they aren't queried again on every update. */
+  GHashTable *place_infos;
+
   /* DND */
   gboolean   dragging_over;
   GtkWidget *drag_row;
@@ -164,6 +174,7 @@ struct _NautilusGtkPlacesSidebar {
   guint show_other_locations   : 1;
   guint show_trash             : 1;
   guint show_starred_location  : 1;
+  guint places_need_sort       : 1;
 };
 
 struct _NautilusGtkPlacesSidebarClass {
@@ -389,6 +400,145 @@ list_box_header_func (GtkListBoxRow *row,
     }
 }
 
+static char *
+get_place_key (NautilusGtkPlacesPlaceType    place_type,
+               NautilusGtkPlacesSectionType  section_type,
+               int                           index,
+               const char                   *uri,
+               GDrive                       *drive,
+               GVolume                      *volume,
+               GMount                       *mount,
+               gpointer                      cloud_provider_account)
+{
+  /* Rows keep a reference on their drive, volume and mount, so the
+   * pointers can't be reused by other objects while the row exists. */
+  return g_strdup_printf ("%d:%d:%d:%s:%p:%p:%p:%p",
+                          place_type, section_type, index,
+                          uri != NULL ? uri : "",
+                          drive, volume, mount, cloud_provider_account);
+}
+
+static GtkWidget *
+lookup_place (NautilusGtkPlacesSidebar *sidebar,
+              const char               *key)
+{
+  GtkWidget *row;
+
+  /* During update_places(), a row can only be reused once */
+  if (sidebar->stale_places != NULL)
+    {
+      row = g_hash_table_lookup (sidebar->stale_places, key);
+      if (row != NULL)
+        g_hash_table_remove (sidebar->stale_places, key);
+
+      return row;
+    }
+
+  for (row = gtk_widget_get_first_child (GTK_WIDGET (sidebar->list_box));
+       row != NULL;
+       row = gtk_widget_get_next_sibling (row))
+    {
+      if (g_strcmp0 (g_object_get_data (G_OBJECT (row), "place-key"), key) == 0)
+        return row;
+    }
+
+  return NULL;
+}
+
+static gboolean
+place_is_stale (NautilusGtkPlacesSidebar *sidebar,
+                GtkWidget                *row)
+{
+  const char *key;
+
+  if (sidebar->stale_places == NULL)
+    return FALSE;
+
+  key = g_object_get_data (G_OBJECT (row), "place-key");
+
+  return key != NULL && g_hash_table_lookup (sidebar->stale_places, key) == row;
+}
+
+/* Keeps the row of a place whose info is still being queried, so that it
+ * doesn't disappear and come back once the query is done. */
+static void
+keep_place (NautilusGtkPlacesSidebar     *sidebar,
+            NautilusGtkPlacesPlaceType    place_type,
+            NautilusGtkPlacesSectionType  section_type,
+            int                           index,
+            const char                   *uri)
+{
+  char *key;
+
+  key = get_place_key (place_type, section_type, index, uri,
+                       NULL, NULL, NULL, NULL);
+  lookup_place (sidebar, key);
+  g_free (key);
+}
+
+static gboolean
+icons_equal (GIcon *icon1,
+             GIcon *icon2)
+{
+  if (icon1 == NULL || icon2 == NULL)
+    return icon1 == icon2;
+
+  return g_icon_equal (icon1, icon2);
+}
+
+/* Returns whether the row has to be sorted again */
+static gboolean
+update_place_row (GtkWidget  *row,
+                  const char *name,
+                  GIcon      *start_icon,
+                  GIcon      *end_icon,
+                  const char *tooltip,
+                  gboolean    ejectable,
+                  const char *eject_tooltip)
+{
+  char *old_name, *old_tooltip, *old_eject_tooltip;
+  GIcon *old_start_icon, *old_end_icon;
+  gboolean old_ejectable;
+  gboolean needs_sort = FALSE;
+
+  g_object_get (row,
+                "label", &old_name,
+                "start-icon", &old_start_icon,
+                "end-icon", &old_end_icon,
+                "tooltip", &old_tooltip,
+                "ejectable", &old_ejectable,
+                "eject-tooltip", &old_eject_tooltip,
+                NULL);
+
+  g_object_freeze_notify (G_OBJECT (row));
+
+  if (g_strcmp0 (old_name, name) != 0)
+    {
+      g_object_set (row, "label", name, NULL);
+      needs_sort = TRUE;
+    }
+  if (!icons_equal (old_start_icon, start_icon))
+    g_object_set (row, "start-icon", start_icon, NULL);
+  if (!icons_equal (old_end_icon, end_icon))
+    g_object_set (row, "end-icon", end_icon, NULL);
+  if (g_strcmp0 (old_tooltip, tooltip) != 0)
+    g_object_set (row, "tooltip", tooltip, NULL);
+  if (old_ejectable != ejectable)
+    g_object_set (row, "ejectable", ejectable, NULL);
+  if (g_strcmp0 (old_eject_tooltip, eject_tooltip) != 0)
+    g_object_set (row, "eject-tooltip", eject_tooltip, NULL);
+
+  g_object_thaw_notify (G_OBJECT (row));
+
+  g_free (old_name);
+  g_free (old_tooltip);
+  g_free (old_eject_tooltip);
+  g_clear_object (&old_start_icon);
+  g_clear_object (&old_end_icon);
+
+  return needs_sort;
+}
+
 static GtkWidget*
 add_place (NautilusGtkPlacesSidebar            *sidebar,
            NautilusGtkPlacesPlaceType           place_type,
@@ -414,6 +564,8 @@ add_place (NautilusGtkPlacesSidebar            *sidebar,
   GtkWidget *eject_button;
   GtkGesture *gesture;
   char *eject_tooltip;
+  char *key;
+  guint sequence;
 
   check_unmount_and_eject (mount, volume, drive,
                            &show_unmount, &show_eject);
@@ -429,6 +581,35 @@ add_place (NautilusGtkPlacesSidebar            *sidebar,
   else
     eject_tooltip = _("Unmount");
 
+  /* Places that compare equal in the sort function keep the order in
+   * which they were added. */
+  sequence = ++sidebar->n_places;
+
+  key = get_place_key (place_type, section_type, index, uri,
+                       drive, volume, mount, cloud_provider_account);
+  row = lookup_place (sidebar, key);
+  if (row != NULL)
+    {
+      gboolean needs_sort;
+
+      needs_sort = update_place_row (row, name, start_icon, end_icon, tooltip,
+                                     show_eject_button, eject_tooltip);
+      if (GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row), "place-sequence")) != sequence)
+        {
+          g_object_set_data (G_OBJECT (row), "place-sequence", GUINT_TO_POINTER (sequence));
+          needs_sort = TRUE;
+        }
+
+      if (needs_sort && sidebar->stale_places != NULL)
+        sidebar->places_need_sort = TRUE;
+      else if (needs_sort)
+        gtk_list_box_row_changed (GTK_LIST_BOX_ROW (row));
+
+      g_free (key);
+
+      return row;
+    }
+
   row = g_object_new (NAUTILUS_TYPE_GTK_SIDEBAR_ROW,
                       "sidebar", sidebar,
                       "start-icon", start_icon,
@@ -448,6 +629,8 @@ add_place (NautilusGtkPlacesSidebar            *sidebar,
                       "cloud-provider-account", cloud_provider_account,
 #endif
                       NULL);
+  g_object_set_data_full (G_OBJECT (row), "place-key", key, g_free);
+  g_object_set_data (G_OBJECT (row), "place-sequence", GUINT_TO_POINTER (sequence));
 
   eject_button = nautilus_gtk_sidebar_row_get_eject_button (NAUTILUS_GTK_SIDEBAR_ROW (row));
 
@@ -650,7 +833,7 @@ file_is_shown (NautilusGtkPlacesSidebar *sidebar,
        row != NULL && !found;
        row = gtk_widget_get_next_sibling (row))
     {
-      if (!GTK_IS_LIST_BOX_ROW (row))
+      if (!GTK_IS_LIST_BOX_ROW (row) || place_is_stale (sidebar, row))
         continue;
 
       g_object_get (row, "uri", &uri, NULL);
@@ -673,6 +856,33 @@ typedef struct
   guint position;
 } ShortcutData;
 
+static void
+add_application_shortcut (NautilusGtkPlacesSidebar *sidebar,
+                          GFile                    *file,
+                          GFileInfo                *info,
+                          guint                     pos)
+{
+  char *uri;
+  char *tooltip;
+  const char *name;
+  GIcon *start_icon;
+
+  name = g_file_info_get_display_name (info);
+  start_icon = g_file_info_get_symbolic_icon (info);
+  uri = g_file_get_uri (file);
+  tooltip = g_file_get_parse_name (file);
+
+  add_place (sidebar, NAUTILUS_GTK_PLACES_BUILT_IN,
+             NAUTILUS_GTK_PLACES_SECTION_COMPUTER,
+             name, start_icon, NULL, uri,
+             NULL, NULL, NULL, NULL,
+             pos,
+             tooltip);
+
+  g_free (uri);
+  g_free (tooltip);
+}
+
 static void
 on_app_shortcuts_query_complete (GObject      *source,
                                  GAsyncResult *result,
@@ -690,25 +900,11 @@ on_app_shortcuts_query_complete (GObject      *source,
 
   if (info)
     {
-      char *uri;
-      char *tooltip;
-      const char *name;
-      GIcon *start_icon;
-
-      name = g_file_info_get_display_name (info);
-      start_icon = g_file_info_get_symbolic_icon (info);
-      uri = g_file_get_uri (file);
-      tooltip = g_file_get_parse_name (file);
+      g_hash_table_insert (sidebar->place_infos,
+                           g_file_get_uri (file),
+                           g_object_ref (info));
 
-      add_place (sidebar, NAUTILUS_GTK_PLACES_BUILT_IN,
-                 NAUTILUS_GTK_PLACES_SECTION_COMPUTER,
-                 name, start_icon, NULL, uri,
-                 NULL, NULL, NULL, NULL,
-                 pos,
-                 tooltip);
-
-      g_free (uri);
-      g_free (tooltip);
+      add_application_shortcut (sidebar, file, info, pos);
 
       g_object_unref (info);
     }
@@ -724,12 +920,27 @@ add_application_shortcuts (NautilusGtkPlacesSidebar *sidebar)
     {
       GFile *file = g_list_model_get_item (G_LIST_MODEL (sidebar->shortcuts), i);
       ShortcutData *data;
+      GFileInfo *info;
+      char *uri;
 
       g_object_unref (file);
 
       if (file_is_shown (sidebar, file))
         continue;
 
+      uri = g_file_get_uri (file);
+      info = g_hash_table_lookup (sidebar->place_infos, uri);
+      if (info != NULL)
+        {
+          add_application_shortcut (sidebar, file, info, i);
+          g_free (uri);
+          continue;
+        }
+
+      keep_place (sidebar, NAUTILUS_GTK_PLACES_BUILT_IN,
+                  NAUTILUS_GTK_PLACES_SECTION_COMPUTER, i, uri);
+      g_free (uri);
+
       data = g_new (ShortcutData, 1);
       data->sidebar = sidebar;
       data->position = i;
@@ -750,24 +961,17 @@ typedef struct {
 } BookmarkQueryClosure;
 
 static void
-on_bookmark_query_info_complete (GObject      *source,
-                                 GAsyncResult *result,
-                                 gpointer      data)
+add_bookmark (NautilusGtkPlacesSidebar *sidebar,
+              GFile                    *root,
+              GFileInfo                *info,
+              int                       index,
+              gboolean                  is_native)
 {
-  BookmarkQueryClosure *clos = data;
-  NautilusGtkPlacesSidebar *sidebar = clos->sidebar;
-  GFile *root = G_FILE (source);
-  GError *error = NULL;
-  GFileInfo *info;
   char *bookmark_name;
   char *mount_uri;
   char *tooltip;
   GIcon *start_icon;
 
-  info = g_file_query_info_finish (root, result, &error);
-  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-    goto out;
-
   bookmark_name = _nautilus_gtk_bookmarks_manager_get_bookmark_label (sidebar->bookmarks_manager, root);
   if (bookmark_name == NULL && info != NULL)
     bookmark_name = g_strdup (g_file_info_get_display_name (info));
@@ -776,33 +980,58 @@ on_bookmark_query_info_complete (GObject      *source,
       /* Don't add non-UTF-8 bookmarks */
       bookmark_name = g_file_get_basename (root);
       if (bookmark_name == NULL)
-        goto out;
+        return;
 
       if (!g_utf8_validate (bookmark_name, -1, NULL))
         {
           g_free (bookmark_name);
-          goto out;
+          return;
         }
     }
 
   if (info)
     start_icon = g_object_ref (g_file_info_get_symbolic_icon (info));
   else
-    start_icon = g_themed_icon_new_with_default_fallbacks (clos->is_native ? ICON_NAME_FOLDER : ICON_NAME_FOLDER_NETWORK);
+    start_icon = g_themed_icon_new_with_default_fallbacks (is_native ? ICON_NAME_FOLDER : ICON_NAME_FOLDER_NETWORK);
 
   mount_uri = g_file_get_uri (root);
-  tooltip = clos->is_native ? g_file_get_path (root) : g_uri_unescape_string (mount_uri, NULL);
+  tooltip = is_native ? g_file_get_path (root) : g_uri_unescape_string (mount_uri, NULL);
 
   add_place (sidebar, NAUTILUS_GTK_PLACES_BOOKMARK,
              NAUTILUS_GTK_PLACES_SECTION_BOOKMARKS,
              bookmark_name, start_icon, NULL, mount_uri,
-             NULL, NULL, NULL, NULL, clos->index,
+             NULL, NULL, NULL, NULL, index,
              tooltip);
 
   g_free (mount_uri);
   g_free (tooltip);
   g_free (bookmark_name);
   g_object_unref (start_icon);
+}
+
+static void
+on_bookmark_query_info_complete (GObject      *source,
+                                 GAsyncResult *result,
+                                 gpointer      data)
+{
+  BookmarkQueryClosure *clos = data;
+  NautilusGtkPlacesSidebar *sidebar = clos->sidebar;
+  GFile *root = G_FILE (source);
+  GError *error = NULL;
+  GFileInfo *info;
+
+  info = g_file_query_info_finish (root, result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    goto out;
+
+  /* Failures aren't cached, e.g. a network bookmark can become
+   * reachable later on. */
+  if (info != NULL)
+    g_hash_table_insert (sidebar->place_infos,
+                         g_file_get_uri (root),
+                         g_object_ref (info));
+
+  add_bookmark (sidebar, root, info, clos->index, clos->is_native);
 
 out:
   g_clear_object (&info);
@@ -948,6 +1177,7 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
   GList *network_mounts, *network_volumes;
   GIcon *new_bookmark_icon;
   GtkWidget *child;
+  GHashTableIter iter;
 #ifdef HAVE_CLOUDPROVIDERS
   GList *cloud_providers;
   GList *cloud_providers_accounts;
@@ -970,8 +1200,21 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
   /* Reset drag state, just in case we update the places while dragging or
    * ending a drag */
   stop_drop_feedback (sidebar);
-  while ((child = gtk_widget_get_first_child (GTK_WIDGET (sidebar->list_box))))
-    gtk_list_box_remove (GTK_LIST_BOX (sidebar->list_box), child);
+
+  /* Instead of rebuilding the whole list, the rows of the places that are
+   * still there are updated in place, see add_place(). */
+  sidebar->stale_places = g_hash_table_new (g_str_hash, g_str_equal);
+  sidebar->n_places = 0;
+  sidebar->places_need_sort = FALSE;
+  for (child = gtk_widget_get_first_child (GTK_WIDGET (sidebar->list_box));
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      const char *key = g_object_get_data (G_OBJECT (child), "place-key");
+
+      if (key != NULL)
+        g_hash_table_insert (sidebar->stale_places, (gpointer) key, child);
+    }
 
   network_mounts = network_volumes = NULL;
 
@@ -1044,13 +1287,12 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
   if (sidebar->show_trash)
     {
       start_icon = nautilus_trash_monitor_get_symbolic_icon ();
-      sidebar->trash_row = add_place (sidebar, NAUTILUS_GTK_PLACES_BUILT_IN,
-                                      NAUTILUS_GTK_PLACES_SECTION_COMPUTER,
-                                      _("Trash"), start_icon, NULL, SCHEME_TRASH ":///",
-                                      NULL, NULL, NULL, NULL, 0,
-                                      _("Open Trash"));
-      g_object_add_weak_pointer (G_OBJECT (sidebar->trash_row),
-                                 (gpointer *) &sidebar->trash_row);
+      child = add_place (sidebar, NAUTILUS_GTK_PLACES_BUILT_IN,
+                         NAUTILUS_GTK_PLACES_SECTION_COMPUTER,
+                         _("Trash"), start_icon, NULL, SCHEME_TRASH ":///",
+                         NULL, NULL, NULL, NULL, 0,
+                         _("Open Trash"));
+      g_set_weak_pointer (&sidebar->trash_row, child);
       g_object_unref (start_icon);
     }
 
@@ -1339,6 +1581,8 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
     {
       gboolean is_native;
       BookmarkQueryClosure *clos;
+      GFileInfo *info;
+      char *uri;
 
       root = sl->data;
       is_native = g_file_is_native (root);
@@ -1346,6 +1590,19 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
       if (_nautilus_gtk_bookmarks_manager_get_is_builtin (sidebar->bookmarks_manager, root))
         continue;
 
+      uri = g_file_get_uri (root);
+      info = g_hash_table_lookup (sidebar->place_infos, uri);
+      if (info != NULL)
+        {
+          add_bookmark (sidebar, root, info, index, is_native);
+          g_free (uri);
+          continue;
+        }
+
+      keep_place (sidebar, NAUTILUS_GTK_PLACES_BOOKMARK,
+                  NAUTILUS_GTK_PLACES_SECTION_BOOKMARKS, index, uri);
+      g_free (uri);
+
       clos = g_slice_new (BookmarkQueryClosure);
       clos->sidebar = sidebar;
       clos->index = index;
@@ -1438,6 +1695,15 @@ update_places (NautilusGtkPlacesSidebar *sidebar)
       g_object_unref (start_icon);
     }
 
+  /* Remove the places that are gone */
+  g_hash_table_iter_init (&iter, sidebar->stale_places);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &child))
+    gtk_list_box_remove (GTK_LIST_BOX (sidebar->list_box), child);
+  g_clear_pointer (&sidebar->stale_places, g_hash_table_unref);
+
+  if (sidebar->places_need_sort)
+    gtk_list_box_invalidate_sort (GTK_LIST_BOX (sidebar->list_box));
+
   /* We want this hidden by default, but need to do it after the show_all call */
   nautilus_gtk_sidebar_row_hide (NAUTILUS_GTK_SIDEBAR_ROW (sidebar->new_bookmark_row), TRUE);
 
@@ -3685,6 +3951,16 @@ list_box_sort_func (GtkListBoxRow *row1,
         }
     }
 
+  if (retval == 0)
+    {
+      guint sequence_1, sequence_2;
+
+      sequence_1 = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row1), "place-sequence"));
+      sequence_2 = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row2), "place-sequence"));
+      if (sequence_1 != 0 && sequence_2 != 0)
+        retval = (sequence_1 > sequence_2) - (sequence_1 < sequence_2);
+    }
+
   g_free (label_1);
   g_free (label_2);
 
@@ -3749,6 +4025,16 @@ hostname_proxy_new_cb (GObject      *source_object,
   update_hostname (sidebar);
 }
 
+static void
+bookmarks_changed (gpointer data)
+{
+  NautilusGtkPlacesSidebar *sidebar = data;
+
+  /* Also refreshes the names and icons of the bookmarked locations */
+  g_hash_table_remove_all (sidebar->place_infos);
+  update_places (sidebar);
+}
+
 static void
 create_volume_monitor (NautilusGtkPlacesSidebar *sidebar)
 {
@@ -3816,12 +4102,14 @@ nautilus_gtk_places_sidebar_init (NautilusGtkPlacesSidebar *sidebar)
   sidebar->show_desktop = TRUE;
 
   sidebar->shortcuts = g_list_store_new (G_TYPE_FILE);
+  sidebar->place_infos = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, g_object_unref);
 
   create_volume_monitor (sidebar);
 
   sidebar->open_flags = NAUTILUS_GTK_PLACES_OPEN_NORMAL;
 
-  sidebar->bookmarks_manager = _nautilus_gtk_bookmarks_manager_new ((GtkBookmarksChangedFunc)update_places, sidebar);
+  sidebar->bookmarks_manager = _nautilus_gtk_bookmarks_manager_new (bookmarks_changed, sidebar);
 
   g_signal_connect_object (nautilus_trash_monitor_get (), "trash-state-changed",
                            G_CALLBACK (update_trash_icon), sidebar,
@@ -4083,6 +4371,7 @@ nautilus_gtk_places_sidebar_dispose (GObject *object)
   g_clear_object (&sidebar->current_location);
   g_clear_pointer (&sidebar->rename_uri, g_free);
   g_clear_object (&sidebar->shortcuts);
+  g_clear_pointer (&sidebar->place_infos, g_hash_table_unref);
 
   g_clear_handle_id (&sidebar->hover_timer_id, g_source_remove);
 
@@ -59,6 +59,7 @@
 #include "nautilus-scheme.h"
 #include "nautilus-shell-search-provider.h"
 #include "nautilus-signaller.h"
+#include "nautilus-stall-watchdog.h"
 #include "nautilus-tag-manager.h"
 #include "nautilus-tracker-utilities.h"
 #include "nautilus-trash-monitor.h"
@@ -235,6 +236,21 @@ menu_provider_init_callback (void)
     nautilus_module_extension_list_free (providers);
 }
 
+static void
+on_extensions_loaded (gpointer user_data)
+{
+    /* attach menu-provider module callback */
+    menu_provider_init_callback ();
+
+    /* When loaded late, let what is already shown pick up the extensions. */
+    if (g_getenv ("NAUTILUS_DEFER_EXTENSIONS") != NULL)
+    {
+        invalidate_extension_info_for_all_files_in_all_directories ();
+        g_signal_emit_by_name (nautilus_signaller_get_current (),
+                               "popup-menu-changed");
+    }
+}
+
 NautilusWindow *
 nautilus_application_create_window (NautilusApplication *self)
 {
@@ -1063,6 +1079,8 @@ on_application_shutdown (GApplication *application,
     g_list_free (notification_ids);
 
     nautilus_icon_info_clear_caches ();
+
+    nautilus_stall_watchdog_print_summary ();
 }
 
 static void
@@ -1133,10 +1151,7 @@ nautilus_application_startup (GApplication *app)
     nautilus_date_setup_preferences ();
 
     /* initialize nautilus modules */
-    nautilus_module_setup ();
-
-    /* attach menu-provider module callback */
-    menu_provider_init_callback ();
+    nautilus_module_setup_async (on_extensions_loaded, NULL);
 
     /* Initialize the UI handler singleton for file operations */
     priv->progress_handler = nautilus_progress_persistence_handler_new (G_OBJECT (self));
@@ -1342,6 +1357,17 @@ on_slot_removed (NautilusWindow      *window,
     g_signal_handlers_disconnect_by_func (slot, on_slot_location_changed, self);
 }
 
+static void
+on_window_is_active_changed (GtkWindow  *window,
+                             GParamSpec *pspec,
+                             gpointer    user_data)
+{
+    if (gtk_window_is_active (window))
+    {
+        invalidate_info_for_all_files_in_unwatched_directories ();
+    }
+}
+
 static void
 nautilus_application_window_added (GtkApplication *app,
                                    GtkWindow      *window)
@@ -1357,6 +1383,8 @@ nautilus_application_window_added (GtkApplication *app,
         priv->windows = g_list_prepend (priv->windows, window);
         g_signal_connect (window, "slot-added", G_CALLBACK (on_slot_added), app);
         g_signal_connect (window, "slot-removed", G_CALLBACK (on_slot_removed), app);
+        g_signal_connect (window, "notify::is-active",
+                          G_CALLBACK (on_window_is_active_changed), app);
     }
 }
 
@@ -1376,6 +1404,7 @@ nautilus_application_window_removed (GtkApplication *app,
         priv->windows = g_list_remove_all (priv->windows, window);
         g_signal_handlers_disconnect_by_func (window, on_slot_added, app);
         g_signal_handlers_disconnect_by_func (window, on_slot_removed, app);
+        g_signal_handlers_disconnect_by_func (window, on_window_is_active_changed, app);
     }
 
     /* if this was the last window, close the previewer */
@@ -656,10 +656,8 @@ select_nth_conflict (NautilusBatchRenameDialog *dialog)
     GList *l;
     GString *conflict_file_name;
     GString *display_text;
-    GString *new_name;
     gint nth_conflict_index;
     gint nth_conflict;
-    gint name_occurences;
     GtkAdjustment *adjustment;
     ConflictData *conflict_data;
     GtkListBoxRow *list_box_row;
@@ -693,16 +691,7 @@ select_nth_conflict (NautilusBatchRenameDialog *dialog)
     adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (dialog->scrolled_window));
     gtk_adjustment_set_value (adjustment, (gtk_widget_get_height (GTK_WIDGET (l->data)) + 1) * nth_conflict_index);
 
-    name_occurences = 0;
-    for (l = dialog->new_names; l != NULL; l = l->next)
-    {
-        new_name = l->data;
-        if (g_string_equal (new_name, conflict_file_name))
-        {
-            name_occurences++;
-        }
-    }
-    if (name_occurences > 1)
+    if (conflict_data->is_duplicate)
     {
         g_string_append_printf (display_text,
                                 _("“%s” would not be a unique new name."),
@@ -873,7 +862,7 @@ update_listbox (NautilusBatchRenameDialog *dialog)
 
         gtk_widget_set_sensitive (dialog->conflict_up, FALSE);
 
-        if (g_list_length (dialog->duplicates) == 1)
+        if (dialog->conflicts_number == 1)
         {
             gtk_widget_set_sensitive (dialog->conflict_down, FALSE);
         }
@@ -906,135 +895,14 @@ update_listbox (NautilusBatchRenameDialog *dialog)
     }
 }
 
-static void
-check_conflict_for_files (NautilusBatchRenameDialog *dialog,
-                          NautilusDirectory         *directory,
-                          GList                     *files)
+static gint
+compare_conflicts_by_index (gconstpointer a,
+                            gconstpointer b)
 {
-    gchar *current_directory;
-    gchar *parent_uri;
-    GString *file_name;
-    GList *l1, *l2;
-    GHashTable *directory_files_table;
-    GHashTable *new_names_table;
-    GHashTable *names_conflicts_table;
-    gboolean exists;
-    gboolean have_conflict;
-    gboolean tag_present;
-    gboolean same_parent_directory;
-    ConflictData *conflict_data;
-
-    current_directory = nautilus_directory_get_uri (directory);
-
-    directory_files_table = g_hash_table_new_full (g_str_hash,
-                                                   g_str_equal,
-                                                   (GDestroyNotify) g_free,
-                                                   NULL);
-    new_names_table = g_hash_table_new_full (g_str_hash,
-                                             g_str_equal,
-                                             (GDestroyNotify) g_free,
-                                             (GDestroyNotify) g_free);
-    names_conflicts_table = g_hash_table_new_full (g_str_hash,
-                                                   g_str_equal,
-                                                   (GDestroyNotify) g_free,
-                                                   (GDestroyNotify) g_free);
-
-    /* names_conflicts_table is used for knowing which names from the list are not unique,
-     * so that they can easily be reached when needed */
-    for (l1 = dialog->new_names, l2 = dialog->selection;
-         l1 != NULL && l2 != NULL;
-         l1 = l1->next, l2 = l2->next)
-    {
-        GString *new_name = l1->data;
-        NautilusFile *file = NAUTILUS_FILE (l2->data);
-        parent_uri = nautilus_file_get_parent_uri (file);
-
-        tag_present = g_hash_table_lookup (new_names_table, new_name->str) != NULL;
-        same_parent_directory = g_strcmp0 (parent_uri, current_directory) == 0;
-
-        if (same_parent_directory)
-        {
-            if (!tag_present)
-            {
-                g_hash_table_insert (new_names_table,
-                                     g_strdup (new_name->str),
-                                     nautilus_file_get_parent_uri (file));
-            }
-            else
-            {
-                g_hash_table_insert (names_conflicts_table,
-                                     g_strdup (new_name->str),
-                                     nautilus_file_get_parent_uri (file));
-            }
-        }
-
-        g_free (parent_uri);
-    }
-
-    for (l1 = files; l1 != NULL; l1 = l1->next)
-    {
-        NautilusFile *file = NAUTILUS_FILE (l1->data);
-        g_hash_table_insert (directory_files_table,
-                             g_strdup (nautilus_file_get_name (file)),
-                             GINT_TO_POINTER (TRUE));
-    }
-
-    for (l1 = dialog->selection, l2 = dialog->new_names; l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next)
-    {
-        NautilusFile *file = NAUTILUS_FILE (l1->data);
-        GString *new_name = l2->data;
-
-        file_name = g_string_new (nautilus_file_get_name (file));
-
-        parent_uri = nautilus_file_get_parent_uri (file);
-
-        have_conflict = FALSE;
-
-        /* check for duplicate only if the parent of the current file is
-         * the current directory and the name of the file has changed */
-        if (g_strcmp0 (parent_uri, current_directory) == 0 &&
-            !g_string_equal (new_name, file_name))
-        {
-            exists = GPOINTER_TO_INT (g_hash_table_lookup (directory_files_table, new_name->str));
-
-            if (exists == TRUE &&
-                !file_name_conflicts_with_results (dialog->selection, dialog->new_names, new_name, parent_uri))
-            {
-                conflict_data = g_new (ConflictData, 1);
-                conflict_data->name = g_strdup (new_name->str);
-                conflict_data->index = g_list_index (dialog->selection, l1->data);
-                dialog->duplicates = g_list_prepend (dialog->duplicates,
-                                                     conflict_data);
-
-                have_conflict = TRUE;
-            }
-        }
-
-        if (!have_conflict)
-        {
-            tag_present = g_hash_table_lookup (names_conflicts_table, new_name->str) != NULL;
-            same_parent_directory = g_strcmp0 (parent_uri, current_directory) == 0;
-
-            if (tag_present && same_parent_directory)
-            {
-                conflict_data = g_new (ConflictData, 1);
-                conflict_data->name = g_strdup (new_name->str);
-                conflict_data->index = g_list_index (dialog->selection, l1->data);
-                dialog->duplicates = g_list_prepend (dialog->duplicates,
-                                                     conflict_data);
-
-                have_conflict = TRUE;
-            }
-        }
-
-        g_string_free (file_name, TRUE);
-        g_free (parent_uri);
-    }
+    const ConflictData *conflict_a = a;
+    const ConflictData *conflict_b = b;
 
-    g_free (current_directory);
-    g_hash_table_destroy (directory_files_table);
-    g_hash_table_destroy (new_names_table);
-    g_hash_table_destroy (names_conflicts_table);
+    return conflict_a->index - conflict_b->index;
 }
 
 static void
@@ -1046,7 +914,11 @@ on_directory_attributes_ready_for_conflicts_check (NautilusDirectory *conflict_d
 
     self = NAUTILUS_BATCH_RENAME_DIALOG (callback_data);
 
-    check_conflict_for_files (self, conflict_directory, files);
+    self->duplicates = g_list_concat (batch_rename_get_conflicts_in_directory (conflict_directory,
+                                                                               files,
+                                                                               self->selection,
+                                                                               self->new_names),
+                                      self->duplicates);
 
     g_assert (g_list_find (self->directories_pending_conflict_check, conflict_directory) != NULL);
 
@@ -1056,7 +928,8 @@ on_directory_attributes_ready_for_conflicts_check (NautilusDirectory *conflict_d
 
     if (self->directories_pending_conflict_check == NULL)
     {
-        self->duplicates = g_list_reverse (self->duplicates);
+        /* Rows are highlighted by walking the conflicts in selection order. */
+        self->duplicates = g_list_sort (self->duplicates, compare_conflicts_by_index);
 
         update_listbox (self);
     }
@@ -210,6 +210,8 @@ typedef struct
 {
     gchar *name;
     gint index;
+    /* Whether other files would get the same new name. */
+    gboolean is_duplicate;
 } ConflictData;
 
 typedef struct {
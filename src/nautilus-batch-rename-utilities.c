@@ -537,45 +537,93 @@ batch_rename_dialog_get_new_names_list (NautilusBatchRenameDialogMode  mode,
 /* There is a case that a new name for a file conflicts with an existing file name
  * in the directory but it's not a problem because the file in the directory that
  * conflicts is part of the batch renaming selection and it's going to change the name anyway. */
-gboolean
-file_name_conflicts_with_results (GList   *selection,
-                                  GList   *new_names,
-                                  GString *old_name,
-                                  gchar   *parent_uri)
+GList *
+batch_rename_get_conflicts_in_directory (NautilusDirectory *directory,
+                                         GList             *directory_files,
+                                         GList             *selection,
+                                         GList             *new_names)
 {
-    GList *l1;
-    GList *l2;
-    GString *new_name;
+    g_autoptr (GHashTable) directory_names = NULL;
+    g_autoptr (GHashTable) renamed_names = NULL;
+    g_autoptr (GHashTable) new_names_count = NULL;
+    GList *conflicts = NULL;
+    GList *l1, *l2;
+    gint index;
+
+    /* All lookups below are done on borrowed strings, which stay valid for
+     * as long as the files and the new names list are alive. */
+    directory_names = g_hash_table_new (g_str_hash, g_str_equal);
+    renamed_names = g_hash_table_new (g_str_hash, g_str_equal);
+    new_names_count = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (l1 = directory_files; l1 != NULL; l1 = l1->next)
+    {
+        g_hash_table_add (directory_names,
+                          (gpointer) nautilus_file_get_name (NAUTILUS_FILE (l1->data)));
+    }
 
     for (l1 = selection, l2 = new_names; l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next)
     {
-        NautilusFile *selection_file = NAUTILUS_FILE (l1->data);
-        const char *name1 = nautilus_file_get_name (selection_file);
-        g_autofree gchar *selection_parent_uri = NULL;
+        NautilusFile *file = NAUTILUS_FILE (l1->data);
+        GString *new_name = l2->data;
+        guint count;
 
-        selection_parent_uri = nautilus_file_get_parent_uri (selection_file);
+        if (nautilus_file_get_directory (file) != directory)
+        {
+            continue;
+        }
+
+        g_hash_table_insert (renamed_names,
+                             (gpointer) nautilus_file_get_name (file),
+                             new_name);
+
+        count = GPOINTER_TO_UINT (g_hash_table_lookup (new_names_count, new_name->str));
+        g_hash_table_insert (new_names_count, new_name->str, GUINT_TO_POINTER (count + 1));
+    }
+
+    for (l1 = selection, l2 = new_names, index = 0;
+         l1 != NULL && l2 != NULL;
+         l1 = l1->next, l2 = l2->next, index++)
+    {
+        NautilusFile *file = NAUTILUS_FILE (l1->data);
+        GString *new_name = l2->data;
+        gboolean is_duplicate;
+        gboolean have_conflict;
 
-        if (g_strcmp0 (name1, old_name->str) == 0)
+        if (nautilus_file_get_directory (file) != directory)
         {
-            new_name = l2->data;
+            continue;
+        }
 
-            /* if the name didn't change, then there's a conflict */
-            if (g_string_equal (old_name, new_name) &&
-                (parent_uri == NULL || g_strcmp0 (parent_uri, selection_parent_uri) == 0))
-            {
-                return FALSE;
-            }
+        is_duplicate = GPOINTER_TO_UINT (g_hash_table_lookup (new_names_count, new_name->str)) > 1;
+        have_conflict = is_duplicate;
+
+        if (!have_conflict &&
+            g_strcmp0 (new_name->str, nautilus_file_get_name (file)) != 0 &&
+            g_hash_table_contains (directory_names, new_name->str))
+        {
+            GString *existing_new_name;
 
+            /* An existing file with that name is only in the way if it is not
+             * being renamed itself. */
+            existing_new_name = g_hash_table_lookup (renamed_names, new_name->str);
+            have_conflict = existing_new_name == NULL ||
+                            g_string_equal (existing_new_name, new_name);
+        }
+
+        if (have_conflict)
+        {
+            ConflictData *conflict_data;
 
-            /* if this file exists and it changed it's name, then there's no
-             * conflict */
-            return TRUE;
+            conflict_data = g_new (ConflictData, 1);
+            conflict_data->name = g_strdup (new_name->str);
+            conflict_data->index = index;
+            conflict_data->is_duplicate = is_duplicate;
+            conflicts = g_list_prepend (conflicts, conflict_data);
         }
     }
 
-    /* the case this function searched for doesn't exist, so the file
-     * has a conlfict */
-    return FALSE;
+    return g_list_reverse (conflicts);
 }
 
 static gint
@@ -1137,22 +1185,28 @@ check_metadata_for_selection (NautilusBatchRenameDialog *dialog,
 GList *
 batch_rename_files_get_distinct_parents (GList *selection)
 {
+    g_autoptr (GHashTable) seen = NULL;
     GList *result;
     GList *l1;
     NautilusFile *file;
     NautilusDirectory *directory;
     NautilusFile *parent;
 
+    seen = g_hash_table_new (NULL, NULL);
     result = NULL;
     for (l1 = selection; l1 != NULL; l1 = l1->next)
     {
         file = NAUTILUS_FILE (l1->data);
         parent = nautilus_file_get_parent (file);
         directory = nautilus_directory_get_for_file (parent);
-        if (!g_list_find (result, directory))
+        if (g_hash_table_add (seen, directory))
         {
             result = g_list_prepend (result, directory);
         }
+        else
+        {
+            nautilus_directory_unref (directory);
+        }
 
         nautilus_file_unref (parent);
     }
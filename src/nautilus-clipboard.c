@@ -33,7 +33,11 @@
 #include <gtk/gtk.h>
 #include <string.h>
 
-/* The .files member contains elements of type NautilusFile. */
+/* The .files member contains elements of type NautilusFile.
+ *
+ * A clipboard value is never modified once created, so it is shared by
+ * reference rather than copied: every read of the clipboard, and every view
+ * updating its cut files, gets the same files without walking them. */
 struct _NautilusClipboard
 {
     gboolean cut;
@@ -44,6 +48,23 @@ struct _NautilusClipboard
 G_DEFINE_BOXED_TYPE (NautilusClipboard, nautilus_clipboard,
                      nautilus_clipboard_copy, nautilus_clipboard_free)
 
+/* Offers a NautilusClipboard as itself and as a GDK_TYPE_FILE_LIST, which is
+ * also what text/uri-list is serialized from. Unlike a typed provider, the
+ * file list is only built if it is asked for, e.g. by another application
+ * pasting or by a drop, and the clipboard value is not copied when read. */
+#define NAUTILUS_TYPE_CLIPBOARD_PROVIDER (nautilus_clipboard_provider_get_type ())
+G_DECLARE_FINAL_TYPE (NautilusClipboardProvider, nautilus_clipboard_provider, NAUTILUS, CLIPBOARD_PROVIDER, GdkContentProvider)
+
+struct _NautilusClipboardProvider
+{
+    GdkContentProvider parent_instance;
+    NautilusClipboard *clip;
+    /* Drags only offer the file list, of the activation locations */
+    gboolean for_drag;
+};
+
+G_DEFINE_TYPE (NautilusClipboardProvider, nautilus_clipboard_provider, GDK_TYPE_CONTENT_PROVIDER)
+
 static char *
 nautilus_clipboard_to_string (NautilusClipboard *clip)
 {
@@ -105,7 +126,7 @@ nautilus_clipboard_from_string (char    *string,
         files = g_list_prepend (files, nautilus_file_get_by_uri (lines[i]));
     }
 
-    clip = g_new0 (NautilusClipboard, 1);
+    clip = g_atomic_rc_box_new0 (NautilusClipboard);
     files = g_list_reverse (files);
     clip->files = g_steal_pointer (&files);
     clip->cut = g_str_equal (lines[0], "cut");
@@ -121,7 +142,7 @@ nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
     GdkContentFormats *formats = gdk_clipboard_get_formats (clipboard);
     g_auto (GValue) value = G_VALUE_INIT;
     NautilusClipboard *nautilus_clipboard;
-    GList *clipboard_item_uris;
+    g_autoptr (GHashTable) clipboard_item_uris = NULL;
 
     if (!gdk_clipboard_is_local (clipboard) ||
         !gdk_content_formats_contain_gtype (formats, NAUTILUS_TYPE_CLIPBOARD))
@@ -135,19 +156,20 @@ nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
         return;
     }
     nautilus_clipboard = g_value_get_boxed (&value);
-    clipboard_item_uris = nautilus_clipboard_get_uri_list (nautilus_clipboard);
+    clipboard_item_uris = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    for (GList *l = nautilus_clipboard->files; l != NULL; l = l->next)
+    {
+        g_hash_table_add (clipboard_item_uris, nautilus_file_get_uri (l->data));
+    }
 
     for (GList *l = (GList *) item_uris; l != NULL; l = l->next)
     {
-        if (g_list_find_custom ((GList *) clipboard_item_uris, l->data,
-                                (GCompareFunc) g_strcmp0))
+        if (g_hash_table_contains (clipboard_item_uris, l->data))
         {
             gdk_clipboard_set_content (clipboard, NULL);
             break;
         }
     }
-
-    g_list_free_full (clipboard_item_uris, g_free);
 }
 
 /*
@@ -155,17 +177,169 @@ nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
  * As of writing this, the API docs don't provide for this assumption.
  */
 static GSList *
-convert_file_list_to_gdk_file_list (NautilusClipboard *clip)
+convert_file_list_to_gdk_file_list (NautilusClipboard *clip,
+                                    gboolean           activation_locations)
 {
     GSList *file_list = NULL;
     for (GList *l = clip->files; l != NULL; l = l->next)
     {
         file_list = g_slist_prepend (file_list,
+                                     activation_locations ?
+                                     nautilus_file_get_activation_location (l->data) :
                                      nautilus_file_get_location (l->data));
     }
     return g_slist_reverse (file_list);
 }
 
+static GdkContentFormats *
+nautilus_clipboard_provider_ref_formats (GdkContentProvider *provider)
+{
+    NautilusClipboardProvider *self = NAUTILUS_CLIPBOARD_PROVIDER (provider);
+    GdkContentFormatsBuilder *builder = gdk_content_formats_builder_new ();
+    g_autoptr (GdkContentFormats) formats = NULL;
+
+    if (!self->for_drag)
+    {
+        gdk_content_formats_builder_add_gtype (builder, NAUTILUS_TYPE_CLIPBOARD);
+    }
+    gdk_content_formats_builder_add_gtype (builder, GDK_TYPE_FILE_LIST);
+    formats = gdk_content_formats_builder_free_to_formats (builder);
+
+    return gdk_content_formats_union_serialize_mime_types (g_steal_pointer (&formats));
+}
+
+static gboolean
+nautilus_clipboard_provider_get_value (GdkContentProvider  *provider,
+                                       GValue              *value,
+                                       GError             **error)
+{
+    NautilusClipboardProvider *self = NAUTILUS_CLIPBOARD_PROVIDER (provider);
+
+    if (G_VALUE_HOLDS (value, NAUTILUS_TYPE_CLIPBOARD) && !self->for_drag)
+    {
+        g_value_set_boxed (value, self->clip);
+        return TRUE;
+    }
+    else if (G_VALUE_HOLDS (value, GDK_TYPE_FILE_LIST))
+    {
+        g_value_take_boxed (value,
+                            convert_file_list_to_gdk_file_list (self->clip, self->for_drag));
+        return TRUE;
+    }
+
+    return GDK_CONTENT_PROVIDER_CLASS (nautilus_clipboard_provider_parent_class)->get_value (provider, value, error);
+}
+
+static void
+nautilus_clipboard_provider_write_done (GObject      *source_object,
+                                        GAsyncResult *result,
+                                        gpointer      user_data)
+{
+    g_autoptr (GTask) task = user_data;
+    GError *error = NULL;
+
+    if (!gdk_content_serialize_finish (result, &error))
+    {
+        g_task_return_error (task, error);
+    }
+    else
+    {
+        g_task_return_boolean (task, TRUE);
+    }
+}
+
+static void
+nautilus_clipboard_provider_write_mime_type_async (GdkContentProvider  *provider,
+                                                   const char          *mime_type,
+                                                   GOutputStream       *stream,
+                                                   int                  io_priority,
+                                                   GCancellable        *cancellable,
+                                                   GAsyncReadyCallback  callback,
+                                                   gpointer             user_data)
+{
+    NautilusClipboardProvider *self = NAUTILUS_CLIPBOARD_PROVIDER (provider);
+    g_autoptr (GdkContentFormats) clipboard_formats = NULL;
+    g_auto (GValue) value = G_VALUE_INIT;
+    GTask *task;
+
+    task = g_task_new (provider, cancellable, callback, user_data);
+    g_task_set_priority (task, io_priority);
+    g_task_set_source_tag (task, nautilus_clipboard_provider_write_mime_type_async);
+
+    clipboard_formats = gdk_content_formats_new_for_gtype (NAUTILUS_TYPE_CLIPBOARD);
+    clipboard_formats = gdk_content_formats_union_serialize_mime_types (g_steal_pointer (&clipboard_formats));
+
+    if (!self->for_drag &&
+        gdk_content_formats_contain_mime_type (clipboard_formats, mime_type))
+    {
+        g_value_init (&value, NAUTILUS_TYPE_CLIPBOARD);
+    }
+    else
+    {
+        g_value_init (&value, GDK_TYPE_FILE_LIST);
+    }
+
+    nautilus_clipboard_provider_get_value (provider, &value, NULL);
+    gdk_content_serialize_async (stream, mime_type, &value,
+                                 io_priority, cancellable,
+                                 nautilus_clipboard_provider_write_done,
+                                 task);
+}
+
+static gboolean
+nautilus_clipboard_provider_write_mime_type_finish (GdkContentProvider  *provider,
+                                                    GAsyncResult        *result,
+                                                    GError             **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, provider), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+nautilus_clipboard_provider_finalize (GObject *object)
+{
+    NautilusClipboardProvider *self = NAUTILUS_CLIPBOARD_PROVIDER (object);
+
+    nautilus_clipboard_free (self->clip);
+
+    G_OBJECT_CLASS (nautilus_clipboard_provider_parent_class)->finalize (object);
+}
+
+static void
+nautilus_clipboard_provider_class_init (NautilusClipboardProviderClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    GdkContentProviderClass *provider_class = GDK_CONTENT_PROVIDER_CLASS (klass);
+
+    object_class->finalize = nautilus_clipboard_provider_finalize;
+
+    provider_class->ref_formats = nautilus_clipboard_provider_ref_formats;
+    provider_class->get_value = nautilus_clipboard_provider_get_value;
+    provider_class->write_mime_type_async = nautilus_clipboard_provider_write_mime_type_async;
+    provider_class->write_mime_type_finish = nautilus_clipboard_provider_write_mime_type_finish;
+}
+
+static void
+nautilus_clipboard_provider_init (NautilusClipboardProvider *self)
+{
+}
+
+static GdkContentProvider *
+nautilus_clipboard_provider_new (GList    *files,
+                                 gboolean  cut,
+                                 gboolean  for_drag)
+{
+    NautilusClipboardProvider *self = g_object_new (NAUTILUS_TYPE_CLIPBOARD_PROVIDER, NULL);
+
+    self->clip = g_atomic_rc_box_new0 (NautilusClipboard);
+    self->clip->cut = cut;
+    self->clip->files = files;
+    self->for_drag = for_drag;
+
+    return GDK_CONTENT_PROVIDER (self);
+}
+
 static void
 nautilus_clipboard_serialize (GdkContentSerializer *serializer)
 {
@@ -282,47 +456,55 @@ nautilus_clipboard_is_cut (NautilusClipboard *clip)
     return clip->cut;
 }
 
+/* Clipboard values are immutable, so a copy is a new reference. */
 NautilusClipboard *
 nautilus_clipboard_copy (NautilusClipboard *clip)
 {
-    NautilusClipboard *new_clip = g_new0 (NautilusClipboard, 1);
-
-    new_clip->cut = clip->cut;
-    new_clip->files = nautilus_file_list_copy (clip->files);
+    return g_atomic_rc_box_acquire (clip);
+}
 
-    return new_clip;
+static void
+nautilus_clipboard_clear (NautilusClipboard *clip)
+{
+    nautilus_file_list_free (clip->files);
 }
 
 void
 nautilus_clipboard_free (NautilusClipboard *clip)
 {
-    nautilus_file_list_free (clip->files);
-    g_free (clip);
+    g_atomic_rc_box_release_full (clip, (GDestroyNotify) nautilus_clipboard_clear);
 }
 
+/**
+ * nautilus_clipboard_prepare_for_files:
+ * @clipboard: The clipboard to set.
+ * @files: (transfer full): A GList of NautilusFile to cut or copy.
+ * @cut: Whether the files are cut.
+ */
 void
 nautilus_clipboard_prepare_for_files (GdkClipboard *clipboard,
                                       GList        *files,
                                       gboolean      cut)
 {
-    g_autoptr (NautilusClipboard) clip = NULL;
-    g_autoslist (GFile) file_list = NULL;
-    GdkContentProvider *providers[2];
     g_autoptr (GdkContentProvider) provider = NULL;
 
-    clip = g_new (NautilusClipboard, 1);
-    clip->cut = cut;
-    clip->files = nautilus_file_list_copy (files);
-
-    file_list = convert_file_list_to_gdk_file_list (clip);
-
-    providers[0] = gdk_content_provider_new_typed (NAUTILUS_TYPE_CLIPBOARD, clip);
-    providers[1] = gdk_content_provider_new_typed (GDK_TYPE_FILE_LIST, file_list);
-
-    provider = gdk_content_provider_new_union (providers, 2);
+    provider = nautilus_clipboard_provider_new (files, cut, FALSE);
     gdk_clipboard_set_content (clipboard, provider);
 }
 
+/**
+ * nautilus_clipboard_new_drag_content:
+ * @files: (transfer full): A GList of NautilusFile being dragged.
+ *
+ * Returns: (transfer full): A content provider offering the activation
+ * locations of @files as a GDK_TYPE_FILE_LIST.
+ */
+GdkContentProvider *
+nautilus_clipboard_new_drag_content (GList *files)
+{
+    return nautilus_clipboard_provider_new (files, FALSE, TRUE);
+}
+
 void
 nautilus_clipboard_register (void)
 {
@@ -41,5 +41,6 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC (NautilusClipboard, nautilus_clipboard_free)
 void nautilus_clipboard_prepare_for_files (GdkClipboard *clipboard,
                                            GList        *files,
                                            gboolean      cut);
+GdkContentProvider *nautilus_clipboard_new_drag_content (GList *files);
 
 void               nautilus_clipboard_register     (void);
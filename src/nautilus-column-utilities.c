@@ -244,6 +244,10 @@ nautilus_get_common_columns (void)
 
     if (!columns)
     {
+        /* The list is only built once, so it can't miss the columns of
+         * extensions whose loading was deferred. */
+        nautilus_module_setup ();
+
         columns = g_list_concat (get_builtin_columns (),
                                  get_extension_columns ());
     }
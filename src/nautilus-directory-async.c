@@ -32,6 +32,8 @@
 #include "nautilus-global-preferences.h"
 #include "nautilus-metadata.h"
 #include "nautilus-signaller.h"
+#include "nautilus-stall-watchdog.h"
+#include "nautilus-trace.h"
 
 /* turn this on to check if async. job calls are balanced */
 #if 0
@@ -40,14 +42,24 @@
 
 #define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
 
+/* Local enumeration is cheap per item, so the cost of loading a large
+ * directory is dominated by the thread round trips. Use bigger batches. */
+#define DIRECTORY_LOAD_NATIVE_ITEMS_PER_CALLBACK 1000
+
 /* Keep async. jobs down to this number for all directories. */
 #define MAX_ASYNC_JOBS 10
 
+/* Deep counts are slow, so several files of the same directory are counted
+ * at once (e.g. for a properties window on many folders), up to this number.
+ */
+#define MAX_DEEP_COUNTS_PER_DIRECTORY 4
+
 struct ThumbnailState
 {
     NautilusDirectory *directory;
     GCancellable *cancellable;
     NautilusFile *file;
+    gint64 trace_start;
 };
 
 struct MountState
@@ -64,6 +76,14 @@ struct FilesystemInfoState
     NautilusFile *file;
 };
 
+struct MetadataState
+{
+    NautilusDirectory *directory;
+    GCancellable *cancellable;
+    GFileEnumerator *enumerator;
+    int items_per_callback;
+};
+
 struct DirectoryLoadState
 {
     NautilusDirectory *directory;
@@ -71,6 +91,8 @@ struct DirectoryLoadState
     GFileEnumerator *enumerator;
     NautilusFile *load_directory_file;
     int load_file_count;
+    int items_per_callback;
+    NautilusFileAttributes deferred_attributes;
 };
 
 struct GetInfoState
@@ -98,11 +120,12 @@ struct DirectoryCountState
 struct DeepCountState
 {
     NautilusDirectory *directory;
+    NautilusFile *file;
     GCancellable *cancellable;
     GFileEnumerator *enumerator;
     GFile *deep_count_location;
     GList *deep_count_subdirectories;
-    GArray *seen_deep_count_inodes;
+    GHashTable *seen_deep_count_inodes; /* set of guint64 * */
     char *fs_id;
 };
 
@@ -159,6 +182,7 @@ static gboolean request_is_satisfied (NautilusDirectory *directory,
                                       Request            request);
 static void     cancel_loading_attributes (NautilusDirectory     *directory,
                                            NautilusFileAttributes file_attributes);
+static void     metadata_cancel (NautilusDirectory *directory);
 static void     add_all_files_to_work_queue (NautilusDirectory *directory);
 static void     move_file_to_low_priority_queue (NautilusDirectory *directory,
                                                  NautilusFile      *file);
@@ -414,21 +438,31 @@ directory_count_cancel (NautilusDirectory *directory)
 }
 
 static void
-deep_count_cancel (NautilusDirectory *directory)
+deep_count_cancel_one (NautilusDirectory *directory,
+                       DeepCountState    *state)
 {
-    if (directory->details->deep_count_in_progress != NULL)
-    {
-        g_assert (NAUTILUS_IS_FILE (directory->details->deep_count_file));
+    g_cancellable_cancel (state->cancellable);
 
-        g_cancellable_cancel (directory->details->deep_count_in_progress->cancellable);
+    if (state->file != NULL)
+    {
+        g_assert (NAUTILUS_IS_FILE (state->file));
+        state->file->details->deep_counts_status = NAUTILUS_REQUEST_NOT_STARTED;
+    }
 
-        directory->details->deep_count_file->details->deep_counts_status = NAUTILUS_REQUEST_NOT_STARTED;
+    directory->details->deep_counts_in_progress = g_list_remove (directory->details->deep_counts_in_progress,
+                                                                 state);
+    state->directory = NULL;
+    state->file = NULL;
 
-        directory->details->deep_count_in_progress->directory = NULL;
-        directory->details->deep_count_in_progress = NULL;
-        directory->details->deep_count_file = NULL;
+    async_job_end (directory, "deep count");
+}
 
-        async_job_end (directory, "deep count");
+static void
+deep_count_cancel (NautilusDirectory *directory)
+{
+    while (directory->details->deep_counts_in_progress != NULL)
+    {
+        deep_count_cancel_one (directory, directory->details->deep_counts_in_progress->data);
     }
 }
 
@@ -667,6 +701,17 @@ nautilus_directory_set_up_request (NautilusFileAttributes file_attributes)
         REQUEST_SET_TYPE (request, REQUEST_FILESYSTEM_INFO);
     }
 
+    if (file_attributes & NAUTILUS_FILE_ATTRIBUTE_METADATA)
+    {
+        REQUEST_SET_TYPE (request, REQUEST_METADATA);
+    }
+
+    if (file_attributes & NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO)
+    {
+        REQUEST_SET_TYPE (request, REQUEST_EXTENDED_INFO);
+        REQUEST_SET_TYPE (request, REQUEST_FILE_INFO);
+    }
+
     return request;
 }
 
@@ -725,7 +770,12 @@ nautilus_directory_monitor_add_internal (NautilusDirectory         *directory,
      */
     if (directory->details->monitor == NULL)
     {
-        directory->details->monitor = nautilus_monitor_directory (directory->details->location);
+        directory->details->monitor = nautilus_monitor_directory (directory->details->location,
+                                                                  file == NULL);
+    }
+    else if (file == NULL)
+    {
+        nautilus_monitor_watch_file_list (directory->details->monitor);
     }
 
 
@@ -845,6 +895,8 @@ dequeue_pending_idle_callback (gpointer callback_data)
     GFileInfo *file_info;
     const char *name;
     DirectoryLoadState *dir_load_state;
+    gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+    gint64 watchdog_start = nautilus_stall_watchdog_begin ();
 
     directory = NAUTILUS_DIRECTORY (callback_data);
 
@@ -946,6 +998,8 @@ dequeue_pending_idle_callback (gpointer callback_data)
     nautilus_directory_emit_change_signals (directory, changed_files);
     nautilus_file_list_free (changed_files);
     nautilus_directory_emit_files_added (directory, added_files);
+    nautilus_trace_counter_add (NAUTILUS_TRACE_COUNTER_FILES_LOADED,
+                                g_list_length (added_files));
     nautilus_file_list_free (added_files);
 
     if (directory->details->directory_loaded &&
@@ -975,6 +1029,10 @@ dequeue_pending_idle_callback (gpointer callback_data)
     notify_files_changed_while_being_added (directory);
 
 drain:
+    nautilus_trace_mark_printf (trace_start, "dequeue-pending-idle",
+                                "%u files", g_list_length (pending_file_info));
+    nautilus_stall_watchdog_end (watchdog_start, "dequeue_pending_idle_callback",
+                                 g_list_length (pending_file_info));
     g_list_free_full (pending_file_info, g_object_unref);
 
     /* Get the state machine running again. */
@@ -1576,10 +1634,15 @@ nautilus_async_destroying_file (NautilusFile *file)
         directory->details->count_in_progress->count_file = NULL;
         changed = TRUE;
     }
-    if (directory->details->deep_count_file == file)
+    for (GList *l = directory->details->deep_counts_in_progress; l != NULL; l = l->next)
     {
-        directory->details->deep_count_file = NULL;
-        changed = TRUE;
+        DeepCountState *state = l->data;
+
+        if (state->file == file)
+        {
+            state->file = NULL;
+            changed = TRUE;
+        }
     }
     if (directory->details->get_info_file == file)
     {
@@ -1647,6 +1710,21 @@ lacks_filesystem_info (NautilusFile *file)
     return !file->details->filesystem_info_is_up_to_date;
 }
 
+static gboolean
+lacks_metadata (NautilusFile *file)
+{
+    return file->details->metadata_is_deferred
+           && !file->details->is_gone
+           && file->details->directory->details->metadata_deferred;
+}
+
+static gboolean
+lacks_extended_info (NautilusFile *file)
+{
+    return file->details->extended_info_is_deferred
+           && !file->details->is_gone;
+}
+
 static gboolean
 lacks_deep_count (NautilusFile *file)
 {
@@ -1745,6 +1823,22 @@ request_is_satisfied (NautilusDirectory *directory,
         }
     }
 
+    if (REQUEST_WANTS_TYPE (request, REQUEST_METADATA))
+    {
+        if (has_problem (directory, file, lacks_metadata))
+        {
+            return FALSE;
+        }
+    }
+
+    if (REQUEST_WANTS_TYPE (request, REQUEST_EXTENDED_INFO))
+    {
+        if (has_problem (directory, file, lacks_extended_info))
+        {
+            return FALSE;
+        }
+    }
+
     if (REQUEST_WANTS_TYPE (request, REQUEST_DEEP_COUNT))
     {
         if (has_problem (directory, file, lacks_deep_count))
@@ -1778,6 +1872,9 @@ call_ready_callbacks_at_idle (gpointer callback_data)
     NautilusDirectory *directory;
     GList *node, *next;
     ReadyCallback *callback;
+    guint n_callbacks = 0;
+    gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+    gint64 watchdog_start = nautilus_stall_watchdog_begin ();
 
     directory = NAUTILUS_DIRECTORY (callback_data);
     directory->details->call_ready_idle_id = 0;
@@ -1810,8 +1907,14 @@ call_ready_callbacks_at_idle (gpointer callback_data)
         /* Call the callback. */
         ready_callback_call (directory, callback);
         g_free (callback);
+        n_callbacks++;
     }
 
+    nautilus_trace_mark_printf (trace_start, "call-ready-callbacks-at-idle",
+                                "%u callbacks", n_callbacks);
+    nautilus_stall_watchdog_end (watchdog_start, "call_ready_callbacks_at_idle",
+                                 n_callbacks);
+
     nautilus_directory_async_state_changed (directory);
 
     nautilus_directory_unref (directory);
@@ -1995,13 +2098,6 @@ more_files_callback (GObject      *source_object,
     files = g_file_enumerator_next_files_finish (state->enumerator,
                                                  res, &error);
 
-    for (l = files; l != NULL; l = l->next)
-    {
-        info = l->data;
-        directory_load_one (directory, info);
-        g_object_unref (info);
-    }
-
     if (files == NULL)
     {
         directory_load_done (directory, error);
@@ -2009,14 +2105,27 @@ more_files_callback (GObject      *source_object,
     }
     else
     {
+        /* Ask for the next batch before queueing this one, so the
+         * enumerator keeps reading while we are busy here. */
         g_file_enumerator_next_files_async (state->enumerator,
-                                            DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+                                            state->items_per_callback,
                                             G_PRIORITY_DEFAULT,
                                             state->cancellable,
                                             more_files_callback,
                                             state);
     }
 
+    for (l = files; l != NULL; l = l->next)
+    {
+        info = l->data;
+        if (state->deferred_attributes != 0)
+        {
+            nautilus_file_mark_info_deferred (info, state->deferred_attributes);
+        }
+        directory_load_one (directory, info);
+        g_object_unref (info);
+    }
+
     nautilus_directory_unref (directory);
 
     if (error)
@@ -2060,7 +2169,7 @@ enumerate_children_callback (GObject      *source_object,
     {
         state->enumerator = enumerator;
         g_file_enumerator_next_files_async (state->enumerator,
-                                            DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+                                            state->items_per_callback,
                                             G_PRIORITY_DEFAULT,
                                             state->cancellable,
                                             more_files_callback,
@@ -2068,6 +2177,49 @@ enumerate_children_callback (GObject      *source_object,
     }
 }
 
+/* Asking for metadata::* makes the enumerator look up the metadata of each
+ * file, which most of the files in a large directory don't have. With
+ * NAUTILUS_DEFER_METADATA set, directories are loaded without it, and the
+ * metadata of all files is fetched at once after the load, if anything
+ * asks for it.
+ *
+ * With NAUTILUS_DEFER_EXTENDED_INFO set, directories are loaded with only
+ * the basic attributes, and the extended ones are fetched one file at a
+ * time for the files that ask for NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO,
+ * such as those the view shows. */
+NautilusFileAttributes
+nautilus_directory_get_deferred_attributes (void)
+{
+    NautilusFileAttributes deferred_attributes = 0;
+
+    if (g_getenv ("NAUTILUS_DEFER_METADATA") != NULL)
+    {
+        deferred_attributes |= NAUTILUS_FILE_ATTRIBUTE_METADATA;
+    }
+    if (g_getenv ("NAUTILUS_DEFER_EXTENDED_INFO") != NULL)
+    {
+        deferred_attributes |= NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO;
+    }
+
+    return deferred_attributes;
+}
+
+static const char *
+get_load_attributes (NautilusFileAttributes deferred_attributes)
+{
+    gboolean defer_metadata = (deferred_attributes & NAUTILUS_FILE_ATTRIBUTE_METADATA) != 0;
+
+    if ((deferred_attributes & NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO) != 0)
+    {
+        return defer_metadata ?
+               NAUTILUS_FILE_BASIC_ATTRIBUTES :
+               NAUTILUS_FILE_BASIC_ATTRIBUTES ",metadata::*";
+    }
+
+    return defer_metadata ?
+           NAUTILUS_FILE_DEFAULT_ATTRIBUTES_WITHOUT_METADATA :
+           NAUTILUS_FILE_DEFAULT_ATTRIBUTES;
+}
 
 /* Start monitoring the file list if it isn't already. */
 static void
@@ -2101,6 +2253,9 @@ start_monitoring_file_list (NautilusDirectory *directory)
     state->load_file_count = 0;
 
     g_assert (directory->details->location != NULL);
+    state->items_per_callback = g_file_is_native (directory->details->location) ?
+                                DIRECTORY_LOAD_NATIVE_ITEMS_PER_CALLBACK :
+                                DIRECTORY_LOAD_ITEMS_PER_CALLBACK;
     state->load_directory_file =
         nautilus_directory_get_corresponding_file (directory);
     state->load_directory_file->details->loading_directory = TRUE;
@@ -2110,8 +2265,14 @@ start_monitoring_file_list (NautilusDirectory *directory)
 
     directory->details->directory_load_in_progress = state;
 
+    /* A metadata fetch would miss the files of the new load. */
+    metadata_cancel (directory);
+    state->deferred_attributes = nautilus_directory_get_deferred_attributes ();
+    directory->details->metadata_deferred =
+        (state->deferred_attributes & NAUTILUS_FILE_ATTRIBUTE_METADATA) != 0;
+
     g_file_enumerate_children_async (directory->details->location,
-                                     NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
+                                     get_load_attributes (state->deferred_attributes),
                                      0,     /* flags */
                                      G_PRIORITY_DEFAULT,     /* prio */
                                      state->cancellable,
@@ -2587,24 +2748,11 @@ static inline gboolean
 seen_inode (DeepCountState *state,
             GFileInfo      *info)
 {
-    guint64 inode, inode2;
-    guint i;
+    guint64 inode;
 
     inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
 
-    if (inode != 0)
-    {
-        for (i = 0; i < state->seen_deep_count_inodes->len; i++)
-        {
-            inode2 = g_array_index (state->seen_deep_count_inodes, guint64, i);
-            if (inode == inode2)
-            {
-                return TRUE;
-            }
-        }
-    }
-
-    return FALSE;
+    return inode != 0 && g_hash_table_contains (state->seen_deep_count_inodes, &inode);
 }
 
 static inline void
@@ -2616,7 +2764,7 @@ mark_inode_as_seen (DeepCountState *state,
     inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
     if (inode != 0)
     {
-        g_array_append_val (state->seen_deep_count_inodes, inode);
+        g_hash_table_add (state->seen_deep_count_inodes, g_memdup2 (&inode, sizeof (guint64)));
     }
 }
 
@@ -2635,7 +2783,7 @@ deep_count_one (DeepCountState *state,
         mark_inode_as_seen (state, info);
     }
 
-    file = state->directory->details->deep_count_file;
+    file = state->file;
 
     if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
     {
@@ -2683,7 +2831,7 @@ deep_count_state_free (DeepCountState *state)
         g_object_unref (state->deep_count_location);
     }
     g_list_free_full (state->deep_count_subdirectories, g_object_unref);
-    g_array_free (state->seen_deep_count_inodes, TRUE);
+    g_hash_table_destroy (state->seen_deep_count_inodes);
     g_free (state->fs_id);
     g_free (state);
 }
@@ -2702,7 +2850,7 @@ deep_count_next_dir (DeepCountState *state)
     state->deep_count_location = NULL;
 
     done = FALSE;
-    file = directory->details->deep_count_file;
+    file = state->file;
 
     if (state->deep_count_subdirectories != NULL)
     {
@@ -2716,8 +2864,8 @@ deep_count_next_dir (DeepCountState *state)
     else
     {
         file->details->deep_counts_status = NAUTILUS_REQUEST_DONE;
-        directory->details->deep_count_file = NULL;
-        directory->details->deep_count_in_progress = NULL;
+        directory->details->deep_counts_in_progress = g_list_remove (directory->details->deep_counts_in_progress,
+                                                                     state);
         deep_count_state_free (state);
         done = TRUE;
     }
@@ -2753,8 +2901,7 @@ deep_count_more_files_callback (GObject      *source_object,
 
     directory = nautilus_directory_ref (state->directory);
 
-    g_assert (directory->details->deep_count_in_progress != NULL);
-    g_assert (directory->details->deep_count_in_progress == state);
+    g_assert (g_list_find (directory->details->deep_counts_in_progress, state) != NULL);
 
     files = g_file_enumerator_next_files_finish (state->enumerator,
                                                  res, NULL);
@@ -2807,7 +2954,7 @@ deep_count_callback (GObject      *source_object,
         return;
     }
 
-    file = state->directory->details->deep_count_file;
+    file = state->file;
 
     enumerator = g_file_enumerate_children_finish (G_FILE (source_object), res, NULL);
 
@@ -2855,11 +3002,15 @@ deep_count_load (DeepCountState *state,
 static void
 deep_count_stop (NautilusDirectory *directory)
 {
-    NautilusFile *file;
+    GList *l, *next;
 
-    if (directory->details->deep_count_in_progress != NULL)
+    for (l = directory->details->deep_counts_in_progress; l != NULL; l = next)
     {
-        file = directory->details->deep_count_file;
+        DeepCountState *state = l->data;
+        NautilusFile *file = state->file;
+
+        next = l->next;
+
         if (file != NULL)
         {
             g_assert (NAUTILUS_IS_FILE (file));
@@ -2868,13 +3019,30 @@ deep_count_stop (NautilusDirectory *directory)
                           lacks_deep_count,
                           REQUEST_DEEP_COUNT))
             {
-                return;
+                continue;
             }
         }
 
         /* The count is not wanted, so stop it. */
-        deep_count_cancel (directory);
+        deep_count_cancel_one (directory, state);
+    }
+}
+
+static DeepCountState *
+find_deep_count_state (NautilusDirectory *directory,
+                       NautilusFile      *file)
+{
+    for (GList *l = directory->details->deep_counts_in_progress; l != NULL; l = l->next)
+    {
+        DeepCountState *state = l->data;
+
+        if (state->file == file)
+        {
+            return state;
+        }
     }
+
+    return NULL;
 }
 
 static void
@@ -2905,9 +3073,11 @@ deep_count_start (NautilusDirectory *directory,
     GFile *location;
     DeepCountState *state;
 
-    if (directory->details->deep_count_in_progress != NULL)
+    /* A file whose count is already running doesn't hold up the queue, so
+     * that the files after it can get their counts started too.
+     */
+    if (find_deep_count_state (directory, file) != NULL)
     {
-        *doing_io = TRUE;
         return;
     }
 
@@ -2917,10 +3087,16 @@ deep_count_start (NautilusDirectory *directory,
     {
         return;
     }
-    *doing_io = TRUE;
+
+    if (g_list_length (directory->details->deep_counts_in_progress) >= MAX_DEEP_COUNTS_PER_DIRECTORY)
+    {
+        *doing_io = TRUE;
+        return;
+    }
 
     if (!nautilus_file_is_directory (file))
     {
+        *doing_io = TRUE;
         file->details->deep_counts_status = NAUTILUS_REQUEST_DONE;
 
         nautilus_directory_async_state_changed (directory);
@@ -2929,6 +3105,7 @@ deep_count_start (NautilusDirectory *directory,
 
     if (!async_job_start (directory, "deep count"))
     {
+        *doing_io = TRUE;
         return;
     }
 
@@ -2938,15 +3115,17 @@ deep_count_start (NautilusDirectory *directory,
     file->details->deep_file_count = 0;
     file->details->deep_unreadable_count = 0;
     file->details->deep_size = 0;
-    directory->details->deep_count_file = file;
 
     state = g_new0 (DeepCountState, 1);
     state->directory = directory;
+    state->file = file;
     state->cancellable = g_cancellable_new ();
-    state->seen_deep_count_inodes = g_array_new (FALSE, TRUE, sizeof (guint64));
+    state->seen_deep_count_inodes = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                                           g_free, NULL);
     state->fs_id = NULL;
 
-    directory->details->deep_count_in_progress = state;
+    directory->details->deep_counts_in_progress = g_list_prepend (directory->details->deep_counts_in_progress,
+                                                                  state);
 
     location = nautilus_file_get_location (file);
     g_file_query_info_async (location,
@@ -3032,6 +3211,14 @@ query_info_callback (GObject      *source_object,
     get_info_state_free (state);
 }
 
+/* The extended info is fetched by querying the whole file info again. */
+static gboolean
+is_file_info_needed (NautilusFile *file)
+{
+    return is_needy (file, lacks_info, REQUEST_FILE_INFO) ||
+           is_needy (file, lacks_extended_info, REQUEST_EXTENDED_INFO);
+}
+
 static void
 file_info_stop (NautilusDirectory *directory)
 {
@@ -3044,7 +3231,7 @@ file_info_stop (NautilusDirectory *directory)
         {
             g_assert (NAUTILUS_IS_FILE (file));
             g_assert (file->details->directory == directory);
-            if (is_needy (file, lacks_info, REQUEST_FILE_INFO))
+            if (is_file_info_needed (file))
             {
                 return;
             }
@@ -3071,7 +3258,7 @@ file_info_start (NautilusDirectory *directory,
         return;
     }
 
-    if (!is_needy (file, lacks_info, REQUEST_FILE_INFO))
+    if (!is_file_info_needed (file))
     {
         return;
     }
@@ -3272,10 +3459,19 @@ thumbnail_read_callback (GObject      *source_object,
     pixbuf = NULL;
     if (result)
     {
+        gint64 decode_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+
         pixbuf = get_pixbuf_for_content (file_size, file_contents);
         g_free (file_contents);
+
+        nautilus_trace_mark_printf (decode_start, "thumbnail-decode",
+                                    "%s, %" G_GSIZE_FORMAT " bytes",
+                                    state->file->details->name, file_size);
     }
 
+    nautilus_trace_mark_printf (state->trace_start, "thumbnail-load",
+                                "%s", state->file->details->name);
+
     state->directory->details->thumbnail_state = NULL;
     async_job_end (state->directory, "thumbnail");
 
@@ -3317,6 +3513,7 @@ thumbnail_start (NautilusDirectory *directory,
     state->directory = directory;
     state->file = file;
     state->cancellable = g_cancellable_new ();
+    state->trace_start = NAUTILUS_TRACE_CURRENT_TIME;
 
     location = g_file_new_for_path (file->details->thumbnail_path);
 
@@ -3651,6 +3848,212 @@ filesystem_info_start (NautilusDirectory *directory,
     g_object_unref (location);
 }
 
+static gboolean
+is_metadata_wanted (NautilusDirectory *directory)
+{
+    return directory->details->monitor_counters[REQUEST_METADATA] > 0 ||
+           directory->details->call_when_ready_counters[REQUEST_METADATA] > 0;
+}
+
+static void
+metadata_cancel (NautilusDirectory *directory)
+{
+    if (directory->details->metadata_state != NULL)
+    {
+        g_cancellable_cancel (directory->details->metadata_state->cancellable);
+        directory->details->metadata_state->directory = NULL;
+        directory->details->metadata_state = NULL;
+        async_job_end (directory, "metadata");
+    }
+}
+
+static void
+metadata_stop (NautilusDirectory *directory)
+{
+    if (directory->details->metadata_state != NULL &&
+        !is_metadata_wanted (directory))
+    {
+        metadata_cancel (directory);
+    }
+}
+
+static void
+metadata_state_free (MetadataState *state)
+{
+    if (state->enumerator != NULL)
+    {
+        if (!g_file_enumerator_is_closed (state->enumerator))
+        {
+            g_file_enumerator_close_async (state->enumerator,
+                                           0, NULL, NULL, NULL);
+        }
+        g_object_unref (state->enumerator);
+    }
+
+    g_object_unref (state->cancellable);
+    g_free (state);
+}
+
+static void
+metadata_done (MetadataState *state)
+{
+    NautilusDirectory *directory;
+    GList *node;
+
+    directory = nautilus_directory_ref (state->directory);
+
+    directory->details->metadata_state = NULL;
+    directory->details->metadata_deferred = FALSE;
+    async_job_end (directory, "metadata");
+
+    /* Files the enumeration didn't get to, e.g. because it failed, keep
+     * the metadata they have, rather than being waited for forever. */
+    for (node = directory->details->file_list; node != NULL; node = node->next)
+    {
+        NAUTILUS_FILE (node->data)->details->metadata_is_deferred = FALSE;
+    }
+
+    nautilus_directory_async_state_changed (directory);
+
+    nautilus_directory_unref (directory);
+
+    metadata_state_free (state);
+}
+
+static void
+metadata_more_files_callback (GObject      *source_object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
+{
+    MetadataState *state;
+    NautilusDirectory *directory;
+    GList *infos;
+    GList *changed_files;
+
+    state = user_data;
+
+    if (state->directory == NULL)
+    {
+        /* Operation was cancelled. Bail out */
+        metadata_state_free (state);
+        return;
+    }
+
+    infos = g_file_enumerator_next_files_finish (state->enumerator, res, NULL);
+    if (infos == NULL)
+    {
+        metadata_done (state);
+        return;
+    }
+
+    directory = nautilus_directory_ref (state->directory);
+    changed_files = NULL;
+
+    for (GList *l = infos; l != NULL; l = l->next)
+    {
+        GFileInfo *info = l->data;
+        NautilusFile *file;
+
+        file = nautilus_directory_find_file_by_name (directory,
+                                                     g_file_info_get_name (info));
+        if (file == NULL || !file->details->metadata_is_deferred)
+        {
+            continue;
+        }
+
+        file->details->metadata_is_deferred = FALSE;
+        if (nautilus_file_update_metadata_from_info (file, info))
+        {
+            changed_files = g_list_prepend (changed_files, nautilus_file_ref (file));
+        }
+    }
+
+    g_file_enumerator_next_files_async (state->enumerator,
+                                        state->items_per_callback,
+                                        G_PRIORITY_DEFAULT,
+                                        state->cancellable,
+                                        metadata_more_files_callback,
+                                        state);
+
+    nautilus_directory_emit_change_signals (directory, changed_files);
+    nautilus_directory_async_state_changed (directory);
+
+    nautilus_file_list_free (changed_files);
+    g_list_free_full (infos, g_object_unref);
+    nautilus_directory_unref (directory);
+}
+
+static void
+metadata_enumerate_callback (GObject      *source_object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+    MetadataState *state;
+
+    state = user_data;
+
+    if (state->directory == NULL)
+    {
+        /* Operation was cancelled. Bail out */
+        metadata_state_free (state);
+        return;
+    }
+
+    state->enumerator = g_file_enumerate_children_finish (G_FILE (source_object),
+                                                          res, NULL);
+    if (state->enumerator == NULL)
+    {
+        metadata_done (state);
+        return;
+    }
+
+    g_file_enumerator_next_files_async (state->enumerator,
+                                        state->items_per_callback,
+                                        G_PRIORITY_DEFAULT,
+                                        state->cancellable,
+                                        metadata_more_files_callback,
+                                        state);
+}
+
+/* Fetches the metadata of the files loaded without it, once the directory
+ * is done loading, with a single enumeration of the directory. */
+static void
+metadata_start (NautilusDirectory *directory)
+{
+    MetadataState *state;
+
+    if (directory->details->metadata_state != NULL ||
+        !directory->details->metadata_deferred ||
+        directory->details->directory_load_in_progress != NULL ||
+        directory->details->pending_file_info != NULL ||
+        !is_metadata_wanted (directory))
+    {
+        return;
+    }
+
+    if (!async_job_start (directory, "metadata"))
+    {
+        return;
+    }
+
+    state = g_new0 (MetadataState, 1);
+    state->directory = directory;
+    state->cancellable = g_cancellable_new ();
+    state->items_per_callback = g_file_is_native (directory->details->location) ?
+                                DIRECTORY_LOAD_NATIVE_ITEMS_PER_CALLBACK :
+                                DIRECTORY_LOAD_ITEMS_PER_CALLBACK;
+
+    directory->details->metadata_state = state;
+
+    g_file_enumerate_children_async (directory->details->location,
+                                     G_FILE_ATTRIBUTE_STANDARD_NAME ",metadata::*",
+                                     0,     /* flags */
+                                     G_PRIORITY_DEFAULT,     /* prio */
+                                     state->cancellable,
+                                     metadata_enumerate_callback,
+                                     state);
+}
+
 static void
 extension_info_cancel (NautilusDirectory *directory)
 {
@@ -3844,6 +4247,10 @@ start_or_stop_io (NautilusDirectory *directory)
     mount_stop (directory);
     thumbnail_stop (directory);
     filesystem_info_stop (directory);
+    metadata_stop (directory);
+
+    /* This is for the whole directory, so it doesn't hold up the queues. */
+    metadata_start (directory);
 
     doing_io = FALSE;
     /* Take files that are all done off the queue. */
@@ -3921,8 +4328,11 @@ nautilus_directory_async_state_changed (NautilusDirectory *directory)
     nautilus_directory_ref (directory);
     do
     {
+        gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+
         directory->details->state_changed = FALSE;
         start_or_stop_io (directory);
+        nautilus_trace_mark (trace_start, "start-or-stop-io");
         if (call_ready_callbacks (directory))
         {
             directory->details->state_changed = TRUE;
@@ -3949,6 +4359,7 @@ nautilus_directory_cancel (NautilusDirectory *directory)
     thumbnail_cancel (directory);
     mount_cancel (directory);
     filesystem_info_cancel (directory);
+    metadata_cancel (directory);
 
     /* We aren't waiting for anything any more. */
     if (waiting_directories != NULL)
@@ -3975,9 +4386,12 @@ static void
 cancel_deep_counts_for_file (NautilusDirectory *directory,
                              NautilusFile      *file)
 {
-    if (directory->details->deep_count_file == file)
+    DeepCountState *state;
+
+    state = find_deep_count_state (directory, file);
+    if (state != NULL)
     {
-        deep_count_cancel (directory);
+        deep_count_cancel_one (directory, state);
     }
 }
 
@@ -4063,6 +4477,11 @@ cancel_loading_attributes (NautilusDirectory      *directory,
         mount_cancel (directory);
     }
 
+    if (REQUEST_WANTS_TYPE (request, REQUEST_METADATA))
+    {
+        metadata_cancel (directory);
+    }
+
     nautilus_directory_async_state_changed (directory);
 }
 
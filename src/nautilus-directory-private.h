@@ -36,6 +36,7 @@ typedef struct NewFilesState NewFilesState;
 typedef struct ThumbnailState ThumbnailState;
 typedef struct MountState MountState;
 typedef struct FilesystemInfoState FilesystemInfoState;
+typedef struct MetadataState MetadataState;
 
 typedef enum {
 	REQUEST_DEEP_COUNT,
@@ -46,6 +47,8 @@ typedef enum {
 	REQUEST_THUMBNAIL,
 	REQUEST_MOUNT,
 	REQUEST_FILESYSTEM_INFO,
+	REQUEST_METADATA,
+	REQUEST_EXTENDED_INFO,
 	REQUEST_TYPE_LAST
 } RequestType;
 
@@ -105,8 +108,7 @@ struct NautilusDirectoryPrivate
 
 	DirectoryCountState *count_in_progress;
 
-	NautilusFile *deep_count_file;
-	DeepCountState *deep_count_in_progress;
+	GList *deep_counts_in_progress; /* list of DeepCountState * */
 
 	NautilusFile *get_info_file;
 	GetInfoState *get_info_in_progress;
@@ -122,6 +124,10 @@ struct NautilusDirectoryPrivate
 
 	FilesystemInfoState *filesystem_info_state;
 
+	/* Set when the file list was loaded without metadata. */
+	gboolean metadata_deferred;
+	MetadataState *metadata_state;
+
 	GList *file_operations_in_progress; /* list of FileOperation * */
 };
 
@@ -181,6 +187,8 @@ void               nautilus_directory_emit_change_signals             (NautilusD
 								       GList                     *changed_files);
 void               emit_change_signals_for_all_files		      (NautilusDirectory	 *directory);
 void               emit_change_signals_for_all_files_in_all_directories (void);
+void               invalidate_extension_info_for_all_files_in_all_directories (void);
+void               invalidate_info_for_all_files_in_unwatched_directories (void);
 void               nautilus_directory_emit_done_loading               (NautilusDirectory         *directory);
 void               nautilus_directory_emit_load_error                 (NautilusDirectory         *directory,
 								       GError                    *error);
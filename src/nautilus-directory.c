@@ -449,6 +449,84 @@ emit_change_signals_for_all_files_in_all_directories (void)
     g_list_free (dirs);
 }
 
+static void
+invalidate_extension_info_for_all_files (NautilusDirectory *directory)
+{
+    g_autolist (NautilusFile) files = NULL;
+
+    files = nautilus_file_list_copy (directory->details->file_list);
+    if (directory->details->as_file != NULL)
+    {
+        files = g_list_prepend (files, g_object_ref (directory->details->as_file));
+    }
+
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        nautilus_file_invalidate_attributes (l->data, NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO);
+    }
+}
+
+void
+invalidate_extension_info_for_all_files_in_all_directories (void)
+{
+    GList *dirs, *l;
+    NautilusDirectory *directory;
+
+    if (directories == NULL)
+    {
+        return;
+    }
+
+    dirs = NULL;
+    g_hash_table_foreach (directories,
+                          collect_all_directories,
+                          &dirs);
+
+    for (l = dirs; l != NULL; l = l->next)
+    {
+        directory = NAUTILUS_DIRECTORY (l->data);
+        invalidate_extension_info_for_all_files (directory);
+        nautilus_directory_unref (directory);
+    }
+
+    g_list_free (dirs);
+}
+
+/* The directories that aren't watched because of the watch budget don't
+ * report changes, so read the info of their files again. */
+void
+invalidate_info_for_all_files_in_unwatched_directories (void)
+{
+    g_autolist (NautilusDirectory) dirs = NULL;
+
+    if (directories == NULL)
+    {
+        return;
+    }
+
+    g_hash_table_foreach (directories,
+                          collect_all_directories,
+                          &dirs);
+
+    for (GList *l = dirs; l != NULL; l = l->next)
+    {
+        NautilusDirectory *directory = NAUTILUS_DIRECTORY (l->data);
+        g_autolist (NautilusFile) files = NULL;
+
+        if (directory->details->monitor == NULL ||
+            !nautilus_monitor_is_over_budget (directory->details->monitor))
+        {
+            continue;
+        }
+
+        files = nautilus_file_list_copy (directory->details->file_list);
+        for (GList *f = files; f != NULL; f = f->next)
+        {
+            nautilus_file_invalidate_attributes (f->data, NAUTILUS_FILE_ATTRIBUTE_INFO);
+        }
+    }
+}
+
 static void
 async_state_changed_one (gpointer key,
                          gpointer value,
@@ -234,6 +234,11 @@ gboolean           nautilus_directory_is_in_admin              (NautilusDirector
  */
 gboolean           nautilus_directory_is_not_empty             (NautilusDirectory         *directory);
 
+/* The attributes directories are loaded without, and get later, as set in
+ * the environment, e.g. NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO.
+ */
+NautilusFileAttributes nautilus_directory_get_deferred_attributes (void);
+
 /* Convenience functions for dealing with a list of NautilusDirectory objects that each have a ref.
  * These are just convenient names for functions that work on lists of GtkObject *.
  */
@@ -69,6 +69,8 @@ typedef enum
     NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL                 = 1 << 5,
     NAUTILUS_FILE_ATTRIBUTE_MOUNT                     = 1 << 6,
     NAUTILUS_FILE_ATTRIBUTE_FILESYSTEM_INFO           = 1 << 7,
+    NAUTILUS_FILE_ATTRIBUTE_METADATA                  = 1 << 8,
+    NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO             = 1 << 9, /* Selinux context, thumbnail path */
 } NautilusFileAttributes;
 
 typedef enum
@@ -40,10 +40,15 @@ typedef struct
     GFile *to;
 } NautilusFileChange;
 
+#define CHECK_DEADLINE_INTERVAL 64
+
 typedef struct
 {
-    GList *head;
-    GList *tail;
+    GQueue changes;
+    /* Maps a location to the queue link of its latest coalescable change. */
+    GHashTable *pending;
+    guint64 n_received;
+    guint64 n_delivered;
     GMutex mutex;
 } NautilusFileChangesQueue;
 
@@ -53,6 +58,8 @@ nautilus_file_changes_queue_new (void)
     NautilusFileChangesQueue *result;
 
     result = g_new0 (NautilusFileChangesQueue, 1);
+    g_queue_init (&result->changes);
+    result->pending = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
     g_mutex_init (&result->mutex);
 
     return result;
@@ -71,19 +78,116 @@ nautilus_file_changes_queue_get (void)
     return file_changes_queue;
 }
 
+static void
+nautilus_file_change_free (NautilusFileChange *change)
+{
+    g_clear_object (&change->from);
+    g_clear_object (&change->to);
+    g_free (change);
+}
+
+/* Decides whether @new_item makes @pending_item redundant, or the other way
+ * around. Returns TRUE if @new_item itself is redundant and can be dropped.
+ * Sets @drop_pending to TRUE if @pending_item can be removed from the queue.
+ */
+static gboolean
+change_is_redundant (NautilusFileChange *pending_item,
+                     NautilusFileChange *new_item,
+                     gboolean           *drop_pending)
+{
+    *drop_pending = FALSE;
+
+    switch (new_item->kind)
+    {
+        case CHANGE_FILE_ADDED:
+        {
+            return pending_item->kind == CHANGE_FILE_ADDED;
+        }
+
+        case CHANGE_FILE_CHANGED:
+        {
+            /* An addition does not refresh the info of a file that is
+             * already known, e.g. one that was re-created, so a change
+             * behind one is kept. Only repeated changes are merged. */
+            return pending_item->kind == CHANGE_FILE_CHANGED;
+        }
+
+        case CHANGE_FILE_REMOVED:
+        {
+            if (pending_item->kind == CHANGE_FILE_REMOVED ||
+                pending_item->kind == CHANGE_FILE_UNMOUNTED)
+            {
+                return TRUE;
+            }
+
+            /* The removal is still delivered, in case the file was already
+             * known before it was reported as added. */
+            *drop_pending = pending_item->kind == CHANGE_FILE_ADDED ||
+                            pending_item->kind == CHANGE_FILE_CHANGED;
+            return FALSE;
+        }
+
+        case CHANGE_FILE_UNMOUNTED:
+        {
+            *drop_pending = pending_item->kind == CHANGE_FILE_ADDED ||
+                            pending_item->kind == CHANGE_FILE_CHANGED;
+            return FALSE;
+        }
+
+        default:
+        {
+            return FALSE;
+        }
+    }
+}
+
 static void
 nautilus_file_changes_queue_add_common (NautilusFileChangesQueue *queue,
                                         NautilusFileChange       *new_item)
 {
+    GList *pending_link;
+    gboolean drop_pending;
+
     /* enqueue the new queue item while locking down the list */
     g_mutex_lock (&queue->mutex);
 
-    queue->head = g_list_prepend (queue->head, new_item);
-    if (queue->tail == NULL)
+    queue->n_received++;
+
+    if (new_item->kind == CHANGE_FILE_MOVED)
     {
-        queue->tail = queue->head;
+        /* Don't coalesce across moves, the order matters for them. */
+        g_hash_table_remove_all (queue->pending);
+        g_queue_push_tail (&queue->changes, new_item);
+
+        g_mutex_unlock (&queue->mutex);
+        return;
     }
 
+    pending_link = g_hash_table_lookup (queue->pending, new_item->from);
+    if (pending_link != NULL)
+    {
+        NautilusFileChange *pending_item = pending_link->data;
+
+        if (change_is_redundant (pending_item, new_item, &drop_pending))
+        {
+            nautilus_file_change_free (new_item);
+
+            g_mutex_unlock (&queue->mutex);
+            return;
+        }
+
+        if (drop_pending)
+        {
+            /* Remove from the table first, as the key belongs to the item. */
+            g_hash_table_remove (queue->pending, pending_item->from);
+            g_queue_delete_link (&queue->changes, pending_link);
+            nautilus_file_change_free (pending_item);
+        }
+    }
+
+    g_queue_push_tail (&queue->changes, new_item);
+    g_hash_table_replace (queue->pending, new_item->from, queue->changes.tail);
+
     g_mutex_unlock (&queue->mutex);
 }
 
@@ -163,26 +267,27 @@ nautilus_file_changes_queue_file_moved (GFile *from,
 static NautilusFileChange *
 nautilus_file_changes_queue_get_change (NautilusFileChangesQueue *queue)
 {
-    GList *new_tail;
+    GList *head;
     NautilusFileChange *result;
 
     g_assert (queue != NULL);
 
-    /* dequeue the tail item while locking down the list */
+    /* dequeue the oldest item while locking down the list */
     g_mutex_lock (&queue->mutex);
 
-    if (queue->tail == NULL)
+    head = g_queue_pop_head_link (&queue->changes);
+    if (head == NULL)
     {
         result = NULL;
     }
     else
     {
-        new_tail = queue->tail->prev;
-        result = queue->tail->data;
-        queue->head = g_list_remove_link (queue->head,
-                                          queue->tail);
-        g_list_free_1 (queue->tail);
-        queue->tail = new_tail;
+        result = head->data;
+        if (g_hash_table_lookup (queue->pending, result->from) == head)
+        {
+            g_hash_table_remove (queue->pending, result->from);
+        }
+        g_list_free_1 (head);
     }
 
     g_mutex_unlock (&queue->mutex);
@@ -190,6 +295,35 @@ nautilus_file_changes_queue_get_change (NautilusFileChangesQueue *queue)
     return result;
 }
 
+static void
+nautilus_file_changes_queue_count_delivered (NautilusFileChangesQueue *queue,
+                                             guint                     n_delivered)
+{
+    g_mutex_lock (&queue->mutex);
+    queue->n_delivered += n_delivered;
+    g_mutex_unlock (&queue->mutex);
+}
+
+void
+nautilus_file_changes_queue_get_counters (guint64 *n_received,
+                                          guint64 *n_delivered)
+{
+    NautilusFileChangesQueue *queue;
+
+    queue = nautilus_file_changes_queue_get ();
+
+    g_mutex_lock (&queue->mutex);
+    if (n_received != NULL)
+    {
+        *n_received = queue->n_received;
+    }
+    if (n_delivered != NULL)
+    {
+        *n_delivered = queue->n_delivered;
+    }
+    g_mutex_unlock (&queue->mutex);
+}
+
 static void
 pairs_list_free (GList *pairs)
 {
@@ -211,10 +345,12 @@ pairs_list_free (GList *pairs)
 }
 
 /* go through changes in the change queue, send ones with the same kind
- * in a list to the different nautilus_directory_notify calls
+ * in a list to the different nautilus_directory_notify calls.
+ * If @deadline is not 0, stop once the monotonic time passes it.
+ * Returns TRUE if it stopped before the queue was drained.
  */
-void
-nautilus_file_changes_consume_changes (void)
+static gboolean
+consume_changes_until (gint64 deadline)
 {
     NautilusFileChange *change;
     GList *additions, *changes, *deletions, *moves;
@@ -222,6 +358,8 @@ nautilus_file_changes_consume_changes (void)
     GFilePair *pair;
     NautilusFileChangesQueue *queue;
     gboolean flush_needed;
+    gboolean out_of_time = FALSE;
+    guint n_consumed = 0;
 
 
     additions = NULL;
@@ -238,7 +376,18 @@ nautilus_file_changes_consume_changes (void)
      */
     for (;;)
     {
-        change = nautilus_file_changes_queue_get_change (queue);
+        /* Checking the clock for every single change would be wasteful. */
+        if (deadline != 0 &&
+            n_consumed % CHECK_DEADLINE_INTERVAL == CHECK_DEADLINE_INTERVAL - 1 &&
+            g_get_monotonic_time () >= deadline)
+        {
+            out_of_time = TRUE;
+            change = NULL;
+        }
+        else
+        {
+            change = nautilus_file_changes_queue_get_change (queue);
+        }
 
         /* figure out if we need to flush the pending changes that we collected sofar */
 
@@ -311,9 +460,12 @@ nautilus_file_changes_consume_changes (void)
         if (change == NULL)
         {
             /* we are done */
-            return;
+            nautilus_file_changes_queue_count_delivered (queue, n_consumed);
+            return out_of_time;
         }
 
+        n_consumed++;
+
         /* add the new change to the list */
         switch (change->kind)
         {
@@ -365,3 +517,15 @@ nautilus_file_changes_consume_changes (void)
         g_free (change);
     }
 }
+
+void
+nautilus_file_changes_consume_changes (void)
+{
+    consume_changes_until (0);
+}
+
+gboolean
+nautilus_file_changes_consume_changes_with_budget (gint64 time_budget_us)
+{
+    return consume_changes_until (g_get_monotonic_time () + time_budget_us);
+}
@@ -30,3 +30,7 @@ void nautilus_file_changes_queue_file_moved                      (GFile      *fr
 								  GFile      *to);
 
 void nautilus_file_changes_consume_changes                       (void);
+gboolean nautilus_file_changes_consume_changes_with_budget       (gint64      time_budget_us);
+
+void nautilus_file_changes_queue_get_counters                    (guint64    *n_received,
+								  guint64    *n_delivered);
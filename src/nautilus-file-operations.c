@@ -29,7 +29,11 @@
 #include <math.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <stdlib.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #include "nautilus-file-operations.h"
 
@@ -58,6 +62,7 @@
 #include "nautilus-file-undo-operations.h"
 #include "nautilus-file-undo-manager.h"
 #include "nautilus-scheme.h"
+#include "nautilus-trace.h"
 #include "nautilus-ui-utilities.h"
 
 #ifdef GDK_WINDOWING_X11
@@ -129,6 +134,7 @@ typedef struct
 {
     CommonJob common;
     GList *trash_dirs;
+    GList *local_trash_roots;
     gboolean should_confirm;
     NautilusOpCallback done_callback;
     gpointer done_callback_data;
@@ -203,20 +209,34 @@ typedef struct
     CommonJob common;
     GList *source_files;
     GFile *destination_directory;
-    GList *output_files;
-    gboolean destination_decided;
-    gboolean extraction_failed;
-
-    gdouble base_progress;
 
-    guint64 archive_compressed_size;
+    /* Several archives are extracted at the same time. The lock protects
+     * the fields below, which all of them update. */
+    GMutex lock;
+    GList *output_files;
+    GPtrArray *archives;
     guint64 total_compressed_size;
     gint total_files;
 
+    /* Taken by an archive while it asks the user something, so that only
+     * one dialog is shown at a time. */
+    GMutex dialog_lock;
+
     NautilusExtractCallback done_callback;
     gpointer done_callback_data;
 } ExtractJob;
 
+typedef struct
+{
+    ExtractJob *job;
+    GFile *source_file;
+    /* Owned by job->output_files once decided */
+    GFile *destination;
+    guint64 compressed_size;
+    gdouble progress;
+    gboolean failed;
+} ExtractArchive;
+
 typedef struct
 {
     CommonJob common;
@@ -2123,7 +2143,11 @@ trash_or_delete_internal (GTask        *task,
         }
         if (confirmed)
         {
+            gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+
             delete_files (common, to_delete_files, &files_skipped);
+            nautilus_trace_mark_printf (trace_start, "delete-files", "%u files",
+                                        g_list_length (to_delete_files));
         }
         else
         {
@@ -2133,9 +2157,13 @@ trash_or_delete_internal (GTask        *task,
 
     if (to_trash_files != NULL)
     {
+        gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+
         to_trash_files = g_list_reverse (to_trash_files);
 
         trash_files (common, to_trash_files, &files_skipped);
+        nautilus_trace_mark_printf (trace_start, "trash-files", "%u files",
+                                    g_list_length (to_trash_files));
     }
 
     if (files_skipped == g_list_length (job->files))
@@ -2428,11 +2456,12 @@ dir_has_files (GFile *dir)
     return res;
 }
 
+/* Returns the trash directories, which hold files/ and info/, of a native
+ * mount. */
 static GList *
-get_trash_dirs_for_mount (GMount *mount)
+get_trash_roots_for_mount (GMount *mount)
 {
     GFile *root;
-    GFile *trash;
     char *relpath;
     GList *list;
 
@@ -2447,29 +2476,63 @@ get_trash_dirs_for_mount (GMount *mount)
     if (g_file_is_native (root))
     {
         relpath = g_strdup_printf (".Trash/%d", getuid ());
-        trash = g_file_resolve_relative_path (root, relpath);
+        list = g_list_prepend (list, g_file_resolve_relative_path (root, relpath));
         g_free (relpath);
 
-        list = g_list_prepend (list, g_file_get_child (trash, "files"));
-        list = g_list_prepend (list, g_file_get_child (trash, "info"));
-
-        g_object_unref (trash);
-
         relpath = g_strdup_printf (".Trash-%d", getuid ());
-        trash = g_file_get_child (root, relpath);
+        list = g_list_prepend (list, g_file_get_child (root, relpath));
         g_free (relpath);
+    }
+
+    g_object_unref (root);
+
+    return list;
+}
+
+static GList *
+get_trash_dirs_for_mount (GMount *mount)
+{
+    GList *roots;
+    GList *list;
 
-        list = g_list_prepend (list, g_file_get_child (trash, "files"));
-        list = g_list_prepend (list, g_file_get_child (trash, "info"));
+    roots = get_trash_roots_for_mount (mount);
+    list = NULL;
 
-        g_object_unref (trash);
+    for (GList *l = roots; l != NULL; l = l->next)
+    {
+        list = g_list_prepend (list, g_file_get_child (l->data, "files"));
+        list = g_list_prepend (list, g_file_get_child (l->data, "info"));
     }
 
-    g_object_unref (root);
+    g_list_free_full (roots, g_object_unref);
 
     return list;
 }
 
+/* Returns the trash directories that are known to be local: the one in the
+ * home directory, and those of the native mounts. This uses the volume
+ * monitor, so it must be called from the main thread. */
+static GList *
+get_local_trash_roots (void)
+{
+    g_autoptr (GVolumeMonitor) volume_monitor = NULL;
+    GList *mounts;
+    GList *roots;
+
+    roots = g_list_prepend (NULL, g_file_new_build_filename (g_get_user_data_dir (),
+                                                             "Trash", NULL));
+
+    volume_monitor = g_volume_monitor_get ();
+    mounts = g_volume_monitor_get_mounts (volume_monitor);
+    for (GList *l = mounts; l != NULL; l = l->next)
+    {
+        roots = g_list_concat (roots, get_trash_roots_for_mount (l->data));
+    }
+    g_list_free_full (mounts, g_object_unref);
+
+    return roots;
+}
+
 static gboolean
 has_trash_files (GMount *mount)
 {
@@ -2543,6 +2606,7 @@ empty_trash_prompt_cb (GtkDialog *dialog,
         job = op_job_new (EmptyTrashJob, data->parent_window, NULL);
         job->should_confirm = FALSE;
         job->trash_dirs = get_trash_dirs_for_mount (data->mount);
+        job->local_trash_roots = get_trash_roots_for_mount (data->mount);
         job->done_callback = empty_trash_for_unmount_done;
         job->done_callback_data = data;
 
@@ -3178,6 +3242,7 @@ scan_sources (GList      *files,
 {
     GList *l;
     GFile *file;
+    gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
 
     source_info->op = kind;
     source_info->scanned_dirs_info = g_hash_table_new_full (g_file_hash,
@@ -3198,6 +3263,10 @@ scan_sources (GList      *files,
 
     /* Make sure we report the final count */
     report_preparing_count_progress (job, source_info);
+
+    nautilus_trace_mark_printf (trace_start, "scan-sources",
+                                "%d files, %" G_GOFFSET_FORMAT " bytes",
+                                source_info->num_files, source_info->num_bytes);
 }
 
 static void
@@ -4693,6 +4762,7 @@ copy_file_progress_callback (goffset  current_num_bytes,
     {
         pdata->transfer_info->num_bytes += new_size;
         pdata->last_size = current_num_bytes;
+        nautilus_trace_counter_add (NAUTILUS_TRACE_COUNTER_BYTES_COPIED, new_size);
         report_copy_progress (pdata->job,
                               pdata->source_info,
                               pdata->transfer_info);
@@ -5536,6 +5606,7 @@ nautilus_file_operations_copy (GTask        *task,
     TransferInfo transfer_info;
     g_autofree char *dest_fs_id = NULL;
     GFile *dest;
+    gint64 trace_start G_GNUC_UNUSED;
 
     job = task_data;
     common = &job->common;
@@ -5596,10 +5667,15 @@ nautilus_file_operations_copy (GTask        *task,
 
     g_timer_start (job->common.time);
 
+    trace_start = NAUTILUS_TRACE_CURRENT_TIME;
     memset (&transfer_info, 0, sizeof (transfer_info));
     copy_files (job,
                 dest_fs_id,
                 &source_info, &transfer_info);
+
+    nautilus_trace_mark_printf (trace_start, "copy-files",
+                                "%d files, %" G_GOFFSET_FORMAT " bytes",
+                                transfer_info.num_files, transfer_info.num_bytes);
 }
 
 void
@@ -6242,6 +6318,7 @@ nautilus_file_operations_move (GTask        *task,
     g_autofree char *dest_fs_id = NULL;
     g_autofree char *dest_fs_type = NULL;
     GList *fallback_files;
+    gint64 trace_start G_GNUC_UNUSED;
 
     job = task_data;
 
@@ -6292,7 +6369,11 @@ nautilus_file_operations_move (GTask        *task,
     }
 
     /* This moves all files that we can do without copy + delete */
+    trace_start = NAUTILUS_TRACE_CURRENT_TIME;
     move_files_prepare (job, dest_fs_id, &dest_fs_type, &fallbacks);
+    nautilus_trace_mark_printf (trace_start, "move-files-prepare",
+                                "%u files, %u need copying",
+                                g_list_length (job->files), g_list_length (fallbacks));
     if (job_aborted (common))
     {
         goto aborted;
@@ -6338,11 +6419,15 @@ nautilus_file_operations_move (GTask        *task,
         goto aborted;
     }
 
+    trace_start = NAUTILUS_TRACE_CURRENT_TIME;
     memset (&transfer_info, 0, sizeof (transfer_info));
     move_files (job,
                 fallbacks,
                 dest_fs_id, &dest_fs_type,
                 &source_info, &transfer_info);
+    nautilus_trace_mark_printf (trace_start, "move-files",
+                                "%d files, %" G_GOFFSET_FORMAT " bytes",
+                                transfer_info.num_files, transfer_info.num_bytes);
 
 aborted:
     g_list_free_full (fallbacks, g_free);
@@ -6783,6 +6868,7 @@ set_permissions_file (SetPermissionsJob *job,
     CommonJob *common;
     gboolean free_info;
     guint32 current;
+    guint32 new_mode;
     guint32 value;
     guint32 mask;
 
@@ -6823,18 +6909,19 @@ set_permissions_file (SetPermissionsJob *job,
         g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_MODE))
     {
         current = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE);
+        new_mode = (current & ~mask) | value;
 
-        if (common->undo_info != NULL)
+        if (new_mode != current &&
+            g_file_set_attribute_uint32 (file, G_FILE_ATTRIBUTE_UNIX_MODE,
+                                         new_mode, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                         common->cancellable, NULL) &&
+            common->undo_info != NULL)
         {
+            g_autofree gchar *relative_path = g_file_get_relative_path (job->file, file);
+
             nautilus_file_undo_info_rec_permissions_add_file (NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (common->undo_info),
-                                                              file, current);
+                                                              relative_path, current);
         }
-
-        current = (current & ~mask) | value;
-
-        g_file_set_attribute_uint32 (file, G_FILE_ATTRIBUTE_UNIX_MODE,
-                                     current, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                     common->cancellable, NULL);
     }
 
     if (!job_aborted (common) &&
@@ -6848,6 +6935,89 @@ set_permissions_file (SetPermissionsJob *job,
     }
 }
 
+/* Same as set_permissions_contained_files(), for local directories. Working
+ * relative to directory fds saves building a GFile and a GFileInfo for every
+ * single file. Takes ownership of @dir_fd.
+ */
+static void
+set_permissions_native_contained_files (SetPermissionsJob *job,
+                                        int                dir_fd,
+                                        GString           *relative_path)
+{
+    CommonJob *common;
+    DIR *dir;
+    struct dirent *entry;
+    gsize relative_path_length;
+
+    common = (CommonJob *) job;
+    relative_path_length = relative_path->len;
+
+    dir = fdopendir (dir_fd);
+    if (dir == NULL)
+    {
+        close (dir_fd);
+        return;
+    }
+
+    nautilus_progress_info_pulse_progress (common->progress);
+
+    while (!job_aborted (common) && (entry = readdir (dir)) != NULL)
+    {
+        struct stat statbuf;
+        gboolean is_dir;
+        guint32 value;
+        guint32 mask;
+        guint32 new_mode;
+
+        if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        /* Ignore errors, and don't touch symlinks, like the GIO code path. */
+        if (fstatat (dirfd (dir), entry->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0 ||
+            S_ISLNK (statbuf.st_mode))
+        {
+            continue;
+        }
+
+        is_dir = S_ISDIR (statbuf.st_mode);
+        value = is_dir ? job->dir_permissions : job->file_permissions;
+        mask = is_dir ? job->dir_mask : job->file_mask;
+        new_mode = (statbuf.st_mode & ~mask) | value;
+
+        if (relative_path_length > 0)
+        {
+            g_string_append_c (relative_path, G_DIR_SEPARATOR);
+        }
+        g_string_append (relative_path, entry->d_name);
+
+        if (new_mode != statbuf.st_mode &&
+            fchmodat (dirfd (dir), entry->d_name, new_mode & 07777, 0) == 0 &&
+            common->undo_info != NULL)
+        {
+            nautilus_file_undo_info_rec_permissions_add_file (NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (common->undo_info),
+                                                              relative_path->str, statbuf.st_mode);
+        }
+
+        if (is_dir)
+        {
+            int child_fd;
+
+            child_fd = openat (dirfd (dir), entry->d_name,
+                               O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (child_fd >= 0)
+            {
+                set_permissions_native_contained_files (job, child_fd, relative_path);
+            }
+        }
+
+        g_string_truncate (relative_path, relative_path_length);
+    }
+
+    closedir (dir);
+}
+
 static void
 set_permissions_thread_func (GTask        *task,
                              gpointer      source_object,
@@ -6863,6 +7033,22 @@ set_permissions_thread_func (GTask        *task,
                                        _("Setting permissions"));
 
     nautilus_progress_info_start (job->common.progress);
+
+    if (g_file_is_native (job->file))
+    {
+        g_autofree gchar *path = g_file_get_path (job->file);
+        int dir_fd;
+
+        dir_fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0)
+        {
+            g_autoptr (GString) relative_path = g_string_new (NULL);
+
+            set_permissions_native_contained_files (job, dir_fd, relative_path);
+            return;
+        }
+    }
+
     set_permissions_contained_files (job, job->file);
 }
 
@@ -7787,6 +7973,382 @@ delete_trash_file (CommonJob *job,
     }
 }
 
+/* Emptying a trash directory through the trash backend takes a round trip
+ * per item. The trash directories known to be local are emptied directly
+ * instead, with fd-relative unlinks, spreading the top-level items over a
+ * few threads. Anything left over, e.g. in remote trash directories, is
+ * deleted through GIO afterwards. */
+
+#define MAX_EMPTY_TRASH_THREADS 8
+
+typedef struct
+{
+    int files_fd;
+    int info_fd;
+} TrashRoot;
+
+typedef struct
+{
+    int files_fd;
+    int info_fd;
+    char *name;
+    unsigned char type;
+} TrashItem;
+
+typedef struct
+{
+    GCancellable *cancellable;
+    GMutex mutex;
+    GCond cond;
+    guint n_pending;
+} EmptyTrashState;
+
+static void
+trash_item_free (TrashItem *item)
+{
+    g_free (item->name);
+    g_free (item);
+}
+
+/* Returns whether @name is gone from @dir_fd. */
+static gboolean
+unlink_recursively_at (int            dir_fd,
+                       const char    *name,
+                       unsigned char  type,
+                       GCancellable  *cancellable)
+{
+    struct dirent *entry;
+    struct stat statbuf;
+    DIR *dir;
+    int fd;
+
+    if (type != DT_DIR)
+    {
+        if (unlinkat (dir_fd, name, 0) == 0 || errno == ENOENT)
+        {
+            return TRUE;
+        }
+        if (errno != EISDIR && errno != EPERM)
+        {
+            return FALSE;
+        }
+    }
+
+    /* fchmodat() follows symlinks, so make sure that @name is still the
+     * directory before making it accessible. */
+    fd = openat (dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1 && errno == EACCES &&
+        fstatat (dir_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) == 0 &&
+        S_ISDIR (statbuf.st_mode) &&
+        fchmodat (dir_fd, name, S_IRWXU, 0) == 0)
+    {
+        fd = openat (dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    }
+    if (fd == -1)
+    {
+        return errno == ENOENT;
+    }
+
+    /* Trashed directories can be read-only, which would keep their
+     * children from being unlinked. */
+    if (fstat (fd, &statbuf) == 0 &&
+        (statbuf.st_mode & S_IRWXU) != S_IRWXU)
+    {
+        fchmod (fd, statbuf.st_mode | S_IRWXU);
+    }
+
+    dir = fdopendir (fd);
+    if (dir == NULL)
+    {
+        close (fd);
+        return FALSE;
+    }
+
+    while (!g_cancellable_is_cancelled (cancellable) &&
+           (entry = readdir (dir)) != NULL)
+    {
+        if (strcmp (entry->d_name, ".") == 0 ||
+            strcmp (entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        unlink_recursively_at (dirfd (dir), entry->d_name, entry->d_type, cancellable);
+    }
+    closedir (dir);
+
+    return unlinkat (dir_fd, name, AT_REMOVEDIR) == 0 || errno == ENOENT;
+}
+
+static void
+empty_trash_item_func (gpointer data,
+                       gpointer user_data)
+{
+    TrashItem *item = data;
+    EmptyTrashState *state = user_data;
+
+    if (!g_cancellable_is_cancelled (state->cancellable) &&
+        unlink_recursively_at (item->files_fd, item->name, item->type, state->cancellable) &&
+        item->info_fd != -1)
+    {
+        g_autofree char *info_name = g_strconcat (item->name, ".trashinfo", NULL);
+
+        unlinkat (item->info_fd, info_name, 0);
+    }
+
+    trash_item_free (item);
+
+    g_mutex_lock (&state->mutex);
+    state->n_pending--;
+    if (state->n_pending == 0)
+    {
+        g_cond_signal (&state->cond);
+    }
+    g_mutex_unlock (&state->mutex);
+}
+
+/* Removes the .trashinfo files left without a trashed file. */
+static void
+remove_orphan_trash_infos (int files_fd,
+                           int info_fd)
+{
+    struct dirent *entry;
+    DIR *dir;
+    int fd;
+
+    fd = dup (info_fd);
+    dir = (fd != -1) ? fdopendir (fd) : NULL;
+    if (dir == NULL)
+    {
+        if (fd != -1)
+        {
+            close (fd);
+        }
+        return;
+    }
+
+    while ((entry = readdir (dir)) != NULL)
+    {
+        g_autofree char *name = NULL;
+        struct stat statbuf;
+
+        if (!g_str_has_suffix (entry->d_name, ".trashinfo"))
+        {
+            continue;
+        }
+
+        name = g_strndup (entry->d_name, strlen (entry->d_name) - strlen (".trashinfo"));
+        if (fstatat (files_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) == -1 &&
+            errno == ENOENT)
+        {
+            unlinkat (info_fd, entry->d_name, 0);
+        }
+    }
+    closedir (dir);
+}
+
+static void
+report_empty_trash_progress (CommonJob *job,
+                             guint      n_done,
+                             guint      n_total)
+{
+    /* To translators: %'d is the number of items deleted from the trash,
+     * so it will be something like 2/14. */
+    nautilus_progress_info_take_details (job->progress,
+                                         g_strdup_printf (_("%'d / %'d"), n_done, n_total));
+    nautilus_progress_info_set_progress (job->progress, n_done, n_total);
+}
+
+/* Opens @root, a trash directory from get_trash_roots_for_mount(). The
+ * shared $topdir/.Trash of a mount must be a real directory with the
+ * sticky bit set, so that users can't replace each other's trash, or
+ * its $uid directory may lead anywhere. This is checked here, in the job
+ * thread, since a slow mount can take long to answer. */
+static int
+open_trash_root (GFile *root)
+{
+    g_autofree char *path = g_file_get_path (root);
+    g_autofree char *name = g_file_get_basename (root);
+    g_autofree char *uid = g_strdup_printf ("%d", getuid ());
+    g_autoptr (GFile) parent = g_file_get_parent (root);
+    g_autofree char *parent_name = NULL;
+    g_autofree char *parent_path = NULL;
+    struct stat statbuf;
+    int parent_fd;
+    int fd;
+
+    if (path == NULL)
+    {
+        return -1;
+    }
+
+    parent_name = (parent != NULL) ? g_file_get_basename (parent) : NULL;
+    if (g_strcmp0 (name, uid) != 0 || g_strcmp0 (parent_name, ".Trash") != 0)
+    {
+        return open (path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    }
+
+    parent_path = g_file_get_path (parent);
+    parent_fd = open (parent_path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (parent_fd == -1)
+    {
+        return -1;
+    }
+
+    /* Checked on the open directory, so that it can't be swapped after. */
+    if (fstat (parent_fd, &statbuf) == -1 ||
+        !S_ISDIR (statbuf.st_mode) ||
+        (statbuf.st_mode & S_ISVTX) == 0)
+    {
+        close (parent_fd);
+        return -1;
+    }
+
+    fd = openat (parent_fd, uid, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    close (parent_fd);
+
+    return fd;
+}
+
+static void
+empty_local_trash (EmptyTrashJob *job)
+{
+    CommonJob *common = (CommonJob *) job;
+    g_autoptr (GArray) roots = g_array_new (FALSE, FALSE, sizeof (TrashRoot));
+    g_autoptr (GPtrArray) items = g_ptr_array_new ();
+    EmptyTrashState state = { 0 };
+    GThreadPool *pool;
+    guint n_threads;
+    gint64 deadline;
+
+    for (GList *l = job->local_trash_roots; l != NULL && !job_aborted (common); l = l->next)
+    {
+        struct dirent *entry;
+        TrashRoot root;
+        DIR *dir;
+        struct stat statbuf;
+        int root_fd;
+        int files_fd;
+        int info_fd;
+        int fd;
+
+        root_fd = open_trash_root (l->data);
+        if (root_fd == -1)
+        {
+            continue;
+        }
+
+        /* Only empty a trash that belongs to the user. */
+        if (fstat (root_fd, &statbuf) == -1 || statbuf.st_uid != getuid ())
+        {
+            close (root_fd);
+            continue;
+        }
+
+        files_fd = openat (root_fd, "files", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        info_fd = openat (root_fd, "info", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        /* The cached directory sizes would only be stale now. */
+        unlinkat (root_fd, "directorysizes", 0);
+        close (root_fd);
+
+        if (files_fd == -1)
+        {
+            if (info_fd != -1)
+            {
+                close (info_fd);
+            }
+            continue;
+        }
+        root.files_fd = files_fd;
+        root.info_fd = info_fd;
+        g_array_append_val (roots, root);
+
+        fd = dup (files_fd);
+        dir = (fd != -1) ? fdopendir (fd) : NULL;
+        if (dir == NULL)
+        {
+            if (fd != -1)
+            {
+                close (fd);
+            }
+            continue;
+        }
+
+        while ((entry = readdir (dir)) != NULL)
+        {
+            TrashItem *item;
+
+            if (strcmp (entry->d_name, ".") == 0 ||
+                strcmp (entry->d_name, "..") == 0)
+            {
+                continue;
+            }
+
+            item = g_new (TrashItem, 1);
+            item->files_fd = files_fd;
+            item->info_fd = info_fd;
+            item->name = g_strdup (entry->d_name);
+            item->type = entry->d_type;
+            g_ptr_array_add (items, item);
+        }
+        closedir (dir);
+    }
+
+    if (items->len > 0)
+    {
+        state.cancellable = common->cancellable;
+        state.n_pending = items->len;
+        g_mutex_init (&state.mutex);
+        g_cond_init (&state.cond);
+
+        n_threads = CLAMP (g_get_num_processors (), 1, MAX_EMPTY_TRASH_THREADS);
+        pool = g_thread_pool_new (empty_trash_item_func, &state, n_threads, FALSE, NULL);
+        for (guint i = 0; i < items->len; i++)
+        {
+            g_thread_pool_push (pool, g_ptr_array_index (items, i), NULL);
+        }
+
+        g_mutex_lock (&state.mutex);
+        while (state.n_pending > 0)
+        {
+            guint n_done = items->len - state.n_pending;
+
+            g_mutex_unlock (&state.mutex);
+            report_empty_trash_progress (common, n_done, items->len);
+            g_mutex_lock (&state.mutex);
+
+            /* The workers only signal when they are all done. */
+            deadline = g_get_monotonic_time () + 100 * G_TIME_SPAN_MILLISECOND;
+            while (state.n_pending > 0 &&
+                   g_cond_wait_until (&state.cond, &state.mutex, deadline))
+            {
+                /* Spurious wakeup, keep waiting until the deadline. */
+            }
+        }
+        g_mutex_unlock (&state.mutex);
+        report_empty_trash_progress (common, items->len, items->len);
+
+        g_thread_pool_free (pool, FALSE, TRUE);
+        g_mutex_clear (&state.mutex);
+        g_cond_clear (&state.cond);
+    }
+
+    for (guint i = 0; i < roots->len; i++)
+    {
+        TrashRoot *root = &g_array_index (roots, TrashRoot, i);
+
+        if (root->info_fd != -1)
+        {
+            if (!job_aborted (common))
+            {
+                remove_orphan_trash_infos (root->files_fd, root->info_fd);
+            }
+            close (root->info_fd);
+        }
+        close (root->files_fd);
+    }
+}
+
 static void
 empty_trash_task_done (GObject      *source_object,
                        GAsyncResult *res,
@@ -7797,6 +8359,7 @@ empty_trash_task_done (GObject      *source_object,
     job = user_data;
 
     g_list_free_full (job->trash_dirs, g_object_unref);
+    g_list_free_full (job->local_trash_roots, g_object_unref);
 
     if (job->done_callback)
     {
@@ -7832,6 +8395,10 @@ empty_trash_thread_func (GTask        *task,
     }
     if (confirmed)
     {
+        nautilus_progress_info_set_status (job->common.progress, _("Emptying Trash"));
+
+        empty_local_trash (job);
+
         for (l = job->trash_dirs;
              l != NULL && !job_aborted (common);
              l = l->next)
@@ -7859,6 +8426,7 @@ nautilus_file_operations_empty_trash (GtkWidget                      *parent_vie
     job = op_job_new (EmptyTrashJob, parent_window, dbus_data);
     job->trash_dirs = g_list_prepend (job->trash_dirs,
                                       g_file_new_for_uri (SCHEME_TRASH ":"));
+    job->local_trash_roots = get_local_trash_roots ();
     job->should_confirm = ask_confirmation;
 
     inhibit_power_manager ((CommonJob *) job, _("Emptying Trash"));
@@ -7885,44 +8453,95 @@ extract_task_done (GObject      *source_object,
 
     g_list_free_full (extract_job->source_files, g_object_unref);
     g_list_free_full (extract_job->output_files, g_object_unref);
+    g_ptr_array_unref (extract_job->archives);
     g_object_unref (extract_job->destination_directory);
+    g_mutex_clear (&extract_job->lock);
+    g_mutex_clear (&extract_job->dialog_lock);
 
     finalize_common ((CommonJob *) extract_job);
 
     nautilus_file_changes_consume_changes ();
 }
 
+/* Call with the job lock held. */
+static gboolean
+is_decided_destination (ExtractJob *extract_job,
+                        GFile      *file)
+{
+    for (GList *l = extract_job->output_files; l != NULL; l = l->next)
+    {
+        if (g_file_equal (l->data, file))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static gboolean
+is_decided_destination_locked (GFile    *file,
+                               gpointer  user_data)
+{
+    ExtractJob *extract_job = user_data;
+    gboolean decided;
+
+    g_mutex_lock (&extract_job->lock);
+    decided = is_decided_destination (extract_job, file);
+    g_mutex_unlock (&extract_job->lock);
+
+    return decided;
+}
+
 static GFile *
 extract_job_on_decide_destination (AutoarExtractor *extractor,
                                    GFile           *destination,
                                    GList           *files,
                                    gpointer         user_data)
 {
-    ExtractJob *extract_job = user_data;
-    GFile *decided_destination;
+    ExtractArchive *archive = user_data;
+    ExtractJob *extract_job = archive->job;
+    GFile *decided_destination = NULL;
     g_autofree char *basename = NULL;
 
     nautilus_progress_info_set_details (extract_job->common.progress,
                                         _("Verifying destination"));
 
     basename = g_file_get_basename (destination);
-    decided_destination = nautilus_generate_unique_file_in_directory (extract_job->destination_directory,
-                                                                      basename);
 
-    if (job_aborted ((CommonJob *) extract_job))
+    /* Another archive extracted at the same time may have decided on the
+     * same name without having created it yet. The lock is only held to
+     * check and record the name, so that another archive may take it in
+     * between, and then the next free name is looked for. */
+    while (decided_destination == NULL)
     {
-        g_object_unref (decided_destination);
-        return NULL;
-    }
+        GFile *candidate;
 
-    /* The extract_job->destination_decided variable signalizes whether the
-     * extract_job->output_files list already contains the final location as
-     * its first link. There is no way to get this over the AutoarExtractor
-     * API currently.
-     */
-    extract_job->output_files = g_list_prepend (extract_job->output_files,
-                                                decided_destination);
-    extract_job->destination_decided = TRUE;
+        candidate = nautilus_generate_unique_file_in_directory_full (extract_job->destination_directory,
+                                                                     basename,
+                                                                     is_decided_destination_locked,
+                                                                     extract_job);
+        if (candidate == NULL || job_aborted ((CommonJob *) extract_job))
+        {
+            g_clear_object (&candidate);
+            return NULL;
+        }
+
+        g_mutex_lock (&extract_job->lock);
+        if (!is_decided_destination (extract_job, candidate))
+        {
+            decided_destination = candidate;
+            extract_job->output_files = g_list_prepend (extract_job->output_files,
+                                                        decided_destination);
+            archive->destination = decided_destination;
+        }
+        g_mutex_unlock (&extract_job->lock);
+
+        if (decided_destination == NULL)
+        {
+            g_object_unref (candidate);
+        }
+    }
 
     return g_object_ref (decided_destination);
 }
@@ -7933,17 +8552,17 @@ extract_job_on_progress (AutoarExtractor *extractor,
                          guint            archive_current_decompressed_files,
                          gpointer         user_data)
 {
-    ExtractJob *extract_job = user_data;
-    CommonJob *common = user_data;
+    ExtractArchive *archive = user_data;
+    ExtractJob *extract_job = archive->job;
+    CommonJob *common = (CommonJob *) extract_job;
     GFile *source_file;
     char *details;
     double elapsed;
     double transfer_rate;
     int remaining_time;
     guint64 archive_total_decompressed_size;
-    gdouble archive_weight;
-    gdouble archive_decompress_progress;
     guint64 job_completed_size;
+    guint64 total_compressed_size;
     gdouble job_progress;
     g_autofree gchar *basename = NULL;
     g_autofree gchar *formatted_size_job_completed_size = NULL;
@@ -7958,37 +8577,48 @@ extract_job_on_progress (AutoarExtractor *extractor,
 
     archive_total_decompressed_size = autoar_extractor_get_total_size (extractor);
 
-    archive_decompress_progress = (gdouble) archive_current_decompressed_size /
-                                  (gdouble) archive_total_decompressed_size;
+    /* The progress of the job is that of all its archives, weighted by
+     * their compressed size. */
+    g_mutex_lock (&extract_job->lock);
+    archive->progress = (gdouble) archive_current_decompressed_size /
+                        (gdouble) archive_total_decompressed_size;
 
-    archive_weight = 0;
-    if (extract_job->total_compressed_size)
+    job_completed_size = 0;
+    for (guint i = 0; i < extract_job->archives->len; i++)
     {
-        archive_weight = (gdouble) extract_job->archive_compressed_size /
-                         (gdouble) extract_job->total_compressed_size;
+        ExtractArchive *other = g_ptr_array_index (extract_job->archives, i);
+
+        if (!other->failed)
+        {
+            job_completed_size += other->progress * other->compressed_size;
+        }
     }
+    total_compressed_size = extract_job->total_compressed_size;
+    g_mutex_unlock (&extract_job->lock);
 
-    job_progress = archive_decompress_progress * archive_weight + extract_job->base_progress;
+    job_progress = 0;
+    if (total_compressed_size)
+    {
+        job_progress = (gdouble) job_completed_size / (gdouble) total_compressed_size;
+    }
 
     elapsed = g_timer_elapsed (common->time, NULL);
 
     transfer_rate = 0;
     remaining_time = -1;
 
-    job_completed_size = job_progress * extract_job->total_compressed_size;
-
     if (elapsed > 0)
     {
         transfer_rate = job_completed_size / elapsed;
     }
     if (transfer_rate > 0)
     {
-        remaining_time = (extract_job->total_compressed_size - job_completed_size) /
+        remaining_time = (total_compressed_size - job_completed_size) /
                          transfer_rate;
     }
 
     formatted_size_job_completed_size = g_format_size (job_completed_size);
-    formatted_size_total_compressed_size = g_format_size (extract_job->total_compressed_size);
+    formatted_size_total_compressed_size = g_format_size (total_compressed_size);
     if (elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE ||
         transfer_rate == 0)
     {
@@ -8040,9 +8670,10 @@ extract_job_on_error (AutoarExtractor *extractor,
                       GError          *error,
                       gpointer         user_data)
 {
-    ExtractJob *extract_job = user_data;
+    ExtractArchive *archive = user_data;
+    ExtractJob *extract_job = archive->job;
     GFile *source_file;
-    GFile *destination;
+    g_autoptr (GFile) destination = NULL;
     gint response_id;
     gint remaining_files;
     g_autofree gchar *basename = NULL;
@@ -8051,29 +8682,34 @@ extract_job_on_error (AutoarExtractor *extractor,
 
     if (IS_IO_ERROR (error, NOT_SUPPORTED))
     {
+        g_mutex_lock (&extract_job->dialog_lock);
         handle_unsupported_compressed_file (extract_job->common.parent_window,
                                             source_file);
+        g_mutex_unlock (&extract_job->dialog_lock);
 
         return;
     }
 
-    extract_job->extraction_failed = TRUE;
+    g_mutex_lock (&extract_job->lock);
+    archive->failed = TRUE;
+    if (archive->destination != NULL)
+    {
+        destination = g_steal_pointer (&archive->destination);
+        extract_job->output_files = g_list_remove (extract_job->output_files,
+                                                   destination);
+    }
+    g_mutex_unlock (&extract_job->lock);
 
-    /* It is safe to use extract_job->output_files->data only when the
-     * extract_job->destination_decided variable was set, see comment in the
-     * extract_job_on_decide_destination function.
-     */
-    if (extract_job->destination_decided)
+    if (destination != NULL)
     {
-        destination = extract_job->output_files->data;
         delete_file_recursively (destination, NULL, NULL, NULL);
-        extract_job->output_files = g_list_delete_link (extract_job->output_files,
-                                                        extract_job->output_files);
-        g_object_unref (destination);
     }
 
-    if (extract_job->common.skip_all_error)
+    g_mutex_lock (&extract_job->dialog_lock);
+
+    if (extract_job->common.skip_all_error || job_aborted ((CommonJob *) extract_job))
     {
+        g_mutex_unlock (&extract_job->dialog_lock);
         return;
     }
 
@@ -8082,9 +8718,8 @@ extract_job_on_error (AutoarExtractor *extractor,
                                         g_strdup_printf (_("Error extracting “%s”"),
                                                          basename));
 
-    remaining_files = g_list_length (g_list_find_custom (extract_job->source_files,
-                                                         source_file,
-                                                         (GCompareFunc) g_file_equal)) - 1;
+    remaining_files = g_list_length (g_list_find (extract_job->source_files,
+                                                  archive->source_file)) - 1;
     response_id = run_cancel_or_skip_warning ((CommonJob *) extract_job,
                                               g_strdup_printf (_("There was an error while extracting “%s”."),
                                                                basename),
@@ -8101,25 +8736,25 @@ extract_job_on_error (AutoarExtractor *extractor,
     {
         extract_job->common.skip_all_error = TRUE;
     }
+
+    g_mutex_unlock (&extract_job->dialog_lock);
 }
 
 static void
 extract_job_on_completed (AutoarExtractor *extractor,
                           gpointer         user_data)
 {
-    ExtractJob *extract_job = user_data;
-    GFile *output_file;
+    ExtractArchive *archive = user_data;
 
-    output_file = G_FILE (extract_job->output_files->data);
-
-    nautilus_file_changes_queue_file_added (output_file);
+    nautilus_file_changes_queue_file_added (archive->destination);
 }
 
 static gchar *
 extract_job_on_request_passphrase (AutoarExtractor *extractor,
                                    gpointer         user_data)
 {
-    ExtractJob *extract_job = user_data;
+    ExtractArchive *archive = user_data;
+    ExtractJob *extract_job = archive->job;
     GtkWindow *parent_window;
     GFile *source_file;
     g_autofree gchar *basename = NULL;
@@ -8129,7 +8764,9 @@ extract_job_on_request_passphrase (AutoarExtractor *extractor,
     source_file = autoar_extractor_get_source_file (extractor);
     basename = get_basename (source_file);
 
+    g_mutex_lock (&extract_job->dialog_lock);
     passphrase = extract_ask_passphrase (parent_window, basename);
+    g_mutex_unlock (&extract_job->dialog_lock);
     if (passphrase == NULL)
     {
         abort_job ((CommonJob *) extract_job);
@@ -8144,13 +8781,13 @@ extract_job_on_scanned (AutoarExtractor *extractor,
                         gpointer         user_data)
 {
     guint64 total_size;
-    ExtractJob *extract_job;
+    ExtractArchive *archive = user_data;
+    ExtractJob *extract_job = archive->job;
     GFile *source_file;
     g_autofree gchar *basename = NULL;
     g_autoptr (GFileInfo) fsinfo = NULL;
     guint64 free_size;
 
-    extract_job = user_data;
     total_size = autoar_extractor_get_total_size (extractor);
     source_file = autoar_extractor_get_source_file (extractor);
     basename = get_basename (source_file);
@@ -8168,18 +8805,23 @@ extract_job_on_scanned (AutoarExtractor *extractor,
      */
     if (total_size != G_MAXUINT64 && total_size > free_size)
     {
-        nautilus_progress_info_take_status (extract_job->common.progress,
-                                            g_strdup_printf (_("Error extracting “%s”"),
-                                                             basename));
-        run_error (&extract_job->common,
-                   g_strdup_printf (_("Not enough free space to extract “%s”"), basename),
-                   NULL,
-                   NULL,
-                   FALSE,
-                   CANCEL,
-                   NULL);
+        g_mutex_lock (&extract_job->dialog_lock);
+        if (!job_aborted ((CommonJob *) extract_job))
+        {
+            nautilus_progress_info_take_status (extract_job->common.progress,
+                                                g_strdup_printf (_("Error extracting “%s”"),
+                                                                 basename));
+            run_error (&extract_job->common,
+                       g_strdup_printf (_("Not enough free space to extract “%s”"), basename),
+                       NULL,
+                       NULL,
+                       FALSE,
+                       CANCEL,
+                       NULL);
 
-        abort_job ((CommonJob *) extract_job);
+            abort_job ((CommonJob *) extract_job);
+        }
+        g_mutex_unlock (&extract_job->dialog_lock);
     }
 }
 
@@ -8229,6 +8871,66 @@ report_extract_final_progress (ExtractJob *extract_job)
     nautilus_progress_info_set_progress (extract_job->common.progress, 1, 1);
 }
 
+/* Extracting an archive mostly keeps one core busy decompressing, so a
+ * few archives are extracted at the same time when several are selected. */
+#define MAX_PARALLEL_EXTRACTIONS 4
+
+static void
+extract_archive_func (gpointer data,
+                      gpointer user_data)
+{
+    ExtractArchive *archive = data;
+    ExtractJob *extract_job = archive->job;
+    g_autoptr (AutoarExtractor) extractor = NULL;
+
+    if (job_aborted ((CommonJob *) extract_job))
+    {
+        return;
+    }
+
+    extractor = autoar_extractor_new (archive->source_file,
+                                      extract_job->destination_directory);
+
+    autoar_extractor_set_notify_interval (extractor,
+                                          PROGRESS_NOTIFY_INTERVAL);
+    g_signal_connect (extractor, "scanned",
+                      G_CALLBACK (extract_job_on_scanned),
+                      archive);
+    g_signal_connect (extractor, "error",
+                      G_CALLBACK (extract_job_on_error),
+                      archive);
+    g_signal_connect (extractor, "decide-destination",
+                      G_CALLBACK (extract_job_on_decide_destination),
+                      archive);
+    g_signal_connect (extractor, "progress",
+                      G_CALLBACK (extract_job_on_progress),
+                      archive);
+    g_signal_connect (extractor, "completed",
+                      G_CALLBACK (extract_job_on_completed),
+                      archive);
+    g_signal_connect (extractor, "request-passphrase",
+                      G_CALLBACK (extract_job_on_request_passphrase),
+                      archive);
+
+    autoar_extractor_start (extractor,
+                            extract_job->common.cancellable);
+
+    g_signal_handlers_disconnect_by_data (extractor,
+                                          archive);
+
+    g_mutex_lock (&extract_job->lock);
+    if (!archive->failed)
+    {
+        archive->progress = 1;
+    }
+    else
+    {
+        extract_job->total_files--;
+        extract_job->total_compressed_size -= archive->compressed_size;
+    }
+    g_mutex_unlock (&extract_job->lock);
+}
+
 static void
 extract_task_thread_func (GTask        *task,
                           gpointer      source_object,
@@ -8237,8 +8939,6 @@ extract_task_thread_func (GTask        *task,
 {
     ExtractJob *extract_job = task_data;
     GList *l;
-    g_autofree guint64 *archive_compressed_sizes = NULL;
-    gint i;
 
     g_timer_start (extract_job->common.time);
 
@@ -8248,20 +8948,21 @@ extract_task_thread_func (GTask        *task,
                                         _("Preparing to extract"));
 
     extract_job->total_files = g_list_length (extract_job->source_files);
-
-    archive_compressed_sizes = g_malloc0_n (extract_job->total_files,
-                                            sizeof (guint64));
     extract_job->total_compressed_size = 0;
 
-    for (l = extract_job->source_files, i = 0;
+    for (l = extract_job->source_files;
          l != NULL && !job_aborted ((CommonJob *) extract_job);
-         l = l->next, i++)
+         l = l->next)
     {
-        GFile *source_file;
+        ExtractArchive *archive;
         g_autoptr (GFileInfo) info = NULL;
 
-        source_file = G_FILE (l->data);
-        info = g_file_query_info (source_file,
+        archive = g_new0 (ExtractArchive, 1);
+        archive->job = extract_job;
+        archive->source_file = G_FILE (l->data);
+        g_ptr_array_add (extract_job->archives, archive);
+
+        info = g_file_query_info (archive->source_file,
                                   G_FILE_ATTRIBUTE_STANDARD_SIZE,
                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                   extract_job->common.cancellable,
@@ -8269,65 +8970,30 @@ extract_task_thread_func (GTask        *task,
 
         if (info)
         {
-            archive_compressed_sizes[i] = g_file_info_get_size (info);
-            extract_job->total_compressed_size += archive_compressed_sizes[i];
+            archive->compressed_size = g_file_info_get_size (info);
+            extract_job->total_compressed_size += archive->compressed_size;
         }
     }
 
-    extract_job->base_progress = 0;
+    if (extract_job->archives->len == 1)
+    {
+        extract_archive_func (g_ptr_array_index (extract_job->archives, 0), NULL);
+    }
+    else if (extract_job->archives->len > 1)
+    {
+        GThreadPool *pool;
+        guint n_threads;
 
-    for (l = extract_job->source_files, i = 0;
-         l != NULL && !job_aborted ((CommonJob *) extract_job);
-         l = l->next, i++)
-    {
-        g_autoptr (AutoarExtractor) extractor = NULL;
-
-        extractor = autoar_extractor_new (G_FILE (l->data),
-                                          extract_job->destination_directory);
-
-        autoar_extractor_set_notify_interval (extractor,
-                                              PROGRESS_NOTIFY_INTERVAL);
-        g_signal_connect (extractor, "scanned",
-                          G_CALLBACK (extract_job_on_scanned),
-                          extract_job);
-        g_signal_connect (extractor, "error",
-                          G_CALLBACK (extract_job_on_error),
-                          extract_job);
-        g_signal_connect (extractor, "decide-destination",
-                          G_CALLBACK (extract_job_on_decide_destination),
-                          extract_job);
-        g_signal_connect (extractor, "progress",
-                          G_CALLBACK (extract_job_on_progress),
-                          extract_job);
-        g_signal_connect (extractor, "completed",
-                          G_CALLBACK (extract_job_on_completed),
-                          extract_job);
-        g_signal_connect (extractor, "request-passphrase",
-                          G_CALLBACK (extract_job_on_request_passphrase),
-                          extract_job);
-
-        extract_job->archive_compressed_size = archive_compressed_sizes[i];
-        extract_job->destination_decided = FALSE;
-        extract_job->extraction_failed = FALSE;
-
-        autoar_extractor_start (extractor,
-                                extract_job->common.cancellable);
-
-        g_signal_handlers_disconnect_by_data (extractor,
-                                              extract_job);
-
-        if (!extract_job->extraction_failed)
-        {
-            extract_job->base_progress += (gdouble) extract_job->archive_compressed_size /
-                                          (gdouble) extract_job->total_compressed_size;
-        }
-        else
+        n_threads = CLAMP (g_get_num_processors (), 1, MAX_PARALLEL_EXTRACTIONS);
+        pool = g_thread_pool_new (extract_archive_func, NULL,
+                                  MIN (n_threads, extract_job->archives->len),
+                                  FALSE, NULL);
+        /* Archives start in the order they were selected. */
+        for (guint i = 0; i < extract_job->archives->len; i++)
         {
-            extract_job->total_files--;
-            extract_job->base_progress *= extract_job->total_compressed_size;
-            extract_job->total_compressed_size -= extract_job->archive_compressed_size;
-            extract_job->base_progress /= extract_job->total_compressed_size;
+            g_thread_pool_push (pool, g_ptr_array_index (extract_job->archives, i), NULL);
         }
+        g_thread_pool_free (pool, FALSE, TRUE);
     }
 
     if (!job_aborted ((CommonJob *) extract_job))
@@ -8370,10 +9036,16 @@ nautilus_file_operations_extract_files (GList                          *files,
                                                   (GCopyFunc) g_object_ref,
                                                   NULL);
     extract_job->destination_directory = g_object_ref (destination_directory);
+    extract_job->archives = g_ptr_array_new_with_free_func (g_free);
+    g_mutex_init (&extract_job->lock);
+    g_mutex_init (&extract_job->dialog_lock);
     extract_job->done_callback = done_callback;
     extract_job->done_callback_data = done_callback_data;
 
-    inhibit_power_manager ((CommonJob *) extract_job, _("Extracting Files"));
+    if (g_strcmp0 (g_getenv ("RUNNING_TESTS"), "TRUE"))
+    {
+        inhibit_power_manager ((CommonJob *) extract_job, _("Extracting Files"));
+    }
 
     if (!nautilus_file_undo_manager_is_operating ())
     {
@@ -8753,7 +9425,10 @@ nautilus_file_operations_compress (GList                          *files,
     compress_job->done_callback = done_callback;
     compress_job->done_callback_data = done_callback_data;
 
-    inhibit_power_manager ((CommonJob *) compress_job, _("Compressing Files"));
+    if (g_strcmp0 (g_getenv ("RUNNING_TESTS"), "TRUE"))
+    {
+        inhibit_power_manager ((CommonJob *) compress_job, _("Compressing Files"));
+    }
 
     if (!nautilus_file_undo_manager_is_operating ())
     {
@@ -26,8 +26,22 @@
 #include "nautilus-monitor.h"
 #include "nautilus-file-undo-operations.h"
 
+#define NAUTILUS_FILE_BASIC_ATTRIBUTES					\
+	"standard::*,access::*,mountable::*,time::*,unix::*,owner::*,id::filesystem,trash::orig-path,trash::deletion-date,recent::*,preview::icon"
+
+/* Each of these costs a lookup of its own per file: the selinux context
+ * is an xattr, and the thumbnail path hashes the uri and stats the
+ * thumbnail cache. Owner names are basic, since the owner and group
+ * columns sort by them.
+ */
+#define NAUTILUS_FILE_EXTENDED_ATTRIBUTES				\
+	"selinux::*,thumbnail::*"
+
+#define NAUTILUS_FILE_DEFAULT_ATTRIBUTES_WITHOUT_METADATA		\
+	NAUTILUS_FILE_BASIC_ATTRIBUTES "," NAUTILUS_FILE_EXTENDED_ATTRIBUTES
+
 #define NAUTILUS_FILE_DEFAULT_ATTRIBUTES				\
-	"standard::*,access::*,mountable::*,time::*,unix::*,owner::*,selinux::*,thumbnail::*,id::filesystem,trash::orig-path,trash::deletion-date,metadata::*,recent::*,preview::icon"
+	NAUTILUS_FILE_DEFAULT_ATTRIBUTES_WITHOUT_METADATA ",metadata::*"
 
 /* These are in the typical sort order. Known things come first, then
  * things where we can't know, finally things where we don't yet know.
@@ -44,6 +58,14 @@ struct NautilusFilePrivate
 	
 	GRefString *name;
 
+	/* Computed on first use, and dropped when the name changes. The
+	 * location of the directory it was computed from is kept, so that it
+	 * is recomputed when the directory moves.
+	 */
+	GFile *location;
+	GFile *location_parent;
+	char *uri;
+
 	/* File info: */
 	GFileType type;
 
@@ -141,6 +163,15 @@ struct NautilusFilePrivate
 	guint got_file_info                 : 1;
 	guint get_info_failed               : 1;
 	guint file_info_is_up_to_date       : 1;
+	/* Set when the file info was loaded without metadata::*, which
+	 * the directory then fetches for all of its files at once.
+	 */
+	guint metadata_is_deferred          : 1;
+	/* Set when the file info was loaded with only the basic
+	 * attributes; the extended ones are fetched for the files that
+	 * ask for NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO.
+	 */
+	guint extended_info_is_deferred     : 1;
 	
 	guint got_directory_count           : 1;
 	guint directory_count_failed        : 1;
@@ -160,6 +191,11 @@ struct NautilusFilePrivate
 	
 	guint is_thumbnailing               : 1;
 
+	/* Looked up from the tag manager on first use, and then kept up to
+	 * date by it. */
+	guint is_starred                    : 1;
+	guint starred_is_up_to_date         : 1;
+
 	guint is_symlink                    : 1;
 	guint is_mountpoint                 : 1;
 	guint is_hidden                     : 1;
@@ -237,6 +273,8 @@ gboolean      nautilus_file_update_name                    (NautilusFile
 							    const char             *name);
 gboolean      nautilus_file_update_metadata_from_info      (NautilusFile           *file,
 							    GFileInfo              *info);
+void          nautilus_file_mark_info_deferred             (GFileInfo              *info,
+							    NautilusFileAttributes  deferred_attributes);
 
 gboolean      nautilus_file_update_name_and_directory      (NautilusFile           *file,
 							    const char             *name,
@@ -272,6 +310,10 @@ void          nautilus_file_set_is_thumbnailing            (NautilusFile
 gboolean          nautilus_file_set_thumbnail              (NautilusFile           *file,
                                                             GdkPixbuf              *pixbuf);
 
+/* Starring: */
+void          nautilus_file_set_is_starred                 (NautilusFile           *file,
+							    gboolean                is_starred);
+
 NautilusFileOperation *nautilus_file_operation_new      (NautilusFile                  *file,
 							 NautilusFileOperationCallback  callback,
 							 gpointer                       callback_data);
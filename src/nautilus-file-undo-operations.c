@@ -22,6 +22,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "nautilus-file-undo-operations.h"
 
@@ -1909,7 +1910,13 @@ struct _NautilusFileUndoInfoRecPermissions
     NautilusFileUndoInfo parent_instance;
 
     GFile *dest_dir;
-    GHashTable *original_permissions;
+    /* Original modes of the changed files, as a sequence of entries:
+     * guint32 mode, guint32 length of the prefix shared with the previous
+     * path, then the rest of the path relative to dest_dir, nul-terminated.
+     * Files are added in walk order, so consecutive paths share a lot. */
+    GByteArray *original_permissions;
+    GString *last_added_path;
+    guint n_original_permissions;
     guint32 dir_mask;
     guint32 dir_permissions;
     guint32 file_mask;
@@ -1970,38 +1977,42 @@ rec_permissions_undo_func (NautilusFileUndoInfo           *info,
                            NautilusFileOperationsDBusData *dbus_data)
 {
     NautilusFileUndoInfoRecPermissions *self = NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (info);
+    g_autoptr (GString) path = g_string_new (NULL);
+    const guint8 *data = self->original_permissions->data;
+    gsize offset = 0;
 
-    if (g_hash_table_size (self->original_permissions) > 0)
+    for (guint i = 0; i < self->n_original_permissions; i++)
     {
-        GList *gfiles_list;
+        g_autoptr (GFile) dest = NULL;
         guint32 perm;
-        GList *l;
-        GFile *dest;
-        char *item;
+        guint32 prefix_length;
+        const gchar *suffix;
 
-        gfiles_list = g_hash_table_get_keys (self->original_permissions);
-        for (l = gfiles_list; l != NULL; l = l->next)
-        {
-            item = l->data;
-            perm = GPOINTER_TO_UINT (g_hash_table_lookup (self->original_permissions, item));
-            dest = g_file_new_for_uri (item);
-            g_file_set_attribute_uint32 (dest,
-                                         G_FILE_ATTRIBUTE_UNIX_MODE,
-                                         perm, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
-            g_object_unref (dest);
-        }
+        memcpy (&perm, data + offset, sizeof (guint32));
+        offset += sizeof (guint32);
+        memcpy (&prefix_length, data + offset, sizeof (guint32));
+        offset += sizeof (guint32);
+        suffix = (const gchar *) data + offset;
+        offset += strlen (suffix) + 1;
 
-        g_list_free (gfiles_list);
-        /* Here we must do what's necessary for the callback */
-        file_undo_info_transfer_callback (NULL, TRUE, self);
+        g_string_truncate (path, prefix_length);
+        g_string_append (path, suffix);
+
+        dest = g_file_resolve_relative_path (self->dest_dir, path->str);
+        g_file_set_attribute_uint32 (dest,
+                                     G_FILE_ATTRIBUTE_UNIX_MODE,
+                                     perm, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
     }
+
+    /* Here we must do what's necessary for the callback */
+    file_undo_info_transfer_callback (NULL, TRUE, self);
 }
 
 static void
 nautilus_file_undo_info_rec_permissions_init (NautilusFileUndoInfoRecPermissions *self)
 {
-    self->original_permissions = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                        g_free, NULL);
+    self->original_permissions = g_byte_array_new ();
+    self->last_added_path = g_string_new (NULL);
 }
 
 static void
@@ -2009,7 +2020,8 @@ nautilus_file_undo_info_rec_permissions_finalize (GObject *obj)
 {
     NautilusFileUndoInfoRecPermissions *self = NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (obj);
 
-    g_hash_table_destroy (self->original_permissions);
+    g_byte_array_unref (self->original_permissions);
+    g_string_free (self->last_added_path, TRUE);
     g_clear_object (&self->dest_dir);
 
     G_OBJECT_CLASS (nautilus_file_undo_info_rec_permissions_parent_class)->finalize (obj);
@@ -2051,13 +2063,29 @@ nautilus_file_undo_info_rec_permissions_new (GFile   *dest,
     return NAUTILUS_FILE_UNDO_INFO (self);
 }
 
+/* @relative_path is relative to the directory the operation was applied to. */
 void
 nautilus_file_undo_info_rec_permissions_add_file (NautilusFileUndoInfoRecPermissions *self,
-                                                  GFile                              *file,
+                                                  const gchar                        *relative_path,
                                                   guint32                             permission)
 {
-    gchar *original_uri = g_file_get_uri (file);
-    g_hash_table_insert (self->original_permissions, original_uri, GUINT_TO_POINTER (permission));
+    guint32 prefix_length = 0;
+    const gchar *suffix;
+
+    while (relative_path[prefix_length] != '\0' &&
+           relative_path[prefix_length] == self->last_added_path->str[prefix_length])
+    {
+        prefix_length++;
+    }
+    suffix = relative_path + prefix_length;
+
+    g_byte_array_append (self->original_permissions, (const guint8 *) &permission, sizeof (guint32));
+    g_byte_array_append (self->original_permissions, (const guint8 *) &prefix_length, sizeof (guint32));
+    g_byte_array_append (self->original_permissions, (const guint8 *) suffix, strlen (suffix) + 1);
+    self->n_original_permissions++;
+
+    g_string_truncate (self->last_added_path, prefix_length);
+    g_string_append (self->last_added_path, suffix);
 }
 
 /* single file change permissions */
@@ -182,7 +182,7 @@ NautilusFileUndoInfo *nautilus_file_undo_info_rec_permissions_new (GFile   *dest
                                                                    guint32 dir_permissions,
                                                                    guint32 dir_mask);
 void nautilus_file_undo_info_rec_permissions_add_file (NautilusFileUndoInfoRecPermissions *self,
-                                                       GFile                              *file,
+                                                       const gchar                        *relative_path,
                                                        guint32                             permission);
 
 /* single file change permissions */
@@ -266,6 +266,15 @@ nautilus_get_mounted_mount_for_root (GFile *location)
 GFile *
 nautilus_generate_unique_file_in_directory (GFile      *directory,
                                             const char *basename)
+{
+    return nautilus_generate_unique_file_in_directory_full (directory, basename, NULL, NULL);
+}
+
+GFile *
+nautilus_generate_unique_file_in_directory_full (GFile                   *directory,
+                                                 const char              *basename,
+                                                 NautilusFileIsTakenFunc  is_taken,
+                                                 gpointer                 user_data)
 {
     g_return_val_if_fail (directory != NULL, NULL);
     g_return_val_if_fail (basename != NULL, NULL);
@@ -273,7 +282,10 @@ nautilus_generate_unique_file_in_directory (GFile      *directory,
 
     GFile *child = g_file_get_child (directory, basename);
 
-    for (size_t counter = 1; g_file_query_exists (child, NULL); counter += 1)
+    for (size_t counter = 1;
+         g_file_query_exists (child, NULL) ||
+         (is_taken != NULL && is_taken (child, user_data));
+         counter += 1)
     {
         g_autofree char *filename = nautilus_filename_for_conflict (basename, counter, -1, FALSE);
 
@@ -475,6 +487,8 @@ locations_from_file_list (GList *file_list)
 typedef struct
 {
     GHashTable *original_dirs_hash;
+    /* Taken on the main thread, for the thread that creates them. */
+    GList *original_dir_locations;
     GtkWindow *parent_window;
 } RestoreFilesData;
 
@@ -509,6 +523,7 @@ ensure_dirs_task_ready_cb (GObject      *_source,
     g_list_free (original_dirs);
 
     g_hash_table_unref (data->original_dirs_hash);
+    g_list_free_full (data->original_dir_locations, g_object_unref);
     g_slice_free (RestoreFilesData, data);
 }
 
@@ -519,17 +534,10 @@ ensure_dirs_task_thread_func (GTask        *task,
                               GCancellable *cancellable)
 {
     RestoreFilesData *data = task_data;
-    NautilusFile *original_dir;
-    GFile *original_dir_location;
-    g_autoptr (GList) original_dirs = g_hash_table_get_keys (data->original_dirs_hash);
 
-    for (GList *l = original_dirs; l != NULL; l = l->next)
+    for (GList *l = data->original_dir_locations; l != NULL; l = l->next)
     {
-        original_dir = NAUTILUS_FILE (l->data);
-        original_dir_location = nautilus_file_get_location (original_dir);
-
-        g_file_make_directory_with_parents (original_dir_location, cancellable, NULL);
-        g_object_unref (original_dir_location);
+        g_file_make_directory_with_parents (l->data, cancellable, NULL);
     }
 
     g_task_return_pointer (task, NULL, NULL);
@@ -541,11 +549,19 @@ restore_files_ensure_parent_directories (GHashTable *original_dirs_hash,
 {
     RestoreFilesData *data;
     GTask *ensure_dirs_task;
+    g_autoptr (GList) original_dirs = g_hash_table_get_keys (original_dirs_hash);
 
     data = g_slice_new0 (RestoreFilesData);
     data->parent_window = parent_window;
     data->original_dirs_hash = g_hash_table_ref (original_dirs_hash);
 
+    /* NautilusFile is not thread safe, so don't touch the files in the task. */
+    for (GList *l = original_dirs; l != NULL; l = l->next)
+    {
+        data->original_dir_locations = g_list_prepend (data->original_dir_locations,
+                                                       nautilus_file_get_location (l->data));
+    }
+
     ensure_dirs_task = g_task_new (NULL, NULL, ensure_dirs_task_ready_cb, data);
     g_task_set_task_data (ensure_dirs_task, data, NULL);
     g_task_run_in_thread (ensure_dirs_task, ensure_dirs_task_thread_func);
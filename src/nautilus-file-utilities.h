@@ -62,6 +62,19 @@ GIcon *  nautilus_special_directory_get_symbolic_icon (GUserDirectory directory)
 GFile * nautilus_generate_unique_file_in_directory (GFile      *directory,
                                                     const char *basename);
 
+/* Returns TRUE if @file must not be used, even though it doesn't exist. */
+typedef gboolean (* NautilusFileIsTakenFunc) (GFile    *file,
+                                              gpointer  user_data);
+
+/* Like nautilus_generate_unique_file_in_directory(), but also skips the
+ * locations @is_taken returns TRUE for, e.g. ones that are about to be
+ * created.
+ */
+GFile * nautilus_generate_unique_file_in_directory_full (GFile                   *directory,
+                                                         const char              *basename,
+                                                         NautilusFileIsTakenFunc  is_taken,
+                                                         gpointer                 user_data);
+
 GFile *  nautilus_find_existing_uri_in_hierarchy     (GFile *location);
 
 char * nautilus_get_scripts_directory_path (void);
@@ -160,6 +160,8 @@ static GQuark attribute_name_q,
               attribute_free_space_q,
               attribute_starred_q;
 
+static GQuark deferred_attributes_q;
+
 static void     nautilus_file_info_iface_init (NautilusFileInfoInterface *iface);
 static char *nautilus_file_get_owner_as_string (NautilusFile *file,
                                                 gboolean      include_real_name);
@@ -498,6 +500,18 @@ nautilus_file_update_metadata_from_info (NautilusFile *file,
     return changed;
 }
 
+/* Marks @info as queried without the attributes for @deferred_attributes
+ * (%NAUTILUS_FILE_ATTRIBUTE_METADATA and, or
+ * %NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO), so that updating a file from it
+ * keeps what the file has for those, instead of clearing it. */
+void
+nautilus_file_mark_info_deferred (GFileInfo              *info,
+                                  NautilusFileAttributes  deferred_attributes)
+{
+    g_object_set_qdata (G_OBJECT (info), deferred_attributes_q,
+                        GUINT_TO_POINTER (deferred_attributes));
+}
+
 void
 nautilus_file_clear_info (NautilusFile *file)
 {
@@ -573,6 +587,8 @@ nautilus_file_clear_info (NautilusFile *file)
     g_clear_pointer (&file->details->filesystem_id, g_ref_string_release);
 
     clear_metadata (file);
+    file->details->metadata_is_deferred = FALSE;
+    file->details->extended_info_is_deferred = FALSE;
 }
 
 NautilusDirectory *
@@ -583,12 +599,24 @@ nautilus_file_get_directory (NautilusFile *file)
     return file->details->directory;
 }
 
+static void
+clear_location (NautilusFile *file)
+{
+    g_clear_object (&file->details->location);
+    g_clear_object (&file->details->location_parent);
+    g_clear_pointer (&file->details->uri, g_free);
+
+    /* Starred state is per uri. */
+    file->details->starred_is_up_to_date = FALSE;
+}
+
 void
 nautilus_file_set_directory (NautilusFile      *file,
                              NautilusDirectory *directory)
 {
     char *parent_uri;
 
+    clear_location (file);
     g_clear_object (&file->details->directory);
     g_free (file->details->directory_name_collation_key);
 
@@ -889,6 +917,7 @@ finalize (GObject *object)
     }
 
     nautilus_directory_unref (directory);
+    clear_location (file);
     g_clear_pointer (&file->details->name, g_ref_string_release);
     g_clear_pointer (&file->details->display_name, g_ref_string_release);
     g_free (file->details->display_name_collation_key);
@@ -2254,10 +2283,9 @@ nautilus_file_matches_uri (NautilusFile *file,
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
     g_return_val_if_fail (match_uri != NULL, FALSE);
 
-    location = nautilus_file_get_location (file);
+    location = nautilus_file_peek_location (file);
     match_file = g_file_new_for_uri (match_uri);
     result = g_file_equal (location, match_file);
-    g_object_unref (location);
     g_object_unref (match_file);
 
     return result;
@@ -2267,18 +2295,8 @@ int
 nautilus_file_compare_location (NautilusFile *file_1,
                                 NautilusFile *file_2)
 {
-    GFile *loc_a, *loc_b;
-    gboolean res;
-
-    loc_a = nautilus_file_get_location (file_1);
-    loc_b = nautilus_file_get_location (file_2);
-
-    res = !g_file_equal (loc_a, loc_b);
-
-    g_object_unref (loc_a);
-    g_object_unref (loc_b);
-
-    return (gint) res;
+    return (gint) !g_file_equal (nautilus_file_peek_location (file_1),
+                                 nautilus_file_peek_location (file_2));
 }
 
 /**
@@ -2316,7 +2334,6 @@ update_link (NautilusFile *link_file,
 static GList *
 get_link_files (NautilusFile *target_file)
 {
-    char *uri;
     GList **link_files;
 
     if (symbolic_links == NULL)
@@ -2325,9 +2342,8 @@ get_link_files (NautilusFile *target_file)
     }
     else
     {
-        uri = nautilus_file_get_uri (target_file);
-        link_files = g_hash_table_lookup (symbolic_links, uri);
-        g_free (uri);
+        link_files = g_hash_table_lookup (symbolic_links,
+                                          nautilus_file_peek_uri (target_file));
     }
     if (link_files)
     {
@@ -2381,6 +2397,8 @@ update_info_internal (NautilusFile *file,
     const char *group, *owner, *owner_real;
     gboolean free_owner, free_group;
     const char *edit_name;
+    NautilusFileAttributes deferred_attributes;
+    gboolean extended_info_is_deferred;
 
     if (file->details->is_gone)
     {
@@ -2395,6 +2413,11 @@ update_info_internal (NautilusFile *file,
 
     file->details->file_info_is_up_to_date = TRUE;
 
+    deferred_attributes = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (info),
+                                                                deferred_attributes_q));
+    extended_info_is_deferred = (deferred_attributes & NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO) != 0;
+    file->details->extended_info_is_deferred = extended_info_is_deferred;
+
     /* FIXME bugzilla.gnome.org 42044: Need to let links that
      * point to the old name know that the file has been renamed.
      */
@@ -2719,17 +2742,20 @@ update_info_internal (NautilusFile *file,
         file->details->icon = g_object_ref (icon);
     }
 
-    thumbnail_path = g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH);
-    if (g_set_str (&file->details->thumbnail_path, thumbnail_path))
+    if (!extended_info_is_deferred)
     {
-        changed = TRUE;
-    }
+        thumbnail_path = g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH);
+        if (g_set_str (&file->details->thumbnail_path, thumbnail_path))
+        {
+            changed = TRUE;
+        }
 
-    thumbnailing_failed = g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED);
-    if (file->details->thumbnailing_failed != thumbnailing_failed)
-    {
-        changed = TRUE;
-        file->details->thumbnailing_failed = thumbnailing_failed;
+        thumbnailing_failed = g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED);
+        if (file->details->thumbnailing_failed != thumbnailing_failed)
+        {
+            changed = TRUE;
+            file->details->thumbnailing_failed = thumbnailing_failed;
+        }
     }
 
     symlink_name = g_file_info_get_attribute_byte_string (info,
@@ -2752,10 +2778,13 @@ update_info_internal (NautilusFile *file,
         file->details->mime_type = g_ref_string_new_intern (mime_type);
     }
 
-    selinux_context = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_SELINUX_CONTEXT);
-    if (g_set_str (&file->details->selinux_context, selinux_context))
+    if (!extended_info_is_deferred)
     {
-        changed = TRUE;
+        selinux_context = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_SELINUX_CONTEXT);
+        if (g_set_str (&file->details->selinux_context, selinux_context))
+        {
+            changed = TRUE;
+        }
     }
 
     filesystem_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
@@ -2799,8 +2828,16 @@ update_info_internal (NautilusFile *file,
         file->details->has_preview_icon = TRUE;
     }
 
-    changed |=
-        nautilus_file_update_metadata_from_info (file, info);
+    if ((deferred_attributes & NAUTILUS_FILE_ATTRIBUTE_METADATA) != 0)
+    {
+        file->details->metadata_is_deferred = TRUE;
+    }
+    else
+    {
+        file->details->metadata_is_deferred = FALSE;
+        changed |=
+            nautilus_file_update_metadata_from_info (file, info);
+    }
 
     if (update_name)
     {
@@ -2813,6 +2850,7 @@ update_info_internal (NautilusFile *file,
             node = nautilus_directory_begin_file_name_change
                        (file->details->directory, file);
 
+            clear_location (file);
             g_clear_pointer (&file->details->name, g_ref_string_release);
             if (g_strcmp0 (file->details->display_name, name) == 0)
             {
@@ -2888,6 +2926,7 @@ update_name_internal (NautilusFile *file,
                    (file->details->directory, file);
     }
 
+    clear_location (file);
     g_clear_pointer (&file->details->name, g_ref_string_release);
     file->details->name = g_ref_string_new (name);
 
@@ -3397,19 +3436,11 @@ static int
 compare_by_starred (NautilusFile *file_1,
                     NautilusFile *file_2)
 {
-    NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
-    g_autofree gchar *uri_1 = NULL;
-    g_autofree gchar *uri_2 = NULL;
     gboolean file_1_is_starred;
     gboolean file_2_is_starred;
 
-    uri_1 = nautilus_file_get_uri (file_1);
-    uri_2 = nautilus_file_get_uri (file_2);
-
-    file_1_is_starred = nautilus_tag_manager_file_is_starred (tag_manager,
-                                                              uri_1);
-    file_2_is_starred = nautilus_tag_manager_file_is_starred (tag_manager,
-                                                              uri_2);
+    file_1_is_starred = nautilus_file_is_starred (file_1);
+    file_2_is_starred = nautilus_file_is_starred (file_2);
     if (!!file_1_is_starred == !!file_2_is_starred)
     {
         return 0;
@@ -3935,9 +3966,7 @@ nautilus_file_is_home (NautilusFile *file)
 gboolean
 nautilus_file_is_in_search (NautilusFile *file)
 {
-    g_autoptr (GFile) location = nautilus_file_get_location (file);
-
-    return g_file_has_uri_scheme (location, SCHEME_SEARCH);
+    return g_file_has_uri_scheme (nautilus_file_peek_location (file), SCHEME_SEARCH);
 }
 
 static gboolean
@@ -4308,8 +4337,7 @@ get_custom_icon_metadata_uri (NautilusFile *file)
         nautilus_file_is_directory (file) &&
         is_uri_relative (uri))
     {
-        g_autofree char *dir_uri = nautilus_file_get_uri (file);
-        return g_build_filename (dir_uri, uri, NULL);
+        return g_build_filename (nautilus_file_peek_uri (file), uri, NULL);
     }
     else
     {
@@ -4339,11 +4367,9 @@ get_mount_icon (NautilusFile *file)
     }
     else
     {
-        g_autoptr (GFile) location = nautilus_file_get_location (file);
-
         /* Root directory doesn't have a GMount, but for UI purposes we want
          * it to be treated the same way. */
-        if (nautilus_is_root_directory (location))
+        if (nautilus_is_root_directory (nautilus_file_peek_location (file)))
         {
             mount_icon = g_themed_icon_new_with_default_fallbacks ("drive-harddisk");
         }
@@ -4811,6 +4837,7 @@ nautilus_file_get_thumbnail_icon (NautilusFile          *file,
         paintable = gtk_snapshot_to_paintable (snapshot, NULL);
     }
     else if (file->details->thumbnail_path == NULL &&
+             !file->details->extended_info_is_deferred &&
              file->details->can_read &&
              !file->details->is_thumbnailing &&
              !file->details->thumbnailing_failed &&
@@ -4824,6 +4851,7 @@ nautilus_file_get_thumbnail_icon (NautilusFile          *file,
         icon = nautilus_icon_info_new_for_paintable (paintable, scale);
     }
     else if (file->details->is_thumbnailing ||
+             (file->details->extended_info_is_deferred && nautilus_can_thumbnail (file)) ||
              !nautilus_file_check_if_ready (file, NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL))
     {
         g_autoptr (GIcon) gicon = g_themed_icon_new (ICON_NAME_THUMBNAIL_LOADING);
@@ -5306,10 +5334,8 @@ nautilus_file_can_get_permissions (NautilusFile *file)
 gboolean
 nautilus_file_can_set_permissions (NautilusFile *file)
 {
-    g_autoptr (GFile) location = nautilus_file_get_location (file);
-
     if (file->details->has_uid &&
-        g_file_is_native (location))
+        g_file_is_native (nautilus_file_peek_location (file)))
     {
         /* Owner is allowed to set permissions. */
         if (geteuid () == file->details->uid)
@@ -7191,7 +7217,7 @@ nautilus_file_get_symbolic_link_target_path (NautilusFile *file)
 char *
 nautilus_file_get_symbolic_link_target_uri (NautilusFile *file)
 {
-    GFile *location, *parent, *target;
+    GFile *parent, *target;
     char *target_uri;
 
     if (!nautilus_file_is_symbolic_link (file))
@@ -7207,9 +7233,7 @@ nautilus_file_get_symbolic_link_target_uri (NautilusFile *file)
     {
         target = NULL;
 
-        location = nautilus_file_get_location (file);
-        parent = g_file_get_parent (location);
-        g_object_unref (location);
+        parent = g_file_get_parent (nautilus_file_peek_location (file));
         if (parent)
         {
             target = g_file_resolve_relative_path (parent, file->details->symlink_name);
@@ -7254,9 +7278,8 @@ nautilus_file_is_public_share_folder (NautilusFile *file)
          * is considered to be the public sharing folder when XDG_PUBLICSHARE_DIR
          * is set to the home folder. */
         g_autoptr (GFile) public_folder = g_file_new_build_filename (g_get_home_dir (), "Public", NULL);
-        g_autoptr (GFile) location = nautilus_file_get_location (file);
 
-        return g_file_equal (public_folder, location);
+        return g_file_equal (public_folder, nautilus_file_peek_location (file));
     }
     return FALSE;
 }
@@ -7288,14 +7311,11 @@ nautilus_file_is_user_special_directory (NautilusFile   *file,
 
     if (special_dir)
     {
-        GFile *loc;
         GFile *special_gfile;
 
-        loc = nautilus_file_get_location (file);
         special_gfile = g_file_new_for_path (special_dir);
-        is_special_dir = g_file_equal (loc, special_gfile);
+        is_special_dir = g_file_equal (nautilus_file_peek_location (file), special_gfile);
         g_object_unref (special_gfile);
-        g_object_unref (loc);
     }
 
     return is_special_dir;
@@ -7390,13 +7410,10 @@ nautilus_file_is_remote (NautilusFile *file)
 gboolean
 nautilus_file_is_other_locations (NautilusFile *file)
 {
-    g_autoptr (GFile) location = NULL;
-
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
 
-    location = nautilus_file_get_location (file);
-
-    return nautilus_is_root_for_scheme (location, SCHEME_OTHER_LOCATIONS);
+    return nautilus_is_root_for_scheme (nautilus_file_peek_location (file),
+                                        SCHEME_OTHER_LOCATIONS);
 }
 
 /**
@@ -7411,13 +7428,9 @@ nautilus_file_is_other_locations (NautilusFile *file)
 gboolean
 nautilus_file_is_starred_location (NautilusFile *file)
 {
-    g_autoptr (GFile) location = NULL;
-
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
 
-    location = nautilus_file_get_location (file);
-
-    return g_file_has_uri_scheme (location, SCHEME_STARRED);
+    return g_file_has_uri_scheme (nautilus_file_peek_location (file), SCHEME_STARRED);
 }
 
 /**
@@ -7855,6 +7868,42 @@ nautilus_file_set_is_thumbnailing (NautilusFile *file,
     file->details->is_thumbnailing = is_thumbnailing;
 }
 
+/**
+ * nautilus_file_is_starred:
+ * @file: a #NautilusFile
+ *
+ * Checks whether @file is starred. This only looks up the tag manager the
+ * first time, and after @file is renamed or moved; the tag manager updates
+ * the starred state of existing files when it changes.
+ *
+ * Returns: %TRUE if @file is starred
+ */
+gboolean
+nautilus_file_is_starred (NautilusFile *file)
+{
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
+
+    if (!file->details->starred_is_up_to_date)
+    {
+        file->details->is_starred =
+            nautilus_tag_manager_file_is_starred (nautilus_tag_manager_get (),
+                                                  nautilus_file_peek_uri (file));
+        file->details->starred_is_up_to_date = TRUE;
+    }
+
+    return file->details->is_starred;
+}
+
+void
+nautilus_file_set_is_starred (NautilusFile *file,
+                              gboolean      is_starred)
+{
+    g_return_if_fail (NAUTILUS_IS_FILE (file));
+
+    file->details->is_starred = is_starred;
+    file->details->starred_is_up_to_date = TRUE;
+}
+
 gboolean
 nautilus_file_set_thumbnail (NautilusFile *file,
                              GdkPixbuf    *pixbuf)
@@ -8021,9 +8070,8 @@ nautilus_file_list_debug (GList *files)
     for (GList *l = files; l != NULL; l = l->next)
     {
         NautilusFile *file = l->data;
-        g_autofree gchar *uri = nautilus_file_get_uri (file);
-
-        g_debug ("%s%s", uri, nautilus_file_is_gone (file) ? " (gone)" : "");
+        g_debug ("%s%s", nautilus_file_peek_uri (file),
+                 nautilus_file_is_gone (file) ? " (gone)" : "");
     }
 }
 
@@ -8550,6 +8598,8 @@ nautilus_file_class_init (NautilusFileClass *class)
     attribute_free_space_q = g_quark_from_static_string ("free_space");
     attribute_starred_q = g_quark_from_static_string ("starred");
 
+    deferred_attributes_q = g_quark_from_static_string ("nautilus-file-deferred-attributes");
+
     G_OBJECT_CLASS (class)->finalize = finalize;
     G_OBJECT_CLASS (class)->constructor = nautilus_file_constructor;
     G_OBJECT_CLASS (class)->get_property = nautilus_file_get_property;
@@ -8670,9 +8720,32 @@ nautilus_file_get_uri (NautilusFile *file)
 {
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
 
-    g_autoptr (GFile) location = nautilus_file_get_location (file);
+    return g_strdup (nautilus_file_peek_uri (file));
+}
 
-    return g_file_get_uri (location);
+/**
+ * nautilus_file_peek_uri:
+ * @file: a #NautilusFile
+ *
+ * Like nautilus_file_get_uri(), but the uri is owned by @file, and is only
+ * valid until @file is renamed or moved.
+ *
+ * Returns: (transfer none): the uri of @file
+ */
+const char *
+nautilus_file_peek_uri (NautilusFile *file)
+{
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
+
+    /* Also recomputes the uri if the directory moved. */
+    GFile *location = nautilus_file_peek_location (file);
+
+    if (file->details->uri == NULL)
+    {
+        file->details->uri = g_file_get_uri (location);
+    }
+
+    return file->details->uri;
 }
 
 static char *
@@ -8940,19 +9013,48 @@ get_location (NautilusFileInfo *file_info)
     return nautilus_file_get_location (NAUTILUS_FILE (file_info));
 }
 
+/* Main thread only, see nautilus_file_peek_location(). */
 GFile *
 nautilus_file_get_location (NautilusFile *file)
 {
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
 
-    g_autoptr (GFile) location = nautilus_directory_get_location (file->details->directory);
+    return g_object_ref (nautilus_file_peek_location (file));
+}
 
-    if (nautilus_file_is_self_owned (file))
+/**
+ * nautilus_file_peek_location:
+ * @file: a #NautilusFile
+ *
+ * Like nautilus_file_get_location(), but the location is owned by @file,
+ * and is only valid until @file is renamed or moved.
+ *
+ * The location is cached on first use, without locking, so this and
+ * nautilus_file_get_location() must only be called on the main thread.
+ *
+ * Returns: (transfer none): the location of @file
+ */
+GFile *
+nautilus_file_peek_location (NautilusFile *file)
+{
+    GFile *parent;
+
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
+
+    parent = file->details->directory->details->location;
+
+    if (file->details->location == NULL ||
+        file->details->location_parent != parent)
     {
-        return g_steal_pointer (&location);
+        clear_location (file);
+
+        file->details->location_parent = g_object_ref (parent);
+        file->details->location = nautilus_file_is_self_owned (file) ?
+                                  g_object_ref (parent) :
+                                  g_file_get_child (parent, file->details->name);
     }
 
-    return g_file_get_child (location, file->details->name);
+    return file->details->location;
 }
 
 static GFile *
@@ -104,7 +104,7 @@ typedef void (*NautilusFileOperationCallback) (NautilusFile  *file,
 					       gpointer       callback_data);
 
 
-#define NAUTILUS_FILE_ATTRIBUTES_FOR_ICON (NAUTILUS_FILE_ATTRIBUTE_INFO | NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL)
+#define NAUTILUS_FILE_ATTRIBUTES_FOR_ICON (NAUTILUS_FILE_ATTRIBUTE_INFO | NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL | NAUTILUS_FILE_ATTRIBUTE_METADATA)
 
 typedef void NautilusFileListHandle;
 
@@ -158,7 +158,9 @@ const char *            nautilus_file_get_display_name                  (Nautilu
 const char *            nautilus_file_get_edit_name                     (NautilusFile                   *file);
 const char *            nautilus_file_get_name                          (NautilusFile                   *file);
 GFile *                 nautilus_file_get_location                      (NautilusFile                   *file);
+GFile *                 nautilus_file_peek_location                     (NautilusFile                   *file);
 char *                  nautilus_file_get_uri                           (NautilusFile                   *file);
+const char *            nautilus_file_peek_uri                          (NautilusFile                   *file);
 char *                  nautilus_file_get_uri_scheme                    (NautilusFile                   *file);
 NautilusFile *          nautilus_file_get_parent                        (NautilusFile                   *file);
 GFile *                 nautilus_file_get_parent_location               (NautilusFile                   *file);
@@ -199,6 +201,7 @@ gboolean                nautilus_file_is_in_admin                       (Nautilu
 gboolean                nautilus_file_is_remote                         (NautilusFile                   *file);
 gboolean                nautilus_file_is_other_locations                (NautilusFile                   *file);
 gboolean                nautilus_file_is_starred_location              (NautilusFile                   *file);
+gboolean                nautilus_file_is_starred                        (NautilusFile                   *file);
 gboolean		nautilus_file_is_home				(NautilusFile                   *file);
 GError *                nautilus_file_get_file_info_error               (NautilusFile                   *file);
 gboolean                nautilus_file_get_directory_item_count          (NautilusFile                   *file,
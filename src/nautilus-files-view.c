@@ -75,9 +75,11 @@
 #include "nautilus-rename-file-popover.h"
 #include "nautilus-scheme.h"
 #include "nautilus-search-directory.h"
+#include "nautilus-stall-watchdog.h"
 #include "nautilus-signaller.h"
 #include "nautilus-tag-manager.h"
 #include "nautilus-toolbar.h"
+#include "nautilus-trace.h"
 #include "nautilus-trash-monitor.h"
 #include "nautilus-ui-utilities.h"
 #include "nautilus-view.h"
@@ -253,6 +255,8 @@ typedef struct
     GMenuModel *scripts_menu;
 
     GCancellable *clipboard_cancellable;
+    /* The cut files last applied to the model */
+    NautilusClipboard *cut_clipboard;
 
     GCancellable *starred_cancellable;
 } NautilusFilesViewPrivate;
@@ -681,23 +685,48 @@ update_cut_status_callback (GObject      *source_object,
                             GAsyncResult *res,
                             gpointer      user_data)
 {
-    NautilusFilesView *self = NAUTILUS_FILES_VIEW (user_data);
-    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (self);
+    NautilusFilesView *self;
+    NautilusFilesViewPrivate *priv;
     const GValue *value;
-    GList *cut_files = NULL;
+    NautilusClipboard *cut_clipboard = NULL;
+    g_autoptr (GError) error = NULL;
+
+    value = gdk_clipboard_read_value_finish (GDK_CLIPBOARD (source_object), res, &error);
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        return;
+    }
+
+    self = NAUTILUS_FILES_VIEW (user_data);
+    priv = nautilus_files_view_get_instance_private (self);
 
-    value = gdk_clipboard_read_value_finish (GDK_CLIPBOARD (source_object), res, NULL);
     if (value != NULL &&
         G_VALUE_HOLDS (value, NAUTILUS_TYPE_CLIPBOARD))
     {
         NautilusClipboard *clip = g_value_get_boxed (value);
         if (clip != NULL && nautilus_clipboard_is_cut (clip))
         {
-            cut_files = nautilus_clipboard_peek_files (clip);
+            cut_clipboard = clip;
         }
     }
 
-    nautilus_view_model_set_cut_files (priv->model, cut_files);
+    /* A local clipboard value is shared, not copied, by every read. When it
+     * is the one already applied, the model has nothing to update. */
+    if (cut_clipboard == priv->cut_clipboard)
+    {
+        return;
+    }
+
+    g_clear_pointer (&priv->cut_clipboard, nautilus_clipboard_free);
+    if (cut_clipboard != NULL)
+    {
+        priv->cut_clipboard = nautilus_clipboard_copy (cut_clipboard);
+    }
+
+    nautilus_view_model_set_cut_files (priv->model,
+                                       cut_clipboard != NULL ?
+                                       nautilus_clipboard_peek_files (cut_clipboard) :
+                                       NULL);
 }
 
 static void
@@ -715,8 +744,9 @@ update_cut_status (NautilusFilesView *self)
                                         update_cut_status_callback,
                                         self);
     }
-    else
+    else if (priv->cut_clipboard != NULL)
     {
+        g_clear_pointer (&priv->cut_clipboard, nautilus_clipboard_free);
         nautilus_view_model_set_cut_files (priv->model, NULL);
     }
 }
@@ -3305,12 +3335,32 @@ on_unload_subdirectory (NautilusListBase *list_base,
                         gpointer          user_data)
 {
     NautilusFilesView *self = NAUTILUS_FILES_VIEW (user_data);
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (self);
     g_autoptr (NautilusDirectory) directory = nautilus_directory_get_for_file (nautilus_view_item_get_file (item));
+    g_autoptr (GFile) location = nautilus_directory_get_location (directory);
+    g_autolist (NautilusDirectory) descendants = NULL;
 
     if (nautilus_files_view_has_subdirectory (self, directory))
     {
         nautilus_files_view_remove_subdirectory (self, directory);
     }
+
+    /* Folders expanded inside the collapsed one are no longer shown, but
+     * would otherwise stay loaded and monitored. */
+    for (GList *l = priv->subdirectory_list; l != NULL; l = l->next)
+    {
+        g_autoptr (GFile) subdirectory_location = nautilus_directory_get_location (l->data);
+
+        if (g_file_has_prefix (subdirectory_location, location))
+        {
+            descendants = g_list_prepend (descendants, nautilus_directory_ref (l->data));
+        }
+    }
+
+    for (GList *l = descendants; l != NULL; l = l->next)
+    {
+        nautilus_files_view_remove_subdirectory (self, l->data);
+    }
 }
 
 static void
@@ -3479,6 +3529,7 @@ nautilus_files_view_finalize (GObject *object)
     g_hash_table_destroy (priv->pending_reveal);
 
     g_clear_object (&priv->clipboard_cancellable);
+    g_clear_pointer (&priv->cut_clipboard, nautilus_clipboard_free);
 
     g_cancellable_cancel (priv->starred_cancellable);
     g_clear_object (&priv->starred_cancellable);
@@ -3943,14 +3994,13 @@ debuting_files_add_files_callback (NautilusFilesView *view,
 
     for (l = new_files; l != NULL; l = l->next)
     {
-        location = nautilus_file_get_location (NAUTILUS_FILE (l->data));
+        location = nautilus_file_peek_location (NAUTILUS_FILE (l->data));
 
         if (g_hash_table_remove (data->debuting_files, location))
         {
             nautilus_file_ref (NAUTILUS_FILE (l->data));
             data->added_files = g_list_prepend (data->added_files, NAUTILUS_FILE (l->data));
         }
-        g_object_unref (location);
     }
 
     if (g_hash_table_size (data->debuting_files) == 0)
@@ -4024,14 +4074,8 @@ static gboolean
 copy_move_done_partition_func (NautilusFile *file,
                                gpointer      callback_data)
 {
-    GFile *location;
-    gboolean result;
-
-    location = nautilus_file_get_location (file);
-    result = g_hash_table_remove ((GHashTable *) callback_data, location);
-    g_object_unref (location);
-
-    return result;
+    return g_hash_table_remove ((GHashTable *) callback_data,
+                                nautilus_file_peek_location (file));
 }
 
 static gboolean
@@ -4326,6 +4370,7 @@ process_pending_files (NautilusFilesView *view)
     FileAndDirectory *pending;
     GList *files;
     g_autoptr (GList) pending_additions = NULL;
+    gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
 
     priv = nautilus_files_view_get_instance_private (view);
     files_added = g_steal_pointer (&priv->new_added_files);
@@ -4444,6 +4489,11 @@ process_pending_files (NautilusFilesView *view)
         }
 
         g_signal_emit (view, signals[END_FILE_CHANGES], 0);
+
+        nautilus_trace_mark_printf (trace_start, "process-pending-files",
+                                    "%u added, %u changed",
+                                    g_list_length (files_added),
+                                    g_list_length (files_changed));
     }
 }
 
@@ -4542,6 +4592,8 @@ display_pending_callback (gpointer data)
 {
     NautilusFilesView *view;
     NautilusFilesViewPrivate *priv;
+    gint64 watchdog_start = nautilus_stall_watchdog_begin ();
+    guint n_pending = 0;
 
     view = NAUTILUS_FILES_VIEW (data);
     priv = nautilus_files_view_get_instance_private (view);
@@ -4550,8 +4602,16 @@ display_pending_callback (gpointer data)
 
     priv->display_pending_source_id = 0;
 
+    if (watchdog_start != 0)
+    {
+        n_pending = g_list_length (priv->new_added_files) +
+                    g_list_length (priv->new_changed_files);
+    }
+
     display_pending_files (view);
 
+    nautilus_stall_watchdog_end (watchdog_start, "display_pending_callback", n_pending);
+
     g_object_unref (G_OBJECT (view));
 
     return FALSE;
@@ -6105,8 +6165,6 @@ action_copy (GSimpleAction *action,
     selection = nautilus_files_view_get_selection_for_file_transfer (view);
     clipboard = gtk_widget_get_clipboard (GTK_WIDGET (view));
     nautilus_clipboard_prepare_for_files (clipboard, selection, FALSE);
-
-    nautilus_file_list_free (selection);
 }
 
 static void
@@ -6123,8 +6181,6 @@ action_cut (GSimpleAction *action,
     selection = nautilus_files_view_get_selection_for_file_transfer (view);
     clipboard = gtk_widget_get_clipboard (GTK_WIDGET (view));
     nautilus_clipboard_prepare_for_files (clipboard, selection, TRUE);
-
-    nautilus_file_list_free (selection);
 }
 
 static void
@@ -6146,8 +6202,6 @@ action_copy_current_location (GSimpleAction *action,
 
         clipboard = gtk_widget_get_clipboard (GTK_WIDGET (view));
         nautilus_clipboard_prepare_for_files (clipboard, files, FALSE);
-
-        nautilus_file_list_free (files);
     }
 }
 
@@ -7906,17 +7960,15 @@ real_update_actions_state (NautilusFilesView *view)
     for (l = selection; l != NULL; l = l->next)
     {
         NautilusFile *file;
-        g_autofree gchar *uri = NULL;
 
         file = NAUTILUS_FILE (l->data);
-        uri = nautilus_file_get_uri (file);
 
         if (!show_star && !show_unstar)
         {
             break;
         }
 
-        if (nautilus_tag_manager_file_is_starred (nautilus_tag_manager_get (), uri))
+        if (nautilus_file_is_starred (file))
         {
             show_star = FALSE;
         }
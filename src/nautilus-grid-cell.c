@@ -6,6 +6,7 @@
 
 #include "nautilus-grid-cell.h"
 
+#include "nautilus-directory.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-tag-manager.h"
 #include "nautilus-thumbnails.h"
@@ -15,6 +16,7 @@ struct _NautilusGridCell
     NautilusViewCell parent_instance;
 
     GSignalGroup *item_signal_group;
+    NautilusFile *monitored_file;
 
     GQuark *caption_attributes;
 
@@ -103,12 +105,10 @@ update_emblems (NautilusGridCell *self)
     GtkWidget *child;
     GtkIconTheme *theme;
     g_autolist (GIcon) emblems = NULL;
-    g_autofree gchar *file_uri = NULL;
 
     item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
     g_return_if_fail (item != NULL);
     file = nautilus_view_item_get_file (item);
-    file_uri = nautilus_file_get_uri (file);
 
     /* Remove old emblems. */
     while ((child = gtk_widget_get_first_child (self->emblems_box)) != NULL)
@@ -116,7 +116,7 @@ update_emblems (NautilusGridCell *self)
         gtk_box_remove (GTK_BOX (self->emblems_box), child);
     }
 
-    if (nautilus_tag_manager_file_is_starred (nautilus_tag_manager_get (), file_uri))
+    if (nautilus_file_is_starred (file))
     {
         gtk_box_append (GTK_BOX (self->emblems_box),
                         gtk_image_new_from_icon_name ("starred-symbolic"));
@@ -223,6 +223,38 @@ on_starred_changed (NautilusTagManager *tag_manager,
     }
 }
 
+/* Only the files that have a cell, rather than all the files of the
+ * directory, ask for the info that is costly to get. Unless it is
+ * deferred, directories load it for all their files anyway. */
+static void
+update_file_monitor (NautilusGridCell *self)
+{
+    g_autoptr (NautilusViewItem) item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
+    NautilusFile *file = (item != NULL) ? nautilus_view_item_get_file (item) : NULL;
+
+    if ((nautilus_directory_get_deferred_attributes () & NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO) == 0)
+    {
+        file = NULL;
+    }
+
+    if (file == self->monitored_file)
+    {
+        return;
+    }
+
+    if (self->monitored_file != NULL)
+    {
+        nautilus_file_monitor_remove (self->monitored_file, self);
+        g_clear_pointer (&self->monitored_file, nautilus_file_unref);
+    }
+
+    if (file != NULL)
+    {
+        self->monitored_file = nautilus_file_ref (file);
+        nautilus_file_monitor_add (file, self, NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO);
+    }
+}
+
 static void
 on_map_changed (GtkWidget *widget,
                 gpointer   user_data)
@@ -254,6 +286,12 @@ nautilus_grid_cell_dispose (GObject *object)
 {
     NautilusGridCell *self = (NautilusGridCell *) object;
 
+    if (self->monitored_file != NULL)
+    {
+        nautilus_file_monitor_remove (self->monitored_file, self);
+        g_clear_pointer (&self->monitored_file, nautilus_file_unref);
+    }
+
     gtk_widget_dispose_template (GTK_WIDGET (self), NAUTILUS_TYPE_GRID_CELL);
 
     G_OBJECT_CLASS (nautilus_grid_cell_parent_class)->dispose (object);
@@ -300,6 +338,8 @@ nautilus_grid_cell_init (NautilusGridCell *self)
     g_signal_connect (self, "unmap", G_CALLBACK (on_map_changed), GINT_TO_POINTER (FALSE));
     g_signal_connect (self, "notify::icon-size",
                       G_CALLBACK (on_icon_size_changed), NULL);
+    g_signal_connect_swapped (self, "notify::item",
+                              G_CALLBACK (update_file_monitor), self);
 
     g_signal_connect_object (nautilus_tag_manager_get (), "starred-changed",
                              G_CALLBACK (on_starred_changed), self, G_CONNECT_DEFAULT);
@@ -30,31 +30,135 @@
 
 #include <glib/gstdio.h>
 
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
+
+/* Changes are not saved by rewriting the whole keyfile, but by appending
+ * them to it as small keyfile fragments, e.g.
+ *
+ *     [directory]
+ *     nautilus-search-sort-by=name
+ *
+ * GKeyFile merges repeated groups, and the last value of a repeated key
+ * wins, so the file stays a valid keyfile, and files written by previous
+ * versions are read as they are. Once the file holds more replaced values
+ * than current ones, it is compacted by writing it from scratch.
+ */
+#define COMPACTION_MIN_REPLACED_ENTRIES 64
 
 typedef struct
 {
     GKeyFile *keyfile;
+    GString *pending_changes;
+    /* Values in the file which were replaced by later ones. */
+    guint n_replaced_entries;
+    guint n_entries;
+    /* Set when the file doesn't hold what was loaded from it, e.g. because
+     * it ends in a partial line, so that appending to it would corrupt it. */
+    gboolean needs_rewrite;
     guint save_in_idle_id;
 } KeyfileMetadataData;
 
 static GHashTable *data_hash = NULL;
 
+/* Sets @truncated if a partial line at the end of the file was left out. */
+static gboolean
+load_keyfile (GKeyFile    *keyfile,
+              const char  *keyfile_filename,
+              gboolean    *truncated,
+              GError     **error)
+{
+    g_autoptr (GMappedFile) mapped_file = NULL;
+    const gchar *contents;
+    gsize length;
+    g_autoptr (GError) parse_error = NULL;
+    const gchar *last_newline;
+
+    *truncated = FALSE;
+
+    mapped_file = g_mapped_file_new (keyfile_filename, FALSE, error);
+    if (mapped_file == NULL)
+    {
+        return FALSE;
+    }
+
+    contents = g_mapped_file_get_contents (mapped_file);
+    length = g_mapped_file_get_length (mapped_file);
+
+    if (g_key_file_load_from_data (keyfile, contents, length,
+                                   G_KEY_FILE_NONE, &parse_error))
+    {
+        return TRUE;
+    }
+
+    /* An interrupted append leaves a partial line at the end. */
+    last_newline = contents != NULL ? g_strrstr_len (contents, length, "\n") : NULL;
+    if (!g_error_matches (parse_error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_PARSE) ||
+        last_newline == NULL)
+    {
+        g_propagate_error (error, g_steal_pointer (&parse_error));
+        return FALSE;
+    }
+
+    *truncated = TRUE;
+
+    return g_key_file_load_from_data (keyfile, contents, last_newline - contents + 1,
+                                      G_KEY_FILE_NONE, error);
+}
+
+/* Appended values are kept next to the ones they replace when the file is
+ * loaded, so copy the current values into a keyfile of their own. */
+static GKeyFile *
+deduplicate_keyfile (GKeyFile *keyfile,
+                     guint    *n_entries,
+                     guint    *n_replaced_entries)
+{
+    GKeyFile *deduplicated = g_key_file_new ();
+    g_auto (GStrv) groups = g_key_file_get_groups (keyfile, NULL);
+
+    *n_entries = 0;
+    *n_replaced_entries = 0;
+
+    for (guint i = 0; groups[i] != NULL; i++)
+    {
+        gsize n_keys;
+        g_auto (GStrv) keys = g_key_file_get_keys (keyfile, groups[i], &n_keys, NULL);
+
+        for (gsize j = 0; j < n_keys; j++)
+        {
+            g_autofree gchar *value = NULL;
+
+            if (g_key_file_has_key (deduplicated, groups[i], keys[j], NULL))
+            {
+                *n_replaced_entries += 1;
+                continue;
+            }
+
+            value = g_key_file_get_value (keyfile, groups[i], keys[j], NULL);
+            g_key_file_set_value (deduplicated, groups[i], keys[j], value);
+            *n_entries += 1;
+        }
+    }
+
+    return deduplicated;
+}
+
 static KeyfileMetadataData *
 keyfile_metadata_data_new (const char *keyfile_filename)
 {
     KeyfileMetadataData *data;
-    GKeyFile *retval;
+    g_autoptr (GKeyFile) keyfile = NULL;
     GError *error = NULL;
+    gboolean truncated;
+    gboolean needs_rewrite;
 
-    retval = g_key_file_new ();
+    keyfile = g_key_file_new ();
 
-    g_key_file_load_from_file (retval,
-                               keyfile_filename,
-                               G_KEY_FILE_NONE,
-                               &error);
+    load_keyfile (keyfile, keyfile_filename, &truncated, &error);
+    needs_rewrite = truncated;
 
     if (error != NULL)
     {
@@ -64,13 +168,18 @@ keyfile_metadata_data_new (const char *keyfile_filename)
         {
             g_print ("Unable to open the desktop metadata keyfile: %s\n",
                      error->message);
+
+            /* Don't append to a file that can't be read back. */
+            needs_rewrite = TRUE;
         }
 
         g_error_free (error);
     }
 
     data = g_slice_new0 (KeyfileMetadataData);
-    data->keyfile = retval;
+    data->keyfile = deduplicate_keyfile (keyfile, &data->n_entries, &data->n_replaced_entries);
+    data->pending_changes = g_string_new (NULL);
+    data->needs_rewrite = needs_rewrite;
 
     return data;
 }
@@ -79,6 +188,7 @@ static void
 keyfile_metadata_data_free (KeyfileMetadataData *data)
 {
     g_key_file_unref (data->keyfile);
+    g_string_free (data->pending_changes, TRUE);
 
     if (data->save_in_idle_id != 0)
     {
@@ -88,8 +198,8 @@ keyfile_metadata_data_free (KeyfileMetadataData *data)
     g_slice_free (KeyfileMetadataData, data);
 }
 
-static GKeyFile *
-get_keyfile (const char *keyfile_filename)
+static KeyfileMetadataData *
+get_data (const char *keyfile_filename)
 {
     KeyfileMetadataData *data;
 
@@ -112,35 +222,100 @@ get_keyfile (const char *keyfile_filename)
                              data);
     }
 
-    return data->keyfile;
+    return data;
+}
+
+static GKeyFile *
+get_keyfile (const char *keyfile_filename)
+{
+    return get_data (keyfile_filename)->keyfile;
+}
+
+static gboolean
+append_to_file (const char  *keyfile_filename,
+                GString     *changes,
+                GError     **error)
+{
+    gint fd;
+    gsize written = 0;
+
+    fd = g_open (keyfile_filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+    if (fd == -1)
+    {
+        int saved_errno = errno;
+
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                     "%s", g_strerror (saved_errno));
+        return FALSE;
+    }
+
+    while (written < changes->len)
+    {
+        gssize result = write (fd, changes->str + written, changes->len - written);
+
+        if (result == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result == -1)
+        {
+            int saved_errno = errno;
+
+            g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                         "%s", g_strerror (saved_errno));
+            close (fd);
+            return FALSE;
+        }
+
+        written += result;
+    }
+
+    return g_close (fd, error);
 }
 
 static gboolean
 save_in_idle_cb (const gchar *keyfile_filename)
 {
     KeyfileMetadataData *data;
-    gchar *contents;
-    gsize length;
     GError *error = NULL;
 
     data = g_hash_table_lookup (data_hash, keyfile_filename);
     data->save_in_idle_id = 0;
 
-    contents = g_key_file_to_data (data->keyfile, &length, NULL);
-
-    if (contents != NULL)
+    if (data->needs_rewrite ||
+        data->n_replaced_entries > MAX (COMPACTION_MIN_REPLACED_ENTRIES, data->n_entries))
     {
-        g_file_set_contents (keyfile_filename,
-                             contents, length,
-                             &error);
+        gchar *contents;
+        gsize length;
+
+        contents = g_key_file_to_data (data->keyfile, &length, NULL);
+
+        if (contents != NULL &&
+            g_file_set_contents (keyfile_filename,
+                                 contents, length,
+                                 &error))
+        {
+            data->n_replaced_entries = 0;
+            data->needs_rewrite = FALSE;
+        }
         g_free (contents);
     }
+    else
+    {
+        append_to_file (keyfile_filename, data->pending_changes, &error);
+    }
+
+    g_string_truncate (data->pending_changes, 0);
 
     if (error != NULL)
     {
         g_warning ("Couldn't save the desktop metadata keyfile to disk: %s",
                    error->message);
         g_error_free (error);
+
+        /* Whatever was written, rewrite the whole file next time. */
+        data->needs_rewrite = TRUE;
     }
 
     return FALSE;
@@ -167,6 +342,49 @@ save_in_idle (const char *keyfile_filename)
                                              g_free);
 }
 
+/* Call before changing the value of @key, to count what is left in the file. */
+static void
+count_change (const char  *keyfile_filename,
+              const gchar *name,
+              const gchar *key)
+{
+    KeyfileMetadataData *data = get_data (keyfile_filename);
+
+    if (g_key_file_has_key (data->keyfile, name, key, NULL))
+    {
+        data->n_replaced_entries++;
+    }
+    else
+    {
+        data->n_entries++;
+    }
+}
+
+/* Call after changing the value of @key, to save it. */
+static void
+record_change (const char  *keyfile_filename,
+               const gchar *name,
+               const gchar *key)
+{
+    KeyfileMetadataData *data = get_data (keyfile_filename);
+    g_autofree gchar *value = NULL;
+
+    /* This is the value as escaped in the keyfile. */
+    value = g_key_file_get_value (data->keyfile, name, key, NULL);
+    if (value == NULL)
+    {
+        /* Not set after all, so the file must be written as a whole. */
+        data->needs_rewrite = TRUE;
+        save_in_idle (keyfile_filename);
+        return;
+    }
+
+    /* The leading newline ends any partial line left by an interrupted write. */
+    g_string_append_printf (data->pending_changes, "\n[%s]\n%s=%s\n", name, key, value);
+
+    save_in_idle (keyfile_filename);
+}
+
 void
 nautilus_keyfile_metadata_set_string (NautilusFile *file,
                                       const char   *keyfile_filename,
@@ -178,12 +396,13 @@ nautilus_keyfile_metadata_set_string (NautilusFile *file,
 
     keyfile = get_keyfile (keyfile_filename);
 
+    count_change (keyfile_filename, name, key);
     g_key_file_set_string (keyfile,
                            name,
                            key,
                            string);
 
-    save_in_idle (keyfile_filename);
+    record_change (keyfile_filename, name, key);
 
     if (nautilus_keyfile_metadata_update_from_keyfile (file, keyfile_filename, name))
     {
@@ -228,13 +447,14 @@ nautilus_keyfile_metadata_set_stringv (NautilusFile       *file,
         actual_stringv = (gchar **) stringv;
     }
 
+    count_change (keyfile_filename, name, key);
     g_key_file_set_string_list (keyfile,
                                 name,
                                 key,
                                 (const gchar **) actual_stringv,
                                 length);
 
-    save_in_idle (keyfile_filename);
+    record_change (keyfile_filename, name, key);
 
     if (nautilus_keyfile_metadata_update_from_keyfile (file, keyfile_filename, name))
     {
@@ -7,6 +7,7 @@
 #include "nautilus-list-base-private.h"
 
 #include "nautilus-application.h"
+#include "nautilus-clipboard.h"
 #include "nautilus-dnd.h"
 #include "nautilus-view-cell.h"
 #include "nautilus-view-item.h"
@@ -417,7 +418,6 @@ on_item_drag_prepare (GtkDragSource *source,
     GtkWidget *view_ui;
     g_autoptr (GtkBitset) selection = NULL;
     g_autolist (NautilusFile) selected_files = NULL;
-    g_autoslist (GFile) file_list = NULL;
     g_autoptr (GdkPaintable) paintable = NULL;
     GdkDragAction actions;
     gint scale_factor;
@@ -443,9 +443,6 @@ on_item_drag_prepare (GtkDragSource *source,
 
         selected_files = g_list_prepend (selected_files, g_object_ref (file));
 
-        /* Convert to GTK_TYPE_FILE_LIST, which is assumed to be a GSList<GFile>. */
-        file_list = g_slist_prepend (file_list, nautilus_file_get_activation_location (file));
-
         if (!nautilus_file_can_delete (file))
         {
             actions &= ~GDK_ACTION_MOVE;
@@ -471,7 +468,8 @@ on_item_drag_prepare (GtkDragSource *source,
 
     gtk_drag_source_set_icon (source, paintable, x, y);
 
-    return gdk_content_provider_new_typed (GDK_TYPE_FILE_LIST, file_list);
+    /* The file list is only built when the drop asks for it. */
+    return nautilus_clipboard_new_drag_content (g_steal_pointer (&selected_files));
 }
 
 static gboolean
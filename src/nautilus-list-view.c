@@ -31,6 +31,9 @@
 /* We wait two seconds after row is collapsed to unload the subdirectory */
 #define COLLAPSE_TO_UNLOAD_DELAY 2
 
+/* How many folders shown in the tree are prefetched at the same time */
+#define MAX_PREFETCHES_LOADING 4
+
 struct _NautilusListView
 {
     NautilusListBase parent_instance;
@@ -52,6 +55,12 @@ struct _NautilusListView
     GHashTable *factory_to_column_map;
 
     GtkSorter *view_model_sorter;
+
+    /* In tree mode, the folders whose rows are shown get their file list
+     * loaded in advance, so that expanding them is immediate. */
+    GHashTable *prefetched_directories;
+    GHashTable *prefetches_loading;
+    GQueue prefetch_queue;
 };
 
 G_DEFINE_TYPE (NautilusListView, nautilus_list_view, NAUTILUS_TYPE_LIST_BASE)
@@ -65,6 +74,8 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
+static void cancel_all_prefetches (NautilusListView *self);
+
 #define get_view_item(cell) \
         (NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (GTK_TREE_LIST_ROW (gtk_column_view_cell_get_item (cell)))))
 
@@ -563,6 +574,9 @@ nautilus_list_view_setup_directory (NautilusListBase  *list_base,
 
     NAUTILUS_LIST_BASE_CLASS (nautilus_list_view_parent_class)->setup_directory (list_base, new_directory);
 
+    /* The folders of the previous location are of no use anymore. */
+    cancel_all_prefetches (self);
+
     g_clear_object (&self->search_directory);
     if (NAUTILUS_IS_SEARCH_DIRECTORY (new_directory))
     {
@@ -862,6 +876,112 @@ setup_name_cell (GtkSignalListItemFactory *factory,
     }
 }
 
+static void start_prefetches (NautilusListView *self);
+
+static void
+prefetch_ready_cb (NautilusDirectory *directory,
+                   GList             *files,
+                   gpointer           user_data)
+{
+    NautilusListView *self = NAUTILUS_LIST_VIEW (user_data);
+
+    g_hash_table_remove (self->prefetches_loading, directory);
+    start_prefetches (self);
+}
+
+static void
+start_prefetches (NautilusListView *self)
+{
+    while (g_hash_table_size (self->prefetches_loading) < MAX_PREFETCHES_LOADING &&
+           !g_queue_is_empty (&self->prefetch_queue))
+    {
+        NautilusDirectory *directory = g_queue_pop_head (&self->prefetch_queue);
+
+        /* The monitor keeps the file list loaded and up to date until the
+         * row goes away. Only the basic info is requested; the rest is
+         * loaded when the folder is actually expanded. */
+        g_hash_table_add (self->prefetched_directories, directory);
+        g_hash_table_add (self->prefetches_loading, directory);
+        nautilus_directory_file_monitor_add (directory, self, FALSE,
+                                             NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                             NULL, NULL);
+        nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                            TRUE, prefetch_ready_cb, self);
+    }
+}
+
+/* Returns the directory of @item, to cancel the prefetch with, or NULL if
+ * it isn't prefetched. */
+static NautilusDirectory *
+prefetch_subdirectory (NautilusListView *self,
+                       NautilusViewItem *item)
+{
+    NautilusFile *file = nautilus_view_item_get_file (item);
+    NautilusDirectory *directory;
+
+    if (!nautilus_file_is_directory (file) || nautilus_file_is_remote (file))
+    {
+        return NULL;
+    }
+
+    directory = nautilus_directory_get_for_file (file);
+    if (g_hash_table_contains (self->prefetched_directories, directory) ||
+        g_queue_find (&self->prefetch_queue, directory) != NULL)
+    {
+        return directory;
+    }
+
+    g_queue_push_tail (&self->prefetch_queue, nautilus_directory_ref (directory));
+    start_prefetches (self);
+
+    return directory;
+}
+
+static void
+cancel_prefetch (NautilusListView  *self,
+                 NautilusDirectory *directory)
+{
+    if (g_queue_remove (&self->prefetch_queue, directory))
+    {
+        nautilus_directory_unref (directory);
+        return;
+    }
+
+    if (!g_hash_table_contains (self->prefetched_directories, directory))
+    {
+        return;
+    }
+
+    if (g_hash_table_remove (self->prefetches_loading, directory))
+    {
+        nautilus_directory_cancel_callback (directory, prefetch_ready_cb, self);
+    }
+    nautilus_directory_file_monitor_remove (directory, self);
+    g_hash_table_remove (self->prefetched_directories, directory);
+
+    start_prefetches (self);
+}
+
+static void
+cancel_all_prefetches (NautilusListView *self)
+{
+    GHashTableIter iter;
+    NautilusDirectory *directory;
+
+    g_queue_clear_full (&self->prefetch_queue, (GDestroyNotify) nautilus_directory_unref);
+
+    g_hash_table_iter_init (&iter, self->prefetched_directories);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &directory, NULL))
+    {
+        if (g_hash_table_remove (self->prefetches_loading, directory))
+        {
+            nautilus_directory_cancel_callback (directory, prefetch_ready_cb, self);
+        }
+        nautilus_directory_file_monitor_remove (directory, self);
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
 static void
 on_n_items_notify (GObject    *object,
                    GParamSpec *pspec,
@@ -919,6 +1039,12 @@ bind_name_cell (GtkSignalListItemFactory *factory,
                                  "notify::children",
                                  G_CALLBACK (on_row_children_changed),
                                  expander, 0);
+
+        /* Kept on the cell, so that unbinding cancels the prefetch even
+         * when the item is already gone. */
+        g_object_set_data_full (G_OBJECT (listitem), "nautilus-prefetched-directory",
+                                prefetch_subdirectory (self, item),
+                                (GDestroyNotify) nautilus_directory_unref);
     }
 }
 
@@ -929,6 +1055,15 @@ unbind_name_cell (GtkSignalListItemFactory *factory,
 {
     NautilusListView *self = user_data;
     g_autoptr (NautilusViewItem) item = NULL;
+    g_autoptr (NautilusDirectory) prefetched_directory = NULL;
+
+    /* Scrolled away, or gone with its collapsed parent */
+    prefetched_directory = g_object_steal_data (G_OBJECT (listitem),
+                                                "nautilus-prefetched-directory");
+    if (prefetched_directory != NULL)
+    {
+        cancel_prefetch (self, prefetched_directory);
+    }
 
     item = get_view_item (listitem);
     if (item == NULL)
@@ -1093,6 +1228,12 @@ nautilus_list_view_init (NautilusListView *self)
 
     gtk_widget_add_css_class (GTK_WIDGET (self), "nautilus-list-view");
 
+    self->prefetched_directories = g_hash_table_new_full (NULL, NULL,
+                                                          (GDestroyNotify) nautilus_directory_unref,
+                                                          NULL);
+    self->prefetches_loading = g_hash_table_new (NULL, NULL);
+    g_queue_init (&self->prefetch_queue);
+
     g_signal_connect_object (nautilus_list_view_preferences,
                              "changed::" NAUTILUS_PREFERENCES_LIST_VIEW_DEFAULT_VISIBLE_COLUMNS,
                              G_CALLBACK (update_columns_settings_from_metadata_and_preferences),
@@ -1163,6 +1304,8 @@ nautilus_list_view_dispose (GObject *object)
 
     g_clear_object (&self->search_directory);
 
+    cancel_all_prefetches (self);
+
     g_signal_handlers_disconnect_by_func (nautilus_list_view_preferences,
                                           update_columns_settings_from_metadata_and_preferences,
                                           self);
@@ -1181,6 +1324,11 @@ nautilus_list_view_dispose (GObject *object)
 static void
 nautilus_list_view_finalize (GObject *object)
 {
+    NautilusListView *self = NAUTILUS_LIST_VIEW (object);
+
+    g_hash_table_destroy (self->prefetched_directories);
+    g_hash_table_destroy (self->prefetches_loading);
+
     G_OBJECT_CLASS (nautilus_list_view_parent_class)->finalize (object);
 }
 
@@ -258,6 +258,50 @@ nautilus_module_setup (void)
     }
 }
 
+typedef struct
+{
+    NautilusModuleCallback callback;
+    gpointer user_data;
+} SetupData;
+
+static gboolean
+setup_in_idle (gpointer user_data)
+{
+    SetupData *data = user_data;
+
+    nautilus_module_setup ();
+    data->callback (data->user_data);
+
+    g_free (data);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Loads the extensions and calls @callback once they are loaded. With
+ * NAUTILUS_DEFER_EXTENSIONS set, this happens from a low priority idle, so
+ * that at startup the first window can be shown, and its directory start
+ * loading, before every extension is opened. Otherwise this is the same as
+ * nautilus_module_setup() followed by @callback. */
+void
+nautilus_module_setup_async (NautilusModuleCallback callback,
+                             gpointer               user_data)
+{
+    SetupData *data;
+
+    if (g_getenv ("NAUTILUS_DEFER_EXTENSIONS") == NULL)
+    {
+        nautilus_module_setup ();
+        callback (user_data);
+        return;
+    }
+
+    data = g_new0 (SetupData, 1);
+    data->callback = callback;
+    data->user_data = user_data;
+
+    g_idle_add_full (G_PRIORITY_LOW, setup_in_idle, data, NULL);
+}
+
 GList *
 nautilus_module_get_extensions_for_type (GType type)
 {
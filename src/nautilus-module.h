@@ -26,7 +26,11 @@
 
 G_BEGIN_DECLS
 
+typedef void (* NautilusModuleCallback) (gpointer user_data);
+
 void   nautilus_module_setup                   (void);
+void   nautilus_module_setup_async             (NautilusModuleCallback  callback,
+                                                gpointer                user_data);
 void   nautilus_module_teardown                (void);
 GList *nautilus_module_get_extensions_for_type (GType  type);
 void   nautilus_module_extension_list_free     (GList *list);
@@ -27,24 +27,72 @@
 #include "nautilus-monitor.h"
 #include "nautilus-file-changes-queue.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-stall-watchdog.h"
 
 #include <gio/gio.h>
 
 struct NautilusMonitor
 {
     GFileMonitor *monitor;
-    GVolumeMonitor *volume_monitor;
     GFile *location;
+    gboolean tried;
+    /* Not watched because of the watch budget. */
+    gboolean over_budget;
 };
 
+/* Local directory monitors each take an inotify watch, and the number of
+ * watches is limited per user and shared with every other application. A
+ * search with results in thousands of directories could use them all up,
+ * and GIO then polls the directories it couldn't watch. So directories
+ * are only watched for the sake of single files while the number of
+ * watches stays below a fraction of the limit. Directories whose file list
+ * is shown are always watched. The files of the others are read again when
+ * a window is activated, see nautilus_monitor_is_over_budget(). */
+#define INOTIFY_MAX_USER_WATCHES_PATH "/proc/sys/fs/inotify/max_user_watches"
+#define WATCH_BUDGET_FRACTION 4
+
+static guint n_native_watches = 0;
+
+/* All the monitors of non-native locations share one handler for
+ * GVolumeMonitor::mount-removed. */
+static GVolumeMonitor *volume_monitor = NULL;
+static GList *non_native_monitors = NULL;
+
+/* Roughly half a frame, so that bursts of events (e.g. a large checkout)
+ * are delivered over several main loop iterations instead of freezing it. */
+#define CONSUME_CHANGES_TIME_BUDGET_US 8000
+
 static gboolean call_consume_changes_idle_id = 0;
 
 static gboolean
 call_consume_changes_idle_cb (gpointer not_used)
 {
-    nautilus_file_changes_consume_changes ();
+    gint64 watchdog_start = nautilus_stall_watchdog_begin ();
+    guint64 n_delivered_before = 0;
+    guint64 n_delivered;
+    gboolean more_changes;
+
+    if (watchdog_start != 0)
+    {
+        nautilus_file_changes_queue_get_counters (NULL, &n_delivered_before);
+    }
+
+    more_changes = nautilus_file_changes_consume_changes_with_budget (CONSUME_CHANGES_TIME_BUDGET_US);
+
+    if (watchdog_start != 0)
+    {
+        nautilus_file_changes_queue_get_counters (NULL, &n_delivered);
+        nautilus_stall_watchdog_end (watchdog_start, "call_consume_changes_idle_cb",
+                                     n_delivered - n_delivered_before);
+    }
+
+    if (more_changes)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+
     call_consume_changes_idle_id = 0;
-    return FALSE;
+    return G_SOURCE_REMOVE;
 }
 
 static void
@@ -62,20 +110,53 @@ mount_removed (GVolumeMonitor *volume_monitor,
                GMount         *mount,
                gpointer        user_data)
 {
-    NautilusMonitor *monitor = user_data;
     GFile *mount_location;
+    gboolean unmounted = FALSE;
 
     mount_location = g_mount_get_root (mount);
-    if (g_file_equal (monitor->location, mount_location) ||
-        g_file_has_prefix (monitor->location, mount_location))
+    for (GList *l = non_native_monitors; l != NULL; l = l->next)
+    {
+        NautilusMonitor *monitor = l->data;
+
+        if (g_file_equal (monitor->location, mount_location) ||
+            g_file_has_prefix (monitor->location, mount_location))
+        {
+            nautilus_file_changes_queue_file_unmounted (monitor->location);
+            unmounted = TRUE;
+        }
+    }
+
+    if (unmounted)
     {
-        nautilus_file_changes_queue_file_unmounted (monitor->location);
         schedule_call_consume_changes ();
     }
 
     g_object_unref (mount_location);
 }
 
+static guint
+get_watch_budget (void)
+{
+    static guint budget = 0;
+
+    if (budget == 0)
+    {
+        g_autofree gchar *contents = NULL;
+        guint64 max_user_watches = 0;
+
+        if (g_file_get_contents (INOTIFY_MAX_USER_WATCHES_PATH, &contents, NULL, NULL))
+        {
+            max_user_watches = g_ascii_strtoull (contents, NULL, 10);
+        }
+
+        budget = max_user_watches > 0 ?
+                 (guint) CLAMP (max_user_watches / WATCH_BUDGET_FRACTION, 1, G_MAXUINT) :
+                 G_MAXUINT;
+    }
+
+    return budget;
+}
+
 static void
 dir_changed (GFileMonitor      *monitor,
              GFile             *child,
@@ -131,18 +212,61 @@ dir_changed (GFileMonitor      *monitor,
     schedule_call_consume_changes ();
 }
 
+static void
+start_watching (NautilusMonitor *monitor)
+{
+    /* Only try once, so we can avoid later trying again on failure */
+    monitor->tried = TRUE;
+    monitor->over_budget = FALSE;
+    monitor->monitor = g_file_monitor_directory (monitor->location,
+                                                 G_FILE_MONITOR_WATCH_MOUNTS,
+                                                 NULL, NULL);
+
+    if (monitor->monitor != NULL)
+    {
+        if (g_file_is_native (monitor->location))
+        {
+            n_native_watches++;
+        }
+
+        g_signal_connect (monitor->monitor, "changed",
+                          G_CALLBACK (dir_changed), monitor);
+    }
+}
+
+/* @file_list tells whether the file list of @location is monitored, or
+ * only some of its files, see WATCH_BUDGET_FRACTION. A monitor is returned
+ * even if @location isn't watched. */
 NautilusMonitor *
-nautilus_monitor_directory (GFile *location)
+nautilus_monitor_directory (GFile    *location,
+                            gboolean  file_list)
 {
-    GFileMonitor *dir_monitor;
     NautilusMonitor *ret;
 
     ret = g_slice_new0 (NautilusMonitor);
-    dir_monitor = g_file_monitor_directory (location, G_FILE_MONITOR_WATCH_MOUNTS, NULL, NULL);
+    ret->location = g_object_ref (location);
 
-    if (dir_monitor != NULL)
+    if (file_list ||
+        !g_file_is_native (location) ||
+        n_native_watches < get_watch_budget ())
+    {
+        start_watching (ret);
+    }
+    else
     {
-        ret->monitor = dir_monitor;
+        static gboolean budget_reached_logged = FALSE;
+
+        if (!budget_reached_logged)
+        {
+            g_message ("Watching %u folders for changes, the most allowed. Other "
+                       "folders are only checked again when a window is activated.",
+                       n_native_watches);
+            budget_reached_logged = TRUE;
+        }
+
+        g_debug ("Not watching %s, too many directories are watched already",
+                 g_file_peek_path (location));
+        ret->over_budget = TRUE;
     }
 
     /* Currently, some GVfs backends which support monitoring never emit
@@ -151,24 +275,34 @@ nautilus_monitor_directory (GFile *location)
      */
     if (!g_file_is_native (location))
     {
-        ret->location = g_object_ref (location);
-        ret->volume_monitor = g_volume_monitor_get ();
-    }
+        if (volume_monitor == NULL)
+        {
+            volume_monitor = g_volume_monitor_get ();
+            g_signal_connect (volume_monitor, "mount-removed",
+                              G_CALLBACK (mount_removed), NULL);
+        }
 
-    if (ret->monitor != NULL)
-    {
-        g_signal_connect (ret->monitor, "changed",
-                          G_CALLBACK (dir_changed), ret);
+        non_native_monitors = g_list_prepend (non_native_monitors, ret);
     }
 
-    if (ret->volume_monitor != NULL)
+    return ret;
+}
+
+void
+nautilus_monitor_watch_file_list (NautilusMonitor *monitor)
+{
+    if (!monitor->tried)
     {
-        g_signal_connect (ret->volume_monitor, "mount-removed",
-                          G_CALLBACK (mount_removed), ret);
+        start_watching (monitor);
     }
+}
 
-    /* We return a monitor even on failure, so we can avoid later trying again */
-    return ret;
+/* Whether @monitor doesn't watch its directory because too many are
+ * watched already. Its files may then be out of date. */
+gboolean
+nautilus_monitor_is_over_budget (NautilusMonitor *monitor)
+{
+    return monitor->over_budget;
 }
 
 void
@@ -176,15 +310,24 @@ nautilus_monitor_cancel (NautilusMonitor *monitor)
 {
     if (monitor->monitor != NULL)
     {
+        if (g_file_is_native (monitor->location))
+        {
+            n_native_watches--;
+        }
+
         g_signal_handlers_disconnect_by_func (monitor->monitor, dir_changed, monitor);
         g_file_monitor_cancel (monitor->monitor);
         g_object_unref (monitor->monitor);
     }
 
-    if (monitor->volume_monitor != NULL)
+    if (!g_file_is_native (monitor->location))
     {
-        g_signal_handlers_disconnect_by_func (monitor->volume_monitor, mount_removed, monitor);
-        g_object_unref (monitor->volume_monitor);
+        non_native_monitors = g_list_remove (non_native_monitors, monitor);
+        if (non_native_monitors == NULL)
+        {
+            g_signal_handlers_disconnect_by_func (volume_monitor, mount_removed, NULL);
+            g_clear_object (&volume_monitor);
+        }
     }
 
     g_clear_object (&monitor->location);
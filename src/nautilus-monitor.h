@@ -29,5 +29,8 @@
 
 typedef struct NautilusMonitor NautilusMonitor;
 
-NautilusMonitor *nautilus_monitor_directory (GFile *location);
-void             nautilus_monitor_cancel    (NautilusMonitor *monitor);
+NautilusMonitor *nautilus_monitor_directory       (GFile           *location,
+                                                   gboolean         file_list);
+void             nautilus_monitor_watch_file_list (NautilusMonitor *monitor);
+gboolean         nautilus_monitor_is_over_budget  (NautilusMonitor *monitor);
+void             nautilus_monitor_cancel          (NautilusMonitor *monitor);
@@ -17,6 +17,7 @@ struct _NautilusNameCell
     NautilusViewCell parent_instance;
 
     GSignalGroup *item_signal_group;
+    NautilusFile *monitored_file;
 
     GQuark path_attribute_q;
     GFile *file_path_base_location;
@@ -315,6 +316,38 @@ on_item_is_loading_changed (NautilusNameCell *self)
     }
 }
 
+/* Only the files that have a cell, rather than all the files of the
+ * directory, ask for the info that is costly to get. Unless it is
+ * deferred, directories load it for all their files anyway. */
+static void
+update_file_monitor (NautilusNameCell *self)
+{
+    g_autoptr (NautilusViewItem) item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
+    NautilusFile *file = (item != NULL) ? nautilus_view_item_get_file (item) : NULL;
+
+    if ((nautilus_directory_get_deferred_attributes () & NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO) == 0)
+    {
+        file = NULL;
+    }
+
+    if (file == self->monitored_file)
+    {
+        return;
+    }
+
+    if (self->monitored_file != NULL)
+    {
+        nautilus_file_monitor_remove (self->monitored_file, self);
+        g_clear_pointer (&self->monitored_file, nautilus_file_unref);
+    }
+
+    if (file != NULL)
+    {
+        self->monitored_file = nautilus_file_ref (file);
+        nautilus_file_monitor_add (file, self, NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO);
+    }
+}
+
 static void
 on_map_changed (GtkWidget *widget,
                 gpointer   user_data)
@@ -350,6 +383,8 @@ nautilus_name_cell_init (NautilusNameCell *self)
     g_signal_connect (self, "unmap", G_CALLBACK (on_map_changed), GINT_TO_POINTER (FALSE));
     g_signal_connect (self, "notify::icon-size",
                       G_CALLBACK (on_icon_size_changed), NULL);
+    g_signal_connect_swapped (self, "notify::item",
+                              G_CALLBACK (update_file_monitor), self);
 
     /* Connect automatically to an item. */
     self->item_signal_group = g_signal_group_new (NAUTILUS_TYPE_VIEW_ITEM);
@@ -375,6 +410,12 @@ nautilus_name_cell_dispose (GObject *object)
 {
     NautilusNameCell *self = (NautilusNameCell *) object;
 
+    if (self->monitored_file != NULL)
+    {
+        nautilus_file_monitor_remove (self->monitored_file, self);
+        g_clear_pointer (&self->monitored_file, nautilus_file_unref);
+    }
+
     gtk_widget_dispose_template (GTK_WIDGET (self), NAUTILUS_TYPE_NAME_CELL);
 
     G_OBJECT_CLASS (nautilus_name_cell_parent_class)->dispose (object);
@@ -187,7 +187,7 @@ struct _NautilusPropertiesWindow
     char *mime_type;
 
     gboolean deep_count_finished;
-    GList *deep_count_files;
+    GHashTable *deep_count_files; /* set of NautilusFile * */
     guint deep_count_spinner_timeout_id;
 
     guint long_operation_underway;
@@ -707,9 +707,8 @@ star_clicked (NautilusPropertiesWindow *self)
 {
     NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
     NautilusFile *file = get_file (self);
-    g_autofree gchar *uri = nautilus_file_get_uri (file);
 
-    if (nautilus_tag_manager_file_is_starred (tag_manager, uri))
+    if (nautilus_file_is_starred (file))
     {
         nautilus_tag_manager_unstar_files (tag_manager, G_OBJECT (self),
                                            &(GList){ .data = file }, NULL, NULL);
@@ -729,10 +728,8 @@ update_star (NautilusPropertiesWindow *self,
              NautilusTagManager       *tag_manager)
 {
     gboolean is_starred;
-    g_autofree gchar *file_uri = NULL;
 
-    file_uri = nautilus_file_get_uri (get_file (self));
-    is_starred = nautilus_tag_manager_file_is_starred (tag_manager, file_uri);
+    is_starred = nautilus_file_is_starred (get_file (self));
 
     gtk_button_set_icon_name (GTK_BUTTON (self->star_button),
                               is_starred ? "starred-symbolic" : "non-starred-symbolic");
@@ -1013,13 +1010,12 @@ static void
 stop_deep_count_for_file (NautilusPropertiesWindow *self,
                           NautilusFile             *file)
 {
-    if (g_list_find (self->deep_count_files, file))
+    if (g_hash_table_contains (self->deep_count_files, file))
     {
         g_signal_handlers_disconnect_by_func (file,
                                               G_CALLBACK (schedule_directory_contents_update),
                                               self);
-        nautilus_file_unref (file);
-        self->deep_count_files = g_list_remove (self->deep_count_files, file);
+        g_hash_table_remove (self->deep_count_files, file);
     }
 }
 
@@ -1032,10 +1028,9 @@ start_deep_count_for_file (NautilusFile             *file,
         return;
     }
 
-    if (!g_list_find (self->deep_count_files, file))
+    if (!g_hash_table_contains (self->deep_count_files, file))
     {
-        nautilus_file_ref (file);
-        self->deep_count_files = g_list_prepend (self->deep_count_files, file);
+        g_hash_table_add (self->deep_count_files, nautilus_file_ref (file));
 
         nautilus_file_recompute_deep_counts (file);
         if (!self->deep_count_finished)
@@ -2046,7 +2041,7 @@ directory_contents_value_field_update (NautilusPropertiesWindow *self)
         }
     }
 
-    deep_count_active = (self->deep_count_files != NULL);
+    deep_count_active = (g_hash_table_size (self->deep_count_files) > 0);
     /* If we've already displayed the total once, don't do another visible
      * count-up if the deep_count happens to get invalidated.
      * But still display the new total, since it might have changed.
@@ -3742,7 +3737,7 @@ create_properties_window (StartupData *startup_data)
 
         file = NAUTILUS_FILE (l->data);
 
-        attributes = NAUTILUS_FILE_ATTRIBUTES_FOR_ICON;
+        attributes = NAUTILUS_FILE_ATTRIBUTES_FOR_ICON | NAUTILUS_FILE_ATTRIBUTE_EXTENDED_INFO;
         if (nautilus_file_is_directory (file))
         {
             attributes |= NAUTILUS_FILE_ATTRIBUTE_DEEP_COUNTS;
@@ -3995,9 +3990,19 @@ real_dispose (GObject *object)
 
     g_clear_handle_id (&self->deep_count_spinner_timeout_id, g_source_remove);
 
-    while (self->deep_count_files)
+    if (self->deep_count_files != NULL)
     {
-        stop_deep_count_for_file (self, self->deep_count_files->data);
+        GHashTableIter iter;
+        gpointer file;
+
+        g_hash_table_iter_init (&iter, self->deep_count_files);
+        while (g_hash_table_iter_next (&iter, &file, NULL))
+        {
+            g_signal_handlers_disconnect_by_func (file,
+                                                  G_CALLBACK (schedule_directory_contents_update),
+                                                  self);
+        }
+        g_clear_pointer (&self->deep_count_files, g_hash_table_unref);
     }
 
     g_clear_list (&self->permission_rows, NULL);
@@ -4207,4 +4212,7 @@ static void
 nautilus_properties_window_init (NautilusPropertiesWindow *self)
 {
     gtk_widget_init_template (GTK_WIDGET (self));
+
+    self->deep_count_files = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                    (GDestroyNotify) nautilus_file_unref, NULL);
 }
@@ -358,11 +358,43 @@ prepare_string_for_compare (const gchar *string)
     return res;
 }
 
+/**
+ * nautilus_query_prepare_string:
+ * @string: a string to match queries against
+ *
+ * Normalizes @string the way nautilus_query_matches_string() does, so that
+ * callers matching the same strings many times can do it only once.
+ *
+ * Returns: (transfer full): the string to pass to
+ *   nautilus_query_matches_prepared_string()
+ */
+gchar *
+nautilus_query_prepare_string (const gchar *string)
+{
+    return prepare_string_for_compare (string);
+}
+
 gdouble
 nautilus_query_matches_string (NautilusQuery *query,
                                const gchar   *string)
 {
-    gchar *prepared_string, *ptr;
+    g_autofree gchar *prepared_string = NULL;
+
+    if (!query->text)
+    {
+        return -1;
+    }
+
+    prepared_string = prepare_string_for_compare (string);
+
+    return nautilus_query_matches_prepared_string (query, prepared_string);
+}
+
+gdouble
+nautilus_query_matches_prepared_string (NautilusQuery *query,
+                                        const gchar   *prepared_string)
+{
+    const gchar *ptr;
     gboolean found;
     gdouble retval;
     gint idx, nonexact_malus;
@@ -375,12 +407,11 @@ nautilus_query_matches_string (NautilusQuery *query,
     g_mutex_lock (&query->prepared_words_mutex);
     if (!query->prepared_words)
     {
-        prepared_string = prepare_string_for_compare (query->text);
-        query->prepared_words = g_strsplit (prepared_string, " ", -1);
-        g_free (prepared_string);
+        g_autofree gchar *prepared_text = prepare_string_for_compare (query->text);
+
+        query->prepared_words = g_strsplit (prepared_text, " ", -1);
     }
 
-    prepared_string = prepare_string_for_compare (string);
     found = TRUE;
     ptr = NULL;
     nonexact_malus = 0;
@@ -399,7 +430,6 @@ nautilus_query_matches_string (NautilusQuery *query,
 
     if (!found)
     {
-        g_free (prepared_string);
         return -1;
     }
 
@@ -409,7 +439,6 @@ nautilus_query_matches_string (NautilusQuery *query,
      * smaller amount.
      */
     retval = MAX (MIN_RANK, MAX_RANK - (gdouble) (ptr - prepared_string) - (gdouble) nonexact_malus / RANK_SCALE_FACTOR);
-    g_free (prepared_string);
 
     return retval;
 }
@@ -420,6 +449,37 @@ nautilus_query_new (void)
     return g_object_new (NAUTILUS_TYPE_QUERY, NULL);
 }
 
+/**
+ * nautilus_query_copy:
+ * @query: A #NautilusQuery
+ *
+ * Creates a snapshot of @query, which is not affected by later changes to
+ * @query. The MIME types and date range arrays are shared, since they are
+ * never modified once set.
+ *
+ * Returns: (transfer full): a new #NautilusQuery
+ */
+NautilusQuery *
+nautilus_query_copy (NautilusQuery *query)
+{
+    NautilusQuery *copy;
+
+    g_return_val_if_fail (NAUTILUS_IS_QUERY (query), NULL);
+
+    copy = nautilus_query_new ();
+    copy->text = g_strdup (query->text);
+    g_set_object (&copy->location, query->location);
+    g_ptr_array_unref (copy->mime_types);
+    copy->mime_types = g_ptr_array_ref (query->mime_types);
+    copy->show_hidden = query->show_hidden;
+    copy->date_range = nautilus_query_get_date_range (query);
+    copy->recursive = query->recursive;
+    copy->search_type = query->search_type;
+    copy->search_content = query->search_content;
+
+    return copy;
+}
+
 
 char *
 nautilus_query_get_text (NautilusQuery *query)
@@ -700,3 +760,137 @@ nautilus_query_is_global (NautilusQuery *self)
 
     return (self->location == NULL);
 }
+
+static gboolean
+date_ranges_are_equal (GPtrArray *a,
+                       GPtrArray *b)
+{
+    if (a == b)
+    {
+        return TRUE;
+    }
+
+    if (a == NULL || b == NULL || a->len != b->len)
+    {
+        return FALSE;
+    }
+
+    for (guint i = 0; i < a->len; i++)
+    {
+        GDateTime *date_a = g_ptr_array_index (a, i);
+        GDateTime *date_b = g_ptr_array_index (b, i);
+
+        if (date_a != date_b &&
+            (date_a == NULL || date_b == NULL || !g_date_time_equal (date_a, date_b)))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static gboolean
+mime_types_are_equal (GPtrArray *a,
+                      GPtrArray *b)
+{
+    if (a == b)
+    {
+        return TRUE;
+    }
+
+    if (a->len != b->len)
+    {
+        return FALSE;
+    }
+
+    for (guint i = 0; i < a->len; i++)
+    {
+        if (g_strcmp0 (g_ptr_array_index (a, i), g_ptr_array_index (b, i)) != 0)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * nautilus_query_is_refinement_of:
+ * @query: A #NautilusQuery
+ * @other: A #NautilusQuery
+ *
+ * Checks whether every file matched by @query is also matched by @other, e.g.
+ * because the user typed more characters or picked a date filter. The
+ * results of @other can then be filtered instead of searching again.
+ *
+ * Returns: %TRUE if @query only narrows down @other
+ */
+gboolean
+nautilus_query_is_refinement_of (NautilusQuery *query,
+                                 NautilusQuery *other)
+{
+    g_auto (GStrv) words = NULL;
+    g_auto (GStrv) other_words = NULL;
+    g_autofree gchar *prepared_text = NULL;
+    g_autofree gchar *other_prepared_text = NULL;
+
+    g_return_val_if_fail (NAUTILUS_IS_QUERY (query), FALSE);
+    g_return_val_if_fail (NAUTILUS_IS_QUERY (other), FALSE);
+
+    if (query->text == NULL || other->text == NULL)
+    {
+        return FALSE;
+    }
+
+    if ((query->location == NULL) != (other->location == NULL) ||
+        (query->location != NULL && !g_file_equal (query->location, other->location)))
+    {
+        return FALSE;
+    }
+
+    if (query->recursive != other->recursive ||
+        query->show_hidden != other->show_hidden ||
+        query->search_content != other->search_content)
+    {
+        return FALSE;
+    }
+
+    if (other->date_range != NULL &&
+        (query->search_type != other->search_type ||
+         !date_ranges_are_equal (query->date_range, other->date_range)))
+    {
+        return FALSE;
+    }
+
+    /* The kept matches don't record their MIME type, so they can't be
+     * filtered by a new one. */
+    if (!mime_types_are_equal (query->mime_types, other->mime_types))
+    {
+        return FALSE;
+    }
+
+    /* A file name matches when it contains all the words, so every word of
+     * @other must be contained in some word of @query. */
+    prepared_text = prepare_string_for_compare (query->text);
+    words = g_strsplit (prepared_text, " ", -1);
+    other_prepared_text = prepare_string_for_compare (other->text);
+    other_words = g_strsplit (other_prepared_text, " ", -1);
+
+    for (guint i = 0; other_words[i] != NULL; i++)
+    {
+        gboolean contained = FALSE;
+
+        for (guint j = 0; words[j] != NULL && !contained; j++)
+        {
+            contained = (strstr (words[j], other_words[i]) != NULL);
+        }
+
+        if (!contained)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
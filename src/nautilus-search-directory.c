@@ -605,6 +605,7 @@ search_engine_hits_added (NautilusSearchEngine    *engine,
                           GList                   *hits,
                           NautilusSearchDirectory *self)
 {
+    g_autoptr (GDateTime) now = g_date_time_new_now_local ();
     GList *hit_list;
     GList *file_list;
     NautilusFile *file;
@@ -620,7 +621,7 @@ search_engine_hits_added (NautilusSearchEngine    *engine,
 
         uri = nautilus_search_hit_get_uri (hit);
 
-        nautilus_search_hit_compute_scores (hit, self->query);
+        nautilus_search_hit_compute_scores (hit, self->query, now);
 
         file = nautilus_file_get_by_uri (uri);
         nautilus_file_set_search_relevance (file, nautilus_search_hit_get_relevance (hit));
@@ -24,9 +24,11 @@
 #include "nautilus-search-hit.h"
 #include "nautilus-search-provider.h"
 #include "nautilus-search-engine-model.h"
+#include "nautilus-stall-watchdog.h"
 #include "nautilus-directory.h"
 #include "nautilus-directory-private.h"
 #include "nautilus-file.h"
+#include "nautilus-file-private.h"
 #include "nautilus-ui-utilities.h"
 
 #include <string.h>
@@ -39,13 +41,40 @@ struct _NautilusSearchEngineModel
 
     NautilusQuery *query;
 
-    GList *hits;
     NautilusDirectory *directory;
+    GCancellable *cancellable;
 
     gboolean query_pending;
     guint finished_id;
 };
 
+/* The files are matched in a thread, this many per round trip, so that hits
+ * for huge directories are streamed instead of blocking until the end. */
+#define FILTER_CHUNK_SIZE 10000
+
+/* What is needed from a NautilusFile to match it, copied in the main thread. */
+typedef struct
+{
+    GRefString *name;
+    GRefString *display_name;
+    GRefString *mime_type;
+    time_t mtime;
+    time_t atime;
+    time_t btime;
+} ModelEntry;
+
+typedef struct
+{
+    GFile *location;
+    GArray *entries;     /* ModelEntry */
+    guint next_entry;
+
+    NautilusQuery *query;
+    GPtrArray *mime_types;
+    GPtrArray *date_range;
+    NautilusQuerySearchType search_type;
+} ModelSearchData;
+
 enum
 {
     PROP_0,
@@ -68,11 +97,7 @@ finalize (GObject *object)
 
     model = NAUTILUS_SEARCH_ENGINE_MODEL (object);
 
-    if (model->hits != NULL)
-    {
-        g_list_free_full (model->hits, g_object_unref);
-        model->hits = NULL;
-    }
+    g_clear_object (&model->cancellable);
 
     if (model->finished_id != 0)
     {
@@ -91,15 +116,6 @@ search_finished (NautilusSearchEngineModel *model)
 {
     model->finished_id = 0;
 
-    if (model->hits != NULL)
-    {
-        g_debug ("Model engine hits added");
-        nautilus_search_provider_hits_added (NAUTILUS_SEARCH_PROVIDER (model),
-                                             model->hits);
-        g_list_free_full (model->hits, g_object_unref);
-        model->hits = NULL;
-    }
-
     model->query_pending = FALSE;
 
     g_object_notify (G_OBJECT (model), "running");
@@ -124,126 +140,268 @@ search_finished_idle (NautilusSearchEngineModel *model)
 }
 
 static void
-model_directory_ready_cb (NautilusDirectory *directory,
-                          GList             *list,
-                          gpointer           user_data)
+model_entry_clear (ModelEntry *entry)
 {
-    NautilusSearchEngineModel *model = user_data;
-    g_autoptr (GPtrArray) mime_types = NULL;
-    gchar *uri;
-    GList *files, *hits, *l;
-    NautilusFile *file;
+    g_clear_pointer (&entry->name, g_ref_string_release);
+    g_clear_pointer (&entry->display_name, g_ref_string_release);
+    g_clear_pointer (&entry->mime_type, g_ref_string_release);
+}
+
+static void
+model_search_data_free (ModelSearchData *data)
+{
+    g_object_unref (data->location);
+    g_array_unref (data->entries);
+    g_object_unref (data->query);
+    g_ptr_array_unref (data->mime_types);
+    g_clear_pointer (&data->date_range, g_ptr_array_unref);
+    g_free (data);
+}
+
+static void
+hit_list_free (GList *hits)
+{
+    g_list_free_full (hits, g_object_unref);
+}
+
+static NautilusSearchHit *
+match_entry (ModelSearchData *data,
+             ModelEntry      *entry)
+{
+    NautilusSearchHit *hit;
+    g_autoptr (GFile) child = NULL;
+    g_autofree gchar *uri = NULL;
+    g_autoptr (GDateTime) mtime = NULL;
+    g_autoptr (GDateTime) atime = NULL;
+    g_autoptr (GDateTime) ctime = NULL;
     gdouble match;
     gboolean found;
-    NautilusSearchHit *hit;
-    GDateTime *initial_date;
-    GDateTime *end_date;
-    GPtrArray *date_range;
 
-    files = nautilus_directory_get_file_list (directory);
-    mime_types = nautilus_query_get_mime_types (model->query);
-    hits = NULL;
+    match = nautilus_query_matches_string (data->query, entry->display_name);
+    if (match <= -1)
+    {
+        return NULL;
+    }
 
-    for (l = files; l != NULL; l = l->next)
+    if (data->mime_types->len > 0)
     {
-        g_autofree gchar *display_name = NULL;
-        g_autoptr (GDateTime) mtime = NULL;
-        g_autoptr (GDateTime) atime = NULL;
-        g_autoptr (GDateTime) ctime = NULL;
+        found = FALSE;
 
-        file = l->data;
+        for (guint i = 0; entry->mime_type != NULL && i < data->mime_types->len; i++)
+        {
+            if (g_content_type_is_a (entry->mime_type, g_ptr_array_index (data->mime_types, i)))
+            {
+                found = TRUE;
+                break;
+            }
+        }
 
-        match = nautilus_query_matches_string (model->query,
-                                               nautilus_file_get_display_name (file));
-        found = (match > -1);
         if (!found)
         {
-            continue;
+            return NULL;
         }
+    }
+
+    mtime = g_date_time_new_from_unix_local (entry->mtime);
+    atime = g_date_time_new_from_unix_local (entry->atime);
+    ctime = g_date_time_new_from_unix_local (entry->btime);
+
+    if (data->date_range != NULL)
+    {
+        GDateTime *initial_date;
+        GDateTime *end_date;
+        GDateTime *target_date;
 
-        if (mime_types->len > 0)
+        initial_date = g_ptr_array_index (data->date_range, 0);
+        end_date = g_ptr_array_index (data->date_range, 1);
+
+        switch (data->search_type)
         {
-            found = FALSE;
+            case NAUTILUS_QUERY_SEARCH_TYPE_LAST_ACCESS:
+            {
+                target_date = atime;
+            }
+            break;
+
+            case NAUTILUS_QUERY_SEARCH_TYPE_LAST_MODIFIED:
+            {
+                target_date = mtime;
+            }
+            break;
+
+            case NAUTILUS_QUERY_SEARCH_TYPE_CREATED:
+            {
+                target_date = ctime;
+            }
+            break;
 
-            for (guint i = 0; i < mime_types->len; i++)
+            default:
             {
-                if (nautilus_file_is_mime_type (file, g_ptr_array_index (mime_types, i)))
-                {
-                    found = TRUE;
-                    break;
-                }
+                target_date = NULL;
             }
         }
-        if (!found)
+
+        if (!nautilus_date_time_is_between_dates (target_date,
+                                                  initial_date,
+                                                  end_date))
         {
-            continue;
+            return NULL;
         }
+    }
+
+    child = g_file_get_child (data->location, entry->name);
+    uri = g_file_get_uri (child);
 
-        mtime = g_date_time_new_from_unix_local (nautilus_file_get_mtime (file));
-        atime = g_date_time_new_from_unix_local (nautilus_file_get_atime (file));
-        ctime = g_date_time_new_from_unix_local (nautilus_file_get_btime (file));
+    hit = nautilus_search_hit_new (uri);
+    nautilus_search_hit_set_fts_rank (hit, match);
+    nautilus_search_hit_set_modification_time (hit, mtime);
+    nautilus_search_hit_set_access_time (hit, atime);
+    nautilus_search_hit_set_creation_time (hit, ctime);
 
-        date_range = nautilus_query_get_date_range (model->query);
-        if (found && date_range != NULL)
+    return hit;
+}
+
+static void
+filter_chunk_thread_func (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+    ModelSearchData *data = task_data;
+    GList *hits = NULL;
+    guint end;
+
+    end = MIN (data->next_entry + FILTER_CHUNK_SIZE, data->entries->len);
+
+    for (guint i = data->next_entry; i < end; i++)
+    {
+        NautilusSearchHit *hit;
+
+        hit = match_entry (data, &g_array_index (data->entries, ModelEntry, i));
+        if (hit != NULL)
         {
-            NautilusQuerySearchType type;
-            GDateTime *target_date;
+            hits = g_list_prepend (hits, hit);
+        }
+    }
 
-            type = nautilus_query_get_search_type (model->query);
-            initial_date = g_ptr_array_index (date_range, 0);
-            end_date = g_ptr_array_index (date_range, 1);
+    data->next_entry = end;
 
-            switch (type)
-            {
-                case NAUTILUS_QUERY_SEARCH_TYPE_LAST_ACCESS:
-                {
-                    target_date = atime;
-                }
-                break;
+    g_task_return_pointer (task, hits, (GDestroyNotify) hit_list_free);
+}
 
-                case NAUTILUS_QUERY_SEARCH_TYPE_LAST_MODIFIED:
-                {
-                    target_date = mtime;
-                }
-                break;
+static void filter_chunk_callback (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data);
 
-                case NAUTILUS_QUERY_SEARCH_TYPE_CREATED:
-                {
-                    target_date = ctime;
-                }
-                break;
+static void
+filter_next_chunk (NautilusSearchEngineModel *model,
+                   ModelSearchData           *data)
+{
+    g_autoptr (GTask) task = NULL;
+
+    /* The search data is handed from one chunk to the next, and freed by
+     * the callback of the last one. */
+    task = g_task_new (model, model->cancellable, filter_chunk_callback, NULL);
+    g_task_set_source_tag (task, filter_next_chunk);
+    g_task_set_task_data (task, data, NULL);
+    g_task_run_in_thread (task, filter_chunk_thread_func);
+}
 
-                default:
-                {
-                    target_date = NULL;
-                }
-            }
+static void
+filter_chunk_callback (GObject      *object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+    NautilusSearchEngineModel *model;
+    ModelSearchData *data;
+    g_autoptr (GError) error = NULL;
+    GList *hits;
 
-            found = nautilus_date_time_is_between_dates (target_date,
-                                                         initial_date,
-                                                         end_date);
-            g_ptr_array_unref (date_range);
-        }
+    model = NAUTILUS_SEARCH_ENGINE_MODEL (object);
+    data = g_task_get_task_data (G_TASK (result));
 
-        if (found)
-        {
-            uri = nautilus_file_get_uri (file);
-            hit = nautilus_search_hit_new (uri);
-            nautilus_search_hit_set_fts_rank (hit, match);
-            nautilus_search_hit_set_modification_time (hit, mtime);
-            nautilus_search_hit_set_access_time (hit, atime);
-            nautilus_search_hit_set_creation_time (hit, ctime);
+    /* This fails right away if the search was stopped in the meantime, in
+     * which case it has already been reported as finished. */
+    hits = g_task_propagate_pointer (G_TASK (result), &error);
+    if (error != NULL)
+    {
+        model_search_data_free (data);
+        return;
+    }
 
-            hits = g_list_prepend (hits, hit);
+    if (hits != NULL)
+    {
+        gint64 watchdog_start = nautilus_stall_watchdog_begin ();
+
+        g_debug ("Model engine hits added");
+        nautilus_search_provider_hits_added (NAUTILUS_SEARCH_PROVIDER (model), hits);
+        nautilus_stall_watchdog_end (watchdog_start, "filter_chunk_callback",
+                                     g_list_length (hits));
+        hit_list_free (hits);
+    }
 
-            g_free (uri);
+    if (data->next_entry < data->entries->len)
+    {
+        filter_next_chunk (model, data);
+    }
+    else
+    {
+        model_search_data_free (data);
+        search_finished (model);
+    }
+}
+
+static void
+model_directory_ready_cb (NautilusDirectory *directory,
+                          GList             *list,
+                          gpointer           user_data)
+{
+    NautilusSearchEngineModel *model = user_data;
+    ModelSearchData *data;
+    GList *files;
+
+    data = g_new0 (ModelSearchData, 1);
+    data->location = nautilus_directory_get_location (directory);
+    data->query = nautilus_query_copy (model->query);
+    data->mime_types = nautilus_query_get_mime_types (data->query);
+    data->date_range = nautilus_query_get_date_range (data->query);
+    data->search_type = nautilus_query_get_search_type (data->query);
+
+    /* Only take what matching needs here, the matching itself, which is
+     * what takes time in large directories, happens in a thread. */
+    files = nautilus_directory_get_file_list (directory);
+    data->entries = g_array_sized_new (FALSE, TRUE, sizeof (ModelEntry), g_list_length (files));
+    g_array_set_clear_func (data->entries, (GDestroyNotify) model_entry_clear);
+
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        NautilusFile *file = l->data;
+        ModelEntry entry = { 0 };
+
+        /* Makes sure the display name is set. */
+        nautilus_file_get_display_name (file);
+
+        if (nautilus_file_is_self_owned (file) || file->details->display_name == NULL)
+        {
+            continue;
         }
+
+        entry.name = g_ref_string_acquire (file->details->name);
+        entry.display_name = g_ref_string_acquire (file->details->display_name);
+        if (data->mime_types->len > 0 && file->details->mime_type != NULL)
+        {
+            entry.mime_type = g_ref_string_acquire (file->details->mime_type);
+        }
+        entry.mtime = file->details->mtime;
+        entry.atime = file->details->atime;
+        entry.btime = file->details->btime;
+
+        g_array_append_val (data->entries, entry);
     }
 
     nautilus_file_list_free (files);
-    model->hits = hits;
 
-    search_finished (model);
+    filter_next_chunk (model, data);
 }
 
 static void
@@ -263,6 +421,9 @@ nautilus_search_engine_model_start (NautilusSearchProvider *provider)
     g_object_ref (model);
     model->query_pending = TRUE;
 
+    g_clear_object (&model->cancellable);
+    model->cancellable = g_cancellable_new ();
+
     g_object_notify (G_OBJECT (provider), "running");
 
     if (model->directory == NULL)
@@ -287,6 +448,7 @@ nautilus_search_engine_model_stop (NautilusSearchProvider *provider)
     {
         g_debug ("Model engine stop");
 
+        g_cancellable_cancel (model->cancellable);
         nautilus_directory_cancel_callback (model->directory,
                                             model_directory_ready_cb, model);
         search_finished_idle (model);
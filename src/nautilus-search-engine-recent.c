@@ -36,6 +36,35 @@
         G_FILE_ATTRIBUTE_TIME_ACCESS "," \
         G_FILE_ATTRIBUTE_TIME_CREATED
 
+/* How long a file checked by a previous search is trusted not to have
+ * changed on disk, as long as its recent item wasn't updated either. */
+#define VALIDATION_MAX_AGE_US (30 * G_USEC_PER_SEC)
+
+/* A recent item, with its names already prepared for matching. The index is
+ * built on the main thread and never modified afterwards, so search threads
+ * can read it without locking. */
+typedef struct
+{
+    gchar *uri;
+    GFile *file;
+    gchar *prepared_display_name;
+    gchar *prepared_short_name;
+    gchar *mime_type;
+    gint64 modified;
+} RecentItem;
+
+typedef struct
+{
+    gint64 recent_modified;
+    gint64 validated_time;
+    gboolean readable;
+    /* Readable, and neither it nor any of its parents is hidden. */
+    gboolean visible;
+    GDateTime *mtime;
+    GDateTime *atime;
+    GDateTime *ctime;
+} FileValidation;
+
 struct _NautilusSearchEngineRecent
 {
     GObject parent_instance;
@@ -45,6 +74,12 @@ struct _NautilusSearchEngineRecent
     GCancellable *cancellable;
     GtkRecentManager *recent_manager;
     guint add_hits_idle_id;
+
+    GPtrArray *index;     /* RecentItem *, NULL until the next search */
+    GPtrArray *search_index;     /* The index the running search uses */
+
+    GMutex validations_mutex;
+    GHashTable *validations;     /* URI -> FileValidation * */
 };
 
 static void nautilus_search_provider_init (NautilusSearchProviderInterface *iface);
@@ -69,6 +104,26 @@ nautilus_search_engine_recent_new (void)
     return g_object_new (NAUTILUS_TYPE_SEARCH_ENGINE_RECENT, NULL);
 }
 
+static void
+recent_item_free (RecentItem *item)
+{
+    g_free (item->uri);
+    g_object_unref (item->file);
+    g_free (item->prepared_display_name);
+    g_free (item->prepared_short_name);
+    g_free (item->mime_type);
+    g_free (item);
+}
+
+static void
+file_validation_free (FileValidation *validation)
+{
+    g_clear_pointer (&validation->mtime, g_date_time_unref);
+    g_clear_pointer (&validation->atime, g_date_time_unref);
+    g_clear_pointer (&validation->ctime, g_date_time_unref);
+    g_free (validation);
+}
+
 static void
 nautilus_search_engine_recent_finalize (GObject *object)
 {
@@ -79,6 +134,10 @@ nautilus_search_engine_recent_finalize (GObject *object)
 
     g_clear_object (&self->query);
     g_clear_object (&self->cancellable);
+    g_clear_pointer (&self->index, g_ptr_array_unref);
+    g_clear_pointer (&self->search_index, g_ptr_array_unref);
+    g_clear_pointer (&self->validations, g_hash_table_destroy);
+    g_mutex_clear (&self->validations_mutex);
 
     G_OBJECT_CLASS (nautilus_search_engine_recent_parent_class)->finalize (object);
 }
@@ -108,6 +167,7 @@ search_thread_add_hits_idle (gpointer user_data)
     self->running = FALSE;
     g_list_free_full (search_hits->hits, g_object_unref);
     g_clear_object (&self->cancellable);
+    g_clear_pointer (&self->search_index, g_ptr_array_unref);
     g_free (search_hits);
 
     g_debug ("Recent engine finished");
@@ -137,147 +197,186 @@ search_add_hits_idle (NautilusSearchEngineRecent *self,
     self->add_hits_idle_id = g_idle_add (search_thread_add_hits_idle, search_hits);
 }
 
-static gboolean
-is_file_valid_recursive (NautilusSearchEngineRecent  *self,
-                         GFile                       *file,
-                         GDateTime                  **mtime,
-                         GDateTime                  **atime,
-                         GDateTime                  **ctime,
-                         GError                     **error)
+/* Returns the validation of @file, checking it on disk only if no search
+ * checked it recently. @recent_modified is the time its recent item was last
+ * updated, or 0 for the parents of recent items. */
+static FileValidation *
+get_file_validation (NautilusSearchEngineRecent  *self,
+                     GFile                       *file,
+                     const gchar                 *uri,
+                     gint64                       recent_modified,
+                     GCancellable                *cancellable,
+                     GError                     **error)
 {
     g_autoptr (GFileInfo) file_info = NULL;
-
-    file_info = g_file_query_info (file, FILE_ATTRIBS,
-                                   G_FILE_QUERY_INFO_NONE,
-                                   self->cancellable, error);
-    if (*error != NULL)
+    g_autoptr (GFile) parent = NULL;
+    g_autofree gchar *parent_uri = NULL;
+    FileValidation *validation;
+    gboolean is_hidden;
+    gint64 now = g_get_monotonic_time ();
+
+    g_mutex_lock (&self->validations_mutex);
+    validation = g_hash_table_lookup (self->validations, uri);
+    g_mutex_unlock (&self->validations_mutex);
+
+    /* Only one search runs at a time, and entries are only dropped between
+     * searches, so the entry stays valid after unlocking. */
+    if (validation != NULL &&
+        validation->recent_modified == recent_modified &&
+        now - validation->validated_time < VALIDATION_MAX_AGE_US)
     {
-        return FALSE;
+        return validation;
     }
 
-    if (!g_file_info_get_attribute_boolean (file_info,
-                                            G_FILE_ATTRIBUTE_ACCESS_CAN_READ))
+    validation = g_new0 (FileValidation, 1);
+    validation->recent_modified = recent_modified;
+    validation->validated_time = now;
+
+    file_info = g_file_query_info (file, FILE_ATTRIBS,
+                                   G_FILE_QUERY_INFO_NONE,
+                                   cancellable, error);
+    if (file_info == NULL)
     {
-        return FALSE;
+        if (g_error_matches (*error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_free (validation);
+            return NULL;
+        }
     }
-
-    if (mtime && atime && ctime)
+    else
     {
-        *mtime = g_file_info_get_modification_date_time (file_info);
-        *atime = g_file_info_get_access_date_time (file_info);
-        *ctime = g_file_info_get_creation_date_time (file_info);
+        validation->readable = g_file_info_get_attribute_boolean (file_info,
+                                                                  G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
     }
 
-    if (!nautilus_query_get_show_hidden_files (self->query))
+    if (validation->readable)
     {
-        gboolean is_hidden;
+        validation->mtime = g_file_info_get_modification_date_time (file_info);
+        validation->atime = g_file_info_get_access_date_time (file_info);
+        validation->ctime = g_file_info_get_creation_date_time (file_info);
 
         is_hidden = g_file_info_get_attribute_boolean (file_info,
                                                        G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN) ||
                     g_file_info_get_attribute_boolean (file_info,
                                                        G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP);
-        if (!is_hidden)
-        {
-            g_autoptr (GFile) parent = g_file_get_parent (file);
+        parent = g_file_get_parent (file);
 
-            if (parent)
+        if (is_hidden)
+        {
+            validation->visible = FALSE;
+        }
+        else if (parent != NULL)
+        {
+            FileValidation *parent_validation;
+
+            /* The parent is shared by most other recent files in the same
+             * directory, so it is cached like they are. */
+            parent_uri = g_file_get_uri (parent);
+            parent_validation = get_file_validation (self, parent, parent_uri, 0,
+                                                     cancellable, error);
+            if (parent_validation == NULL)
             {
-                return is_file_valid_recursive (self, parent,
-                                                NULL, NULL, NULL,
-                                                error);
+                file_validation_free (validation);
+                return NULL;
             }
+
+            validation->visible = parent_validation->readable &&
+                                  parent_validation->visible;
         }
         else
         {
-            return FALSE;
+            validation->visible = TRUE;
         }
     }
 
-    return TRUE;
+    g_mutex_lock (&self->validations_mutex);
+    g_hash_table_replace (self->validations, g_strdup (uri), validation);
+    g_mutex_unlock (&self->validations_mutex);
+
+    return validation;
 }
 
 static gpointer
 recent_thread_func (gpointer user_data)
 {
     g_autoptr (NautilusSearchEngineRecent) self = NAUTILUS_SEARCH_ENGINE_RECENT (user_data);
+    GPtrArray *index;
     g_autoptr (GPtrArray) date_range = NULL;
     g_autoptr (GFile) query_location = NULL;
     g_autoptr (GPtrArray) mime_types = NULL;
-    GList *recent_items;
+    g_autoptr (GCancellable) cancellable = NULL;
+    gboolean show_hidden;
     GList *hits;
-    GList *l;
 
     g_return_val_if_fail (self->query, NULL);
 
     hits = NULL;
-    recent_items = gtk_recent_manager_get_items (self->recent_manager);
+    index = self->search_index;
+    cancellable = g_object_ref (self->cancellable);
     mime_types = nautilus_query_get_mime_types (self->query);
     date_range = nautilus_query_get_date_range (self->query);
     query_location = nautilus_query_get_location (self->query);
+    show_hidden = nautilus_query_get_show_hidden_files (self->query);
 
-    for (l = recent_items; l != NULL; l = l->next)
+    for (guint i = 0; i < index->len; i++)
     {
-        GtkRecentInfo *info = l->data;
-        g_autoptr (GFile) file = NULL;
-        const gchar *uri;
-        const gchar *name;
+        RecentItem *item = g_ptr_array_index (index, i);
+        FileValidation *validation;
         gdouble rank;
 
-        uri = gtk_recent_info_get_uri (info);
-        file = g_file_new_for_uri (uri);
-
-        if (query_location != NULL && !g_file_has_prefix (file, query_location))
+        if (query_location != NULL && !g_file_has_prefix (item->file, query_location))
         {
             continue;
         }
 
-        if (g_cancellable_is_cancelled (self->cancellable))
+        if (g_cancellable_is_cancelled (cancellable))
         {
             break;
         }
 
-        name = gtk_recent_info_get_display_name (info);
-        rank = nautilus_query_matches_string (self->query, name);
+        rank = nautilus_query_matches_prepared_string (self->query,
+                                                       item->prepared_display_name);
 
         if (rank <= 0)
         {
-            g_autofree char *short_name = gtk_recent_info_get_short_name (info);
-            rank = nautilus_query_matches_string (self->query, short_name);
+            rank = nautilus_query_matches_prepared_string (self->query,
+                                                           item->prepared_short_name);
         }
 
         if (rank > 0)
         {
             NautilusSearchHit *hit;
-            g_autoptr (GDateTime) mtime = NULL;
-            g_autoptr (GDateTime) atime = NULL;
-            g_autoptr (GDateTime) ctime = NULL;
+            GDateTime *mtime;
+            GDateTime *atime;
+            GDateTime *ctime;
             g_autoptr (GError) error = NULL;
 
-            if (!gtk_recent_info_is_local (info))
+            validation = get_file_validation (self, item->file, item->uri,
+                                              item->modified, cancellable, &error);
+            if (validation == NULL)
             {
-                continue;
+                break;
             }
 
-            if (!is_file_valid_recursive (self, file, &mtime, &atime, &ctime, &error))
+            if (error != NULL &&
+                !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_EXISTS))
             {
-                if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-                {
-                    break;
-                }
-
-                if (error != NULL &&
-                    !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_EXISTS))
-                {
-                    g_debug ("Impossible to read recent file info: %s",
-                             error->message);
-                }
+                g_debug ("Impossible to read recent file info: %s",
+                         error->message);
+            }
 
+            if (!validation->readable || (!show_hidden && !validation->visible))
+            {
                 continue;
             }
 
+            mtime = validation->mtime;
+            atime = validation->atime;
+            ctime = validation->ctime;
+
             if (mime_types->len > 0)
             {
-                const gchar *mime_type = gtk_recent_info_get_mime_type (info);
+                const gchar *mime_type = item->mime_type;
                 gboolean found = FALSE;
 
                 for (guint i = 0; mime_type != NULL && i < mime_types->len; i++)
@@ -340,7 +439,7 @@ recent_thread_func (gpointer user_data)
                 }
             }
 
-            hit = nautilus_search_hit_new (uri);
+            hit = nautilus_search_hit_new (item->uri);
             nautilus_search_hit_set_fts_rank (hit, rank);
             nautilus_search_hit_set_modification_time (hit, mtime);
             nautilus_search_hit_set_access_time (hit, atime);
@@ -352,9 +451,75 @@ recent_thread_func (gpointer user_data)
 
     search_add_hits_idle (self, hits);
 
+    return NULL;
+}
+
+static gboolean
+validation_is_unused (gpointer key,
+                      gpointer value,
+                      gpointer user_data)
+{
+    FileValidation *validation = value;
+    GHashTable *uris = user_data;
+
+    /* Parents of recent files are kept while they are fresh. */
+    if (validation->recent_modified == 0)
+    {
+        return g_get_monotonic_time () - validation->validated_time >= VALIDATION_MAX_AGE_US;
+    }
+
+    return !g_hash_table_contains (uris, key);
+}
+
+static void
+build_index (NautilusSearchEngineRecent *self)
+{
+    g_autoptr (GHashTable) uris = g_hash_table_new (g_str_hash, g_str_equal);
+    GList *recent_items;
+
+    self->index = g_ptr_array_new_with_free_func ((GDestroyNotify) recent_item_free);
+    recent_items = gtk_recent_manager_get_items (self->recent_manager);
+
+    for (GList *l = recent_items; l != NULL; l = l->next)
+    {
+        GtkRecentInfo *info = l->data;
+        g_autofree gchar *short_name = NULL;
+        RecentItem *item;
+
+        /* Only local files can be hits. */
+        if (!gtk_recent_info_is_local (info))
+        {
+            continue;
+        }
+
+        short_name = gtk_recent_info_get_short_name (info);
+
+        item = g_new0 (RecentItem, 1);
+        item->uri = g_strdup (gtk_recent_info_get_uri (info));
+        item->file = g_file_new_for_uri (item->uri);
+        item->prepared_display_name = nautilus_query_prepare_string (gtk_recent_info_get_display_name (info));
+        item->prepared_short_name = nautilus_query_prepare_string (short_name);
+        item->mime_type = g_strdup (gtk_recent_info_get_mime_type (info));
+        item->modified = g_date_time_to_unix (gtk_recent_info_get_modified (info));
+
+        g_ptr_array_add (self->index, item);
+        g_hash_table_add (uris, item->uri);
+    }
+
+    /* Drop what was cached for files which are not recent anymore. */
+    g_mutex_lock (&self->validations_mutex);
+    g_hash_table_foreach_remove (self->validations, validation_is_unused, uris);
+    g_mutex_unlock (&self->validations_mutex);
+
     g_list_free_full (recent_items, (GDestroyNotify) gtk_recent_info_unref);
+}
 
-    return NULL;
+static void
+on_recent_manager_changed (NautilusSearchEngineRecent *self)
+{
+    /* Rebuilt when the next search starts, as the list often changes
+     * several times in a row. */
+    g_clear_pointer (&self->index, g_ptr_array_unref);
 }
 
 static void
@@ -368,8 +533,14 @@ nautilus_search_engine_recent_start (NautilusSearchProvider *provider)
 
     g_debug ("Recent engine start");
 
+    if (self->index == NULL)
+    {
+        build_index (self);
+    }
+
     self->running = TRUE;
     self->cancellable = g_cancellable_new ();
+    self->search_index = g_ptr_array_ref (self->index);
     thread = g_thread_new ("nautilus-search-recent", recent_thread_func,
                            g_object_ref (self));
 
@@ -457,4 +628,12 @@ static void
 nautilus_search_engine_recent_init (NautilusSearchEngineRecent *self)
 {
     self->recent_manager = gtk_recent_manager_get_default ();
+
+    g_mutex_init (&self->validations_mutex);
+    self->validations = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               (GDestroyNotify) file_validation_free);
+
+    g_signal_connect_object (self->recent_manager, "changed",
+                             G_CALLBACK (on_recent_manager_changed), self,
+                             G_CONNECT_SWAPPED);
 }
@@ -25,6 +25,7 @@
 
 #include "nautilus-search-hit.h"
 #include "nautilus-search-provider.h"
+#include "nautilus-stall-watchdog.h"
 #include "nautilus-ui-utilities.h"
 
 #include <string.h>
@@ -33,6 +34,9 @@
 
 #define BATCH_SIZE 500
 #define CREATE_THREAD_DELAY_MS 500
+/* How long the matches of a finished search can be reused to answer a
+ * refined query, before files are likely to have changed on disk. */
+#define REFINE_MAX_AGE_US (30 * G_USEC_PER_SEC)
 
 enum
 {
@@ -41,15 +45,37 @@ enum
     NUM_PROPERTIES
 };
 
+typedef struct
+{
+    GFile *location;
+    /* Number of directories between the query location and this one. */
+    guint depth;
+} PendingDirectory;
+
+/* A file that matched the query, kept to filter it again for refined queries. */
+typedef struct
+{
+    gchar *uri;
+    gchar *display_name;
+    GDateTime *mtime;
+    GDateTime *atime;
+    GDateTime *ctime;
+    guint depth;
+} FoundFile;
+
 typedef struct
 {
     NautilusSearchEngineSimple *engine;
     GCancellable *cancellable;
 
     GPtrArray *mime_types;
-    GList *found_list;
+    /* Matches in the fully visited directories, FoundFile */
+    GPtrArray *found_files;
+    /* Whether the found files are from a previous, broader query and must be
+     * filtered again before the crawl continues. */
+    gboolean refining;
 
-    GQueue *directories;     /* GFiles */
+    GQueue *directories;     /* PendingDirectory */
 
     GHashTable *visited;
 
@@ -57,6 +83,8 @@ typedef struct
     GList *hits;
 
     NautilusQuery *query;
+    /* Reference time for the recency scores of this search. */
+    GDateTime *now;
     gint processing_id;
     GMutex idle_mutex;
     /* The following data can be accessed from different threads
@@ -64,6 +92,7 @@ typedef struct
      */
     GQueue *idle_queue;
     gboolean finished;
+    gint64 finished_time;
 } SearchThreadData;
 
 
@@ -74,6 +103,8 @@ struct _NautilusSearchEngineSimple
     guint create_thread_timeout_id;
 
     SearchThreadData *active_search;
+    /* The last search, kept to answer a refined query from where it was. */
+    SearchThreadData *previous_search;
 };
 
 static void nautilus_search_provider_init (NautilusSearchProviderInterface *iface);
@@ -84,16 +115,86 @@ G_DEFINE_TYPE_WITH_CODE (NautilusSearchEngineSimple,
                          G_IMPLEMENT_INTERFACE (NAUTILUS_TYPE_SEARCH_PROVIDER,
                                                 nautilus_search_provider_init))
 
+static void search_thread_data_free (SearchThreadData *data);
+
 static void
 finalize (GObject *object)
 {
     NautilusSearchEngineSimple *simple = NAUTILUS_SEARCH_ENGINE_SIMPLE (object);
     g_clear_object (&simple->query);
+    g_clear_pointer (&simple->previous_search, search_thread_data_free);
     g_clear_handle_id (&simple->create_thread_timeout_id, g_source_remove);
 
     G_OBJECT_CLASS (nautilus_search_engine_simple_parent_class)->finalize (object);
 }
 
+static PendingDirectory *
+pending_directory_new (GFile *location,
+                       guint  depth)
+{
+    PendingDirectory *pending;
+
+    pending = g_new0 (PendingDirectory, 1);
+    pending->location = g_object_ref (location);
+    pending->depth = depth;
+
+    return pending;
+}
+
+static void
+pending_directory_free (PendingDirectory *pending)
+{
+    g_object_unref (pending->location);
+    g_free (pending);
+}
+
+static void
+found_file_free (FoundFile *found)
+{
+    g_free (found->uri);
+    g_free (found->display_name);
+    g_clear_pointer (&found->mtime, g_date_time_unref);
+    g_clear_pointer (&found->atime, g_date_time_unref);
+    g_clear_pointer (&found->ctime, g_date_time_unref);
+    g_free (found);
+}
+
+static void
+search_thread_data_clear_hits (SearchThreadData *data)
+{
+    GList *hits;
+
+    g_clear_list (&data->hits, g_object_unref);
+
+    while ((hits = g_queue_pop_head (data->idle_queue)))
+    {
+        g_list_free_full (hits, g_object_unref);
+    }
+}
+
+/* Sets up @data, new or left by a previous search, to search for @query. */
+static void
+search_thread_data_reset (SearchThreadData           *data,
+                          NautilusSearchEngineSimple *engine,
+                          NautilusQuery              *query)
+{
+    g_set_object (&data->engine, engine);
+    g_clear_object (&data->query);
+    data->query = nautilus_query_copy (query);
+    g_clear_pointer (&data->now, g_date_time_unref);
+    data->now = g_date_time_new_now_local ();
+    g_clear_pointer (&data->mime_types, g_ptr_array_unref);
+    data->mime_types = nautilus_query_get_mime_types (data->query);
+
+    g_clear_object (&data->cancellable);
+    data->cancellable = g_cancellable_new ();
+
+    search_thread_data_clear_hits (data);
+    data->n_processed_files = 0;
+    data->processing_id = 0;
+    data->finished = FALSE;
+}
+
 static SearchThreadData *
 search_thread_data_new (NautilusSearchEngineSimple *engine,
                         NautilusQuery              *query)
@@ -102,40 +203,32 @@ search_thread_data_new (NautilusSearchEngineSimple *engine,
 
     data = g_new0 (SearchThreadData, 1);
 
-    data->engine = g_object_ref (engine);
     data->directories = g_queue_new ();
     data->visited = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-    data->query = g_object_ref (query);
-    data->mime_types = nautilus_query_get_mime_types (query);
-
-    data->cancellable = g_cancellable_new ();
+    data->found_files = g_ptr_array_new_with_free_func ((GDestroyNotify) found_file_free);
 
     g_mutex_init (&data->idle_mutex);
     data->idle_queue = g_queue_new ();
 
+    search_thread_data_reset (data, engine, query);
+
     return data;
 }
 
 static void
 search_thread_data_free (SearchThreadData *data)
 {
-    GList *hits;
-
-    g_queue_foreach (data->directories,
-                     (GFunc) g_object_unref, NULL);
-    g_queue_free (data->directories);
+    g_queue_free_full (data->directories, (GDestroyNotify) pending_directory_free);
     g_hash_table_destroy (data->visited);
+    g_ptr_array_unref (data->found_files);
     g_object_unref (data->cancellable);
     g_object_unref (data->query);
+    g_date_time_unref (data->now);
     g_clear_pointer (&data->mime_types, g_ptr_array_unref);
-    g_list_free_full (data->hits, g_object_unref);
-    g_object_unref (data->engine);
+    g_clear_object (&data->engine);
     g_mutex_clear (&data->idle_mutex);
 
-    while ((hits = g_queue_pop_head (data->idle_queue)))
-    {
-        g_list_free_full (hits, g_object_unref);
-    }
+    search_thread_data_clear_hits (data);
     g_queue_free (data->idle_queue);
 
     g_free (data);
@@ -144,7 +237,7 @@ search_thread_data_free (SearchThreadData *data)
 static gboolean
 search_thread_done (SearchThreadData *data)
 {
-    NautilusSearchEngineSimple *engine = data->engine;
+    g_autoptr (NautilusSearchEngineSimple) engine = g_object_ref (data->engine);
 
     if (g_cancellable_is_cancelled (data->cancellable))
     {
@@ -155,13 +248,21 @@ search_thread_done (SearchThreadData *data)
         g_debug ("Simple engine finished");
     }
     engine->active_search = NULL;
+
+    /* Keep the search around, even if it was cancelled, in case the next
+     * query only narrows this one down. This must happen before reporting
+     * the search as finished, because that may start the next one. */
+    g_clear_pointer (&engine->previous_search, search_thread_data_free);
+    search_thread_data_clear_hits (data);
+    g_clear_object (&data->engine);
+    data->finished_time = g_get_monotonic_time ();
+    engine->previous_search = data;
+
     nautilus_search_provider_finished (NAUTILUS_SEARCH_PROVIDER (engine),
                                        NAUTILUS_SEARCH_PROVIDER_STATUS_NORMAL);
 
     g_object_notify (G_OBJECT (engine), "running");
 
-    search_thread_data_free (data);
-
     return G_SOURCE_REMOVE;
 }
 
@@ -213,7 +314,11 @@ search_thread_process_idle (gpointer user_data)
 
     if (hits)
     {
+        gint64 watchdog_start = nautilus_stall_watchdog_begin ();
+
         search_thread_process_hits_idle (thread_data, hits);
+        nautilus_stall_watchdog_end (watchdog_start, "search_thread_process_idle",
+                                     g_list_length (hits));
         g_list_free_full (hits, g_object_unref);
     }
 
@@ -275,10 +380,133 @@ send_batch_in_idle (SearchThreadData *thread_data)
         G_FILE_ATTRIBUTE_TIME_CREATED "," \
         G_FILE_ATTRIBUTE_ID_FILE
 
+static NautilusSearchHit *
+create_hit (const gchar      *uri,
+            gdouble           match,
+            GDateTime        *mtime,
+            GDateTime        *atime,
+            GDateTime        *ctime,
+            guint             depth,
+            SearchThreadData *data)
+{
+    NautilusSearchHit *hit;
+
+    hit = nautilus_search_hit_new (uri);
+    nautilus_search_hit_set_fts_rank (hit, match);
+    nautilus_search_hit_set_modification_time (hit, mtime);
+    nautilus_search_hit_set_access_time (hit, atime);
+    nautilus_search_hit_set_creation_time (hit, ctime);
+    nautilus_search_hit_set_depth (hit, depth);
+    nautilus_search_hit_compute_scores (hit, data->query, data->now);
+
+    return hit;
+}
+
+static void
+add_hit (SearchThreadData  *data,
+         NautilusSearchHit *hit)
+{
+    data->hits = g_list_prepend (data->hits, hit);
+
+    data->n_processed_files++;
+    if (data->n_processed_files > BATCH_SIZE)
+    {
+        send_batch_in_idle (data);
+    }
+}
+
+static gboolean
+matches_date_range (GPtrArray               *date_range,
+                    NautilusQuerySearchType  type,
+                    GDateTime               *mtime,
+                    GDateTime               *atime,
+                    GDateTime               *ctime)
+{
+    GDateTime *target_date;
+
+    switch (type)
+    {
+        case NAUTILUS_QUERY_SEARCH_TYPE_LAST_ACCESS:
+        {
+            target_date = atime;
+        }
+        break;
+
+        case NAUTILUS_QUERY_SEARCH_TYPE_LAST_MODIFIED:
+        {
+            target_date = mtime;
+        }
+        break;
+
+        case NAUTILUS_QUERY_SEARCH_TYPE_CREATED:
+        {
+            target_date = ctime;
+        }
+        break;
+
+        default:
+        {
+            target_date = NULL;
+        }
+    }
+
+    return nautilus_date_time_is_between_dates (target_date,
+                                                g_ptr_array_index (date_range, 0),
+                                                g_ptr_array_index (date_range, 1));
+}
+
+/* Filters the matches of the previous query with the current one, which is a
+ * refinement of it, and reports those that still match. The MIME types of a
+ * refinement are the same as before, so only the name and dates are checked
+ * again. */
 static void
+refine_found_files (SearchThreadData *data)
+{
+    g_autofree gpointer *found_files = NULL;
+    gsize n_found_files;
+    g_autoptr (GPtrArray) date_range = NULL;
+    NautilusQuerySearchType type;
+
+    found_files = g_ptr_array_steal (data->found_files, &n_found_files);
+    date_range = nautilus_query_get_date_range (data->query);
+    type = nautilus_query_get_search_type (data->query);
+
+    for (gsize i = 0; i < n_found_files; i++)
+    {
+        FoundFile *found = found_files[i];
+        gdouble match;
+
+        match = nautilus_query_matches_string (data->query, found->display_name);
+        if (match <= -1 ||
+            (date_range != NULL &&
+             !matches_date_range (date_range, type, found->mtime, found->atime, found->ctime)))
+        {
+            found_file_free (found);
+            continue;
+        }
+
+        add_hit (data, create_hit (found->uri, match,
+                                   found->mtime, found->atime, found->ctime,
+                                   found->depth, data));
+        g_ptr_array_add (data->found_files, found);
+    }
+
+    data->refining = FALSE;
+}
+
+/* Returns FALSE if the search was cancelled before the whole directory was
+ * visited. Nothing is then recorded, so that it can be visited again later. */
+static gboolean
 visit_directory (GFile            *dir,
+                 guint             depth,
                  SearchThreadData *data)
 {
+    g_autoptr (GPtrArray) dir_found_files = NULL;
+    g_autoptr (GPtrArray) subdirectories = NULL;
+    g_autoptr (GPtrArray) subdirectory_ids = NULL;
+    g_autofree gpointer *stolen_subdirectories = NULL;
+    g_autofree gpointer *stolen_subdirectory_ids = NULL;
+    gsize n_subdirectories;
     g_autoptr (GPtrArray) date_range = NULL;
     NautilusQuerySearchType type;
     NautilusQueryRecursive recursive_flag;
@@ -289,10 +517,6 @@ visit_directory (GFile            *dir,
     gdouble match;
     gboolean is_hidden, found;
     const char *id;
-    gboolean visited;
-    GDateTime *initial_date;
-    GDateTime *end_date;
-    gchar *uri;
 
     enumerator = g_file_enumerate_children (dir,
                                             data->mime_types->len > 0 ?
@@ -307,9 +531,13 @@ visit_directory (GFile            *dir,
 
     if (enumerator == NULL)
     {
-        return;
+        return !g_cancellable_is_cancelled (data->cancellable);
     }
 
+    dir_found_files = g_ptr_array_new_with_free_func ((GDestroyNotify) found_file_free);
+    subdirectories = g_ptr_array_new_with_free_func ((GDestroyNotify) pending_directory_free);
+    subdirectory_ids = g_ptr_array_new_with_free_func (g_free);
+
     type = nautilus_query_get_search_type (data->query);
     recursive_flag = nautilus_query_get_recursive (data->query);
     date_range = nautilus_query_get_date_range (data->query);
@@ -368,55 +596,26 @@ visit_directory (GFile            *dir,
 
         if (found && date_range != NULL)
         {
-            GDateTime *target_date;
-
-            initial_date = g_ptr_array_index (date_range, 0);
-            end_date = g_ptr_array_index (date_range, 1);
-
-            switch (type)
-            {
-                case NAUTILUS_QUERY_SEARCH_TYPE_LAST_ACCESS:
-                {
-                    target_date = atime;
-                }
-                break;
-
-                case NAUTILUS_QUERY_SEARCH_TYPE_LAST_MODIFIED:
-                {
-                    target_date = mtime;
-                }
-                break;
-
-                case NAUTILUS_QUERY_SEARCH_TYPE_CREATED:
-                {
-                    target_date = ctime;
-                }
-                break;
-
-                default:
-                {
-                    target_date = NULL;
-                }
-            }
-
-            found = nautilus_date_time_is_between_dates (target_date,
-                                                         initial_date,
-                                                         end_date);
+            found = matches_date_range (date_range, type, mtime, atime, ctime);
         }
 
         if (found)
         {
-            NautilusSearchHit *hit;
-
-            uri = g_file_get_uri (child);
-            hit = nautilus_search_hit_new (uri);
-            g_free (uri);
-            nautilus_search_hit_set_fts_rank (hit, match);
-            nautilus_search_hit_set_modification_time (hit, mtime);
-            nautilus_search_hit_set_access_time (hit, atime);
-            nautilus_search_hit_set_creation_time (hit, ctime);
-
-            data->hits = g_list_prepend (data->hits, hit);
+            FoundFile *found_file;
+
+            found_file = g_new0 (FoundFile, 1);
+            found_file->uri = g_file_get_uri (child);
+            found_file->display_name = g_strdup (display_name);
+            found_file->mtime = mtime != NULL ? g_date_time_ref (mtime) : NULL;
+            found_file->atime = atime != NULL ? g_date_time_ref (atime) : NULL;
+            found_file->ctime = ctime != NULL ? g_date_time_ref (ctime) : NULL;
+            found_file->depth = depth;
+            g_ptr_array_add (dir_found_files, found_file);
+
+            data->hits = g_list_prepend (data->hits,
+                                         create_hit (found_file->uri, match,
+                                                     mtime, atime, ctime,
+                                                     depth, data));
         }
 
         data->n_processed_files++;
@@ -450,23 +649,10 @@ visit_directory (GFile            *dir,
         if (recursive)
         {
             id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE);
-            visited = FALSE;
-            if (id)
+            if (id == NULL || !g_hash_table_contains (data->visited, id))
             {
-                if (g_hash_table_lookup_extended (data->visited,
-                                                  id, NULL, NULL))
-                {
-                    visited = TRUE;
-                }
-                else
-                {
-                    g_hash_table_insert (data->visited, g_strdup (id), NULL);
-                }
-            }
-
-            if (!visited)
-            {
-                g_queue_push_tail (data->directories, g_object_ref (child));
+                g_ptr_array_add (subdirectories, pending_directory_new (child, depth + 1));
+                g_ptr_array_add (subdirectory_ids, g_strdup (id));
             }
         }
 
@@ -476,6 +662,37 @@ next:
     }
 
     g_object_unref (enumerator);
+
+    if (g_cancellable_is_cancelled (data->cancellable))
+    {
+        return FALSE;
+    }
+
+    g_ptr_array_extend_and_steal (data->found_files, g_steal_pointer (&dir_found_files));
+
+    stolen_subdirectories = g_ptr_array_steal (subdirectories, &n_subdirectories);
+    stolen_subdirectory_ids = g_ptr_array_steal (subdirectory_ids, NULL);
+    for (gsize i = 0; i < n_subdirectories; i++)
+    {
+        PendingDirectory *pending = stolen_subdirectories[i];
+        gchar *subdirectory_id = stolen_subdirectory_ids[i];
+
+        if (subdirectory_id != NULL)
+        {
+            if (g_hash_table_contains (data->visited, subdirectory_id))
+            {
+                pending_directory_free (pending);
+                g_free (subdirectory_id);
+                continue;
+            }
+
+            g_hash_table_add (data->visited, subdirectory_id);
+        }
+
+        g_queue_push_tail (data->directories, pending);
+    }
+
+    return TRUE;
 }
 
 
@@ -483,30 +700,44 @@ static gpointer
 search_thread_func (gpointer user_data)
 {
     SearchThreadData *data;
-    GFile *dir;
+    PendingDirectory *pending;
     GFileInfo *info;
     const char *id;
 
     data = user_data;
 
-    /* Insert id for toplevel directory into visited */
-    dir = g_queue_peek_head (data->directories);
-    info = g_file_query_info (dir, G_FILE_ATTRIBUTE_ID_FILE, 0, data->cancellable, NULL);
-    if (info)
+    if (data->refining)
+    {
+        refine_found_files (data);
+    }
+
+    /* Insert id for toplevel directory into visited, unless this continues
+     * the crawl of a previous search. */
+    pending = g_queue_peek_head (data->directories);
+    if (pending != NULL && pending->depth == 0)
     {
-        id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE);
-        if (id)
+        info = g_file_query_info (pending->location, G_FILE_ATTRIBUTE_ID_FILE, 0, data->cancellable, NULL);
+        if (info)
         {
-            g_hash_table_insert (data->visited, g_strdup (id), NULL);
+            id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE);
+            if (id)
+            {
+                g_hash_table_insert (data->visited, g_strdup (id), NULL);
+            }
+            g_object_unref (info);
         }
-        g_object_unref (info);
     }
 
     while (!g_cancellable_is_cancelled (data->cancellable) &&
-           (dir = g_queue_pop_head (data->directories)) != NULL)
+           (pending = g_queue_pop_head (data->directories)) != NULL)
     {
-        visit_directory (dir, data);
-        g_object_unref (dir);
+        if (!visit_directory (pending->location, pending->depth, data))
+        {
+            /* Visit it again if the crawl is continued for a refined query. */
+            g_queue_push_head (data->directories, pending);
+            break;
+        }
+        pending_directory_free (pending);
     }
 
     if (!g_cancellable_is_cancelled (data->cancellable))
@@ -534,6 +765,7 @@ nautilus_search_engine_simple_start (NautilusSearchProvider *provider)
 {
     NautilusSearchEngineSimple *simple;
     SearchThreadData *data;
+    SearchThreadData *previous_search;
     g_autoptr (GFile) location = NULL;
 
     simple = NAUTILUS_SEARCH_ENGINE_SIMPLE (provider);
@@ -545,7 +777,22 @@ nautilus_search_engine_simple_start (NautilusSearchProvider *provider)
 
     g_debug ("Simple engine start");
 
-    data = search_thread_data_new (simple, simple->query);
+    previous_search = g_steal_pointer (&simple->previous_search);
+    if (previous_search != NULL &&
+        g_get_monotonic_time () - previous_search->finished_time < REFINE_MAX_AGE_US &&
+        nautilus_query_is_refinement_of (simple->query, previous_search->query))
+    {
+        g_debug ("Simple engine refining previous search");
+
+        data = previous_search;
+        search_thread_data_reset (data, simple, simple->query);
+        data->refining = TRUE;
+    }
+    else
+    {
+        g_clear_pointer (&previous_search, search_thread_data_free);
+        data = search_thread_data_new (simple, simple->query);
+    }
 
     simple->active_search = data;
     g_object_notify (G_OBJECT (provider), "running");
@@ -558,7 +805,16 @@ nautilus_search_engine_simple_start (NautilusSearchProvider *provider)
         return;
     }
 
-    g_queue_push_tail (data->directories, g_steal_pointer (&location));
+    if (data->refining)
+    {
+        /* Filtering the known matches is quick, so don't delay it. */
+        simple->create_thread_timeout_id = g_timeout_add_once (0,
+                                                               create_thread_timeout,
+                                                               simple);
+        return;
+    }
+
+    g_queue_push_tail (data->directories, pending_directory_new (location, 0));
 
     simple->create_thread_timeout_id = g_timeout_add_once (CREATE_THREAD_DELAY_MS,
                                                            create_thread_timeout,
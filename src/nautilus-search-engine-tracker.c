@@ -55,6 +55,8 @@ struct _NautilusSearchEngineTracker
 
     gboolean query_pending;
     GQueue *hits_pending;
+    gint64 hits_pending_since;
+    guint hits_timeout_id;
 
     gboolean recursive;
     gboolean fts_enabled;
@@ -90,6 +92,7 @@ finalize (GObject *object)
         g_clear_object (&tracker->cancellable);
     }
 
+    g_clear_handle_id (&tracker->hits_timeout_id, g_source_remove);
     g_clear_object (&tracker->query);
     g_queue_free_full (tracker->hits_pending, g_object_unref);
     g_clear_pointer (&tracker->statements, g_hash_table_unref);
@@ -100,6 +103,38 @@ finalize (GObject *object)
 }
 
 #define BATCH_SIZE 100
+/* Hits are sent once this much time has passed since the oldest pending one
+ * was received from the cursor thread, even if the batch isn't full and the
+ * next rows are slow to come, so first results show up fast. */
+#define HITS_LATENCY_US (50 * 1000)
+
+/* Rows are read from the cursor in a thread, this many at most per round
+ * trip, and for no longer than the time budget. */
+#define CURSOR_BATCH_SIZE 100
+#define CURSOR_BATCH_TIME_BUDGET_US (25 * 1000)
+
+typedef struct
+{
+    TrackerSparqlCursor *cursor;
+    NautilusQuery *query;
+    gboolean fts_enabled;
+    /* Set by the thread once the cursor has no more rows. */
+    gboolean exhausted;
+} CursorBatchData;
+
+static void
+cursor_batch_data_free (CursorBatchData *data)
+{
+    g_object_unref (data->cursor);
+    g_object_unref (data->query);
+    g_free (data);
+}
+
+static void
+hit_list_free (GList *hits)
+{
+    g_list_free_full (hits, g_object_unref);
+}
 
 static void
 check_pending_hits (NautilusSearchEngineTracker *tracker,
@@ -107,16 +142,26 @@ check_pending_hits (NautilusSearchEngineTracker *tracker,
 {
     GList *hits = NULL;
     NautilusSearchHit *hit;
+    guint n_pending;
 
-    g_debug ("Tracker engine add hits");
+    n_pending = g_queue_get_length (tracker->hits_pending);
+    if (n_pending == 0)
+    {
+        return;
+    }
 
     if (!force_send &&
-        g_queue_get_length (tracker->hits_pending) < BATCH_SIZE)
+        n_pending < BATCH_SIZE &&
+        g_get_monotonic_time () - tracker->hits_pending_since < HITS_LATENCY_US)
     {
         return;
     }
 
-    while ((hit = g_queue_pop_head (tracker->hits_pending)))
+    g_debug ("Tracker engine add hits");
+
+    g_clear_handle_id (&tracker->hits_timeout_id, g_source_remove);
+
+    while ((hit = g_queue_pop_tail (tracker->hits_pending)))
     {
         hits = g_list_prepend (hits, hit);
     }
@@ -125,12 +170,25 @@ check_pending_hits (NautilusSearchEngineTracker *tracker,
     g_list_free_full (hits, g_object_unref);
 }
 
+static gboolean
+hits_timeout_cb (gpointer user_data)
+{
+    NautilusSearchEngineTracker *tracker = user_data;
+
+    tracker->hits_timeout_id = 0;
+    check_pending_hits (tracker, TRUE);
+
+    return G_SOURCE_REMOVE;
+}
+
 static void
 search_finished (NautilusSearchEngineTracker *tracker,
                  GError                      *error)
 {
     g_debug ("Tracker engine finished");
 
+    g_clear_handle_id (&tracker->hits_timeout_id, g_source_remove);
+
     if (error == NULL)
     {
         check_pending_hits (tracker, TRUE);
@@ -167,56 +225,20 @@ search_finished (NautilusSearchEngineTracker *tracker,
     g_object_unref (tracker);
 }
 
-static void cursor_callback (GObject      *object,
-                             GAsyncResult *result,
-                             gpointer      user_data);
-
-static void
-cursor_next (NautilusSearchEngineTracker *tracker,
-             TrackerSparqlCursor         *cursor)
-{
-    tracker_sparql_cursor_next_async (cursor,
-                                      tracker->cancellable,
-                                      cursor_callback,
-                                      tracker);
-}
-
-static void
-cursor_callback (GObject      *object,
-                 GAsyncResult *result,
-                 gpointer      user_data)
+static NautilusSearchHit *
+create_hit_from_cursor (CursorBatchData *data,
+                        GTimeZone       *tz)
 {
-    NautilusSearchEngineTracker *tracker;
-    GError *error = NULL;
-    TrackerSparqlCursor *cursor;
+    TrackerSparqlCursor *cursor = data->cursor;
     NautilusSearchHit *hit;
     const char *uri;
     const char *mtime_str;
     const char *atime_str;
     const char *ctime_str;
     const gchar *snippet;
-    g_autoptr (GTimeZone) tz = g_time_zone_new_local ();
     gdouble rank, match;
-    gboolean success;
     gchar *basename;
 
-    tracker = NAUTILUS_SEARCH_ENGINE_TRACKER (user_data);
-
-    cursor = TRACKER_SPARQL_CURSOR (object);
-    success = tracker_sparql_cursor_next_finish (cursor, result, &error);
-
-    if (!success)
-    {
-        search_finished (tracker, error);
-
-        g_clear_error (&error);
-        tracker_sparql_cursor_close (cursor);
-        g_clear_object (&cursor);
-
-        return;
-    }
-
-    /* We iterate result by result, not n at a time. */
     uri = tracker_sparql_cursor_get_string (cursor, 0, NULL);
     rank = tracker_sparql_cursor_get_double (cursor, 1);
     mtime_str = tracker_sparql_cursor_get_string (cursor, 2, NULL);
@@ -225,11 +247,11 @@ cursor_callback (GObject      *object,
     basename = g_path_get_basename (uri);
 
     hit = nautilus_search_hit_new (uri);
-    match = nautilus_query_matches_string (tracker->query, basename);
+    match = nautilus_query_matches_string (data->query, basename);
     nautilus_search_hit_set_fts_rank (hit, rank + match);
     g_free (basename);
 
-    if (tracker->fts_enabled)
+    if (data->fts_enabled)
     {
         snippet = tracker_sparql_cursor_get_string (cursor, 5, NULL);
         if (snippet != NULL)
@@ -279,11 +301,125 @@ cursor_callback (GObject      *object,
         nautilus_search_hit_set_creation_time (hit, date);
     }
 
-    g_queue_push_head (tracker->hits_pending, hit);
+    return hit;
+}
+
+static void
+cursor_batch_thread_func (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+    CursorBatchData *data = task_data;
+    g_autoptr (GTimeZone) tz = g_time_zone_new_local ();
+    GError *error = NULL;
+    GList *hits = NULL;
+    guint n_hits = 0;
+    gint64 deadline;
+
+    deadline = g_get_monotonic_time () + CURSOR_BATCH_TIME_BUDGET_US;
+
+    while (n_hits < CURSOR_BATCH_SIZE)
+    {
+        if (!tracker_sparql_cursor_next (data->cursor, cancellable, &error))
+        {
+            data->exhausted = (error == NULL);
+            break;
+        }
+
+        hits = g_list_prepend (hits, create_hit_from_cursor (data, tz));
+        n_hits++;
+
+        if (g_get_monotonic_time () >= deadline)
+        {
+            break;
+        }
+    }
+
+    if (error != NULL)
+    {
+        hit_list_free (hits);
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_pointer (task, g_list_reverse (hits), (GDestroyNotify) hit_list_free);
+}
+
+static void cursor_batch_callback (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data);
+
+static void
+cursor_next_batch (NautilusSearchEngineTracker *tracker,
+                   TrackerSparqlCursor         *cursor)
+{
+    g_autoptr (GTask) task = NULL;
+    CursorBatchData *data;
+
+    data = g_new0 (CursorBatchData, 1);
+    data->cursor = g_object_ref (cursor);
+    data->query = g_object_ref (tracker->query);
+    data->fts_enabled = tracker->fts_enabled;
+
+    task = g_task_new (tracker, tracker->cancellable, cursor_batch_callback, NULL);
+    g_task_set_source_tag (task, cursor_next_batch);
+    g_task_set_task_data (task, data, (GDestroyNotify) cursor_batch_data_free);
+    g_task_run_in_thread (task, cursor_batch_thread_func);
+}
+
+static void
+cursor_batch_callback (GObject      *object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+    NautilusSearchEngineTracker *tracker;
+    CursorBatchData *data;
+    GError *error = NULL;
+    GList *hits;
+
+    tracker = NAUTILUS_SEARCH_ENGINE_TRACKER (object);
+    data = g_task_get_task_data (G_TASK (result));
+
+    /* This fails right away if the search was stopped in the meantime. */
+    hits = g_task_propagate_pointer (G_TASK (result), &error);
+
+    if (error != NULL)
+    {
+        search_finished (tracker, error);
+
+        g_error_free (error);
+        tracker_sparql_cursor_close (data->cursor);
+
+        return;
+    }
+
+    if (hits != NULL && g_queue_is_empty (tracker->hits_pending))
+    {
+        /* Don't wait for the next batch to send these, the cursor may stall
+         * between rows, e.g. on a slow full text search. */
+        tracker->hits_pending_since = g_get_monotonic_time ();
+        tracker->hits_timeout_id = g_timeout_add (HITS_LATENCY_US / 1000,
+                                                  hits_timeout_cb, tracker);
+    }
+
+    for (GList *l = hits; l != NULL; l = l->next)
+    {
+        g_queue_push_tail (tracker->hits_pending, l->data);
+    }
+    g_list_free (hits);
+
+    if (data->exhausted)
+    {
+        search_finished (tracker, NULL);
+        tracker_sparql_cursor_close (data->cursor);
+
+        return;
+    }
+
     check_pending_hits (tracker, FALSE);
 
-    /* Get next */
-    cursor_next (tracker, cursor);
+    cursor_next_batch (tracker, data->cursor);
 }
 
 static void
@@ -310,7 +446,8 @@ query_callback (GObject      *object,
     }
     else
     {
-        cursor_next (tracker, cursor);
+        cursor_next_batch (tracker, cursor);
+        g_object_unref (cursor);
     }
 }
 
@@ -631,6 +768,7 @@ nautilus_search_engine_tracker_stop (NautilusSearchProvider *provider)
     if (tracker->query_pending)
     {
         g_debug ("Tracker engine stop");
+        g_clear_handle_id (&tracker->hits_timeout_id, g_source_remove);
         g_cancellable_cancel (tracker->cancellable);
         g_clear_object (&tracker->cancellable);
         tracker->query_pending = FALSE;
@@ -29,6 +29,7 @@
 #include "nautilus-search-engine-recent.h"
 #include "nautilus-search-engine-simple.h"
 #include "nautilus-search-engine-tracker.h"
+#include "nautilus-trace.h"
 
 typedef struct
 {
@@ -45,6 +46,8 @@ typedef struct
     gboolean running;
     gboolean restart;
     gboolean recent_enabled;
+
+    gint64 trace_start;
 } NautilusSearchEnginePrivate;
 
 enum
@@ -93,6 +96,7 @@ search_engine_start_real_setup (NautilusSearchEngine *engine)
     priv->providers_error = 0;
 
     priv->restart = FALSE;
+    priv->trace_start = NAUTILUS_TRACE_CURRENT_TIME;
 
     g_debug ("Search engine start real setup");
 
@@ -329,6 +333,8 @@ search_provider_hits_added (NautilusSearchProvider *provider,
     }
     if (added != NULL)
     {
+        nautilus_trace_counter_add (NAUTILUS_TRACE_COUNTER_SEARCH_HITS,
+                                    g_list_length (added));
         added = g_list_reverse (added);
         nautilus_search_provider_hits_added (NAUTILUS_SEARCH_PROVIDER (engine), added);
         g_list_free (added);
@@ -373,6 +379,8 @@ check_providers_status (NautilusSearchEngine *engine)
     priv->running = FALSE;
     g_object_notify (G_OBJECT (engine), "running");
 
+    nautilus_trace_mark_printf (priv->trace_start, "search",
+                                "%u hits", g_hash_table_size (priv->uris));
     g_hash_table_remove_all (priv->uris);
 
     if (priv->restart)
@@ -395,6 +403,9 @@ search_provider_error (NautilusSearchProvider *provider,
     priv = nautilus_search_engine_get_instance_private (engine);
     priv->providers_error++;
 
+    nautilus_trace_mark_printf (priv->trace_start, "search-provider",
+                                "%s failed", G_OBJECT_TYPE_NAME (provider));
+
     check_providers_status (engine);
 }
 
@@ -410,6 +421,9 @@ search_provider_finished (NautilusSearchProvider       *provider,
     priv = nautilus_search_engine_get_instance_private (engine);
     priv->providers_finished++;
 
+    nautilus_trace_mark_printf (priv->trace_start, "search-provider",
+                                "%s", G_OBJECT_TYPE_NAME (provider));
+
     check_providers_status (engine);
 }
 
@@ -37,8 +37,12 @@ struct _NautilusSearchHit
     GDateTime *creation_time;
     gdouble fts_rank;
     gchar *fts_snippet;
+    /* Number of directories between the query location and the hit, or -1
+     * if the provider doesn't know it. */
+    gint depth;
 
     gdouble relevance;
+    gboolean scores_computed;
 };
 
 enum
@@ -55,12 +59,48 @@ enum
 
 G_DEFINE_TYPE (NautilusSearchHit, nautilus_search_hit, G_TYPE_OBJECT)
 
+/* Returns FALSE if the hit is not inside @query_location. */
+static gboolean
+get_dir_count (NautilusSearchHit *hit,
+               GFile             *query_location,
+               guint             *dir_count)
+{
+    g_autoptr (GFile) hit_location = NULL;
+    GFile *parent, *location;
+
+    if (hit->depth >= 0)
+    {
+        *dir_count = hit->depth;
+        return TRUE;
+    }
+
+    hit_location = g_file_new_for_uri (hit->uri);
+    if (!g_file_has_prefix (hit_location, query_location))
+    {
+        return FALSE;
+    }
+
+    *dir_count = 0;
+    parent = g_file_get_parent (hit_location);
+
+    while (!g_file_equal (parent, query_location))
+    {
+        *dir_count += 1;
+        location = parent;
+        parent = g_file_get_parent (location);
+        g_object_unref (location);
+    }
+    g_object_unref (parent);
+
+    return TRUE;
+}
+
 void
 nautilus_search_hit_compute_scores (NautilusSearchHit *hit,
-                                    NautilusQuery     *query)
+                                    NautilusQuery     *query,
+                                    GDateTime         *now)
 {
     g_autoptr (GFile) query_location = NULL;
-    GFile *hit_location;
     guint dir_count = 0;
     GTimeSpan m_diff = G_MAXINT64;
     GTimeSpan a_diff = G_MAXINT64;
@@ -69,38 +109,26 @@ nautilus_search_hit_compute_scores (NautilusSearchHit *hit,
     gdouble proximity_bonus = 0.0;
     gdouble match_bonus = 0.0;
 
+    if (hit->scores_computed)
+    {
+        /* Already done by the provider. */
+        return;
+    }
+
     query_location = nautilus_query_get_location (query);
-    hit_location = g_file_new_for_uri (hit->uri);
 
     if (query_location != NULL &&
-        g_file_has_prefix (hit_location, query_location))
+        get_dir_count (hit, query_location, &dir_count) &&
+        dir_count < 10)
     {
-        GFile *parent, *location;
-
-        parent = g_file_get_parent (hit_location);
-
-        while (!g_file_equal (parent, query_location))
-        {
-            dir_count++;
-            location = parent;
-            parent = g_file_get_parent (location);
-            g_object_unref (location);
-        }
-        g_object_unref (parent);
-
-        if (dir_count < 10)
-        {
-            proximity_bonus = 10000.0 - 1000.0 * dir_count;
-        }
+        proximity_bonus = 10000.0 - 1000.0 * dir_count;
     }
-    g_object_unref (hit_location);
 
     /* Recency bonus is useful for recursive search, but unwanted for results
      * from the current folder, which should always sort by filename match,
      * which makes prefix matches sort first. */
     if (dir_count != 0)
     {
-        g_autoptr (GDateTime) now = g_date_time_new_now_local ();
         if (hit->modification_time != NULL)
         {
             m_diff = g_date_time_difference (now, hit->modification_time);
@@ -148,6 +176,7 @@ nautilus_search_hit_compute_scores (NautilusSearchHit *hit,
     }
 
     hit->relevance = recent_bonus + proximity_bonus + match_bonus;
+    hit->scores_computed = TRUE;
     g_debug ("Hit %s computed relevance %.2f (%.2f + %.2f + %.2f)", hit->uri, hit->relevance,
              proximity_bonus, recent_bonus, match_bonus);
 }
@@ -239,6 +268,13 @@ nautilus_search_hit_set_creation_time (NautilusSearchHit *hit,
     }
 }
 
+void
+nautilus_search_hit_set_depth (NautilusSearchHit *hit,
+                               guint              depth)
+{
+    hit->depth = depth;
+}
+
 void
 nautilus_search_hit_set_fts_snippet (NautilusSearchHit *hit,
                                      const gchar       *snippet)
@@ -466,6 +502,7 @@ nautilus_search_hit_class_init (NautilusSearchHitClass *class)
 static void
 nautilus_search_hit_init (NautilusSearchHit *hit)
 {
+    hit->depth = -1;
 }
 
 NautilusSearchHit *
@@ -40,8 +40,11 @@ void                nautilus_search_hit_set_creation_time     (NautilusSearchHit
 							       GDateTime         *date);
 void                nautilus_search_hit_set_fts_snippet       (NautilusSearchHit *hit,
                                                                const gchar       *snippet);
+void                nautilus_search_hit_set_depth             (NautilusSearchHit *hit,
+                                                               guint              depth);
 void                nautilus_search_hit_compute_scores        (NautilusSearchHit *hit,
-							       NautilusQuery     *query);
+							       NautilusQuery     *query,
+							       GDateTime         *now);
 
 const char *        nautilus_search_hit_get_uri               (NautilusSearchHit *hit);
 gdouble             nautilus_search_hit_get_relevance         (NautilusSearchHit *hit);
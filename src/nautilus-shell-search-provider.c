@@ -183,6 +183,7 @@ search_hits_added_cb (NautilusSearchEngine *engine,
                       gpointer              user_data)
 {
     PendingSearch *search = user_data;
+    g_autoptr (GDateTime) now = g_date_time_new_now_local ();
     GList *l;
     NautilusSearchHit *hit;
     const gchar *hit_uri;
@@ -192,7 +193,7 @@ search_hits_added_cb (NautilusSearchEngine *engine,
     for (l = hits; l != NULL; l = l->next)
     {
         hit = l->data;
-        nautilus_search_hit_compute_scores (hit, search->query);
+        nautilus_search_hit_compute_scores (hit, search->query, now);
         hit_uri = nautilus_search_hit_get_uri (hit);
         g_debug ("    %s", hit_uri);
 
@@ -299,6 +300,7 @@ search_hit_candidate_new (const gchar *uri,
 static void
 search_add_volumes_and_bookmarks (PendingSearch *search)
 {
+    g_autoptr (GDateTime) now = g_date_time_new_now_local ();
     NautilusSearchHit *hit;
     NautilusBookmark *bookmark;
     const gchar *name;
@@ -444,7 +446,7 @@ search_add_volumes_and_bookmarks (PendingSearch *search)
         {
             hit = nautilus_search_hit_new (candidate->uri);
             nautilus_search_hit_set_fts_rank (hit, match);
-            nautilus_search_hit_compute_scores (hit, search->query);
+            nautilus_search_hit_compute_scores (hit, search->query, now);
             g_hash_table_replace (search->hits, g_strdup (candidate->uri), hit);
         }
     }
@@ -0,0 +1,129 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#define G_LOG_DOMAIN "nautilus-stall-watchdog"
+
+#include <config.h>
+
+#include "nautilus-stall-watchdog.h"
+
+/* One frame at 60 Hz. */
+#define DEFAULT_BUDGET_US 16000
+
+typedef struct
+{
+    guint n_dispatches;
+    guint n_stalls;
+    gint64 total_stall_time;
+    gint64 longest_stall;
+    guint longest_stall_items;
+} SourceStats;
+
+/* 0 while unknown, -1 when disabled. */
+static gint64 budget_us = 0;
+
+/* Source name -> SourceStats *. Only used from the main thread. */
+static GHashTable *source_stats = NULL;
+
+static gboolean
+is_enabled (void)
+{
+    if (G_UNLIKELY (budget_us == 0))
+    {
+        const gchar *env = g_getenv ("NAUTILUS_STALL_WATCHDOG");
+
+        if (env == NULL)
+        {
+            budget_us = -1;
+        }
+        else
+        {
+            guint64 budget_ms = g_ascii_strtoull (env, NULL, 10);
+
+            budget_us = budget_ms > 0 ? (gint64) budget_ms * 1000 : DEFAULT_BUDGET_US;
+            source_stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  NULL, g_free);
+        }
+    }
+
+    return budget_us > 0;
+}
+
+/**
+ * nautilus_stall_watchdog_begin:
+ *
+ * Returns: the time to pass to nautilus_stall_watchdog_end() at the end of
+ *   the dispatch, or 0 if the watchdog is disabled.
+ */
+gint64
+nautilus_stall_watchdog_begin (void)
+{
+    return is_enabled () ? g_get_monotonic_time () : 0;
+}
+
+void
+nautilus_stall_watchdog_end_real (gint64       start_time,
+                                  const gchar *source_name,
+                                  guint        n_items)
+{
+    gint64 duration = g_get_monotonic_time () - start_time;
+    SourceStats *stats;
+
+    g_return_if_fail (g_main_context_is_owner (g_main_context_default ()));
+
+    /* Source names are string literals, so they can be the keys. */
+    stats = g_hash_table_lookup (source_stats, source_name);
+    if (stats == NULL)
+    {
+        stats = g_new0 (SourceStats, 1);
+        g_hash_table_insert (source_stats, (gpointer) source_name, stats);
+    }
+
+    stats->n_dispatches++;
+
+    if (duration <= budget_us)
+    {
+        return;
+    }
+
+    stats->n_stalls++;
+    stats->total_stall_time += duration;
+    if (duration > stats->longest_stall)
+    {
+        stats->longest_stall = duration;
+        stats->longest_stall_items = n_items;
+    }
+
+    g_message ("%s blocked the main loop for %.1f ms, with %u items",
+               source_name, duration / 1000.0, n_items);
+}
+
+void
+nautilus_stall_watchdog_print_summary (void)
+{
+    GHashTableIter iter;
+    const gchar *source_name;
+    SourceStats *stats;
+
+    if (!is_enabled ())
+    {
+        return;
+    }
+
+    g_message ("Main loop stalls longer than %.1f ms:", budget_us / 1000.0);
+
+    g_hash_table_iter_init (&iter, source_stats);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &source_name, (gpointer *) &stats))
+    {
+        if (stats->n_stalls == 0)
+        {
+            continue;
+        }
+
+        g_message ("  %s: %u of %u dispatches, %.1f ms in total, "
+                   "longest %.1f ms with %u items",
+                   source_name, stats->n_stalls, stats->n_dispatches,
+                   stats->total_stall_time / 1000.0,
+                   stats->longest_stall / 1000.0, stats->longest_stall_items);
+    }
+}
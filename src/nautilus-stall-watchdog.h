@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Measures how long Nautilus' own main loop sources take to dispatch, and
+ * reports those which take longer than a frame, along with how many items
+ * they processed. It is off unless NAUTILUS_STALL_WATCHDOG is set, to the
+ * budget in milliseconds (or to anything else for the default of 16 ms).
+ *
+ *     gint64 watchdog_start = nautilus_stall_watchdog_begin ();
+ *     ...
+ *     nautilus_stall_watchdog_end (watchdog_start, "display_pending_callback",
+ *                                  g_list_length (files));
+ *
+ * The item count is only evaluated when the watchdog is enabled.
+ */
+
+gint64 nautilus_stall_watchdog_begin (void);
+
+#define nautilus_stall_watchdog_end(start_time, source_name, n_items) \
+        G_STMT_START { \
+            if ((start_time) != 0) \
+            { \
+                nautilus_stall_watchdog_end_real ((start_time), (source_name), (n_items)); \
+            } \
+        } G_STMT_END
+
+void nautilus_stall_watchdog_end_real (gint64       start_time,
+                                       const gchar *source_name,
+                                       guint        n_items);
+
+void nautilus_stall_watchdog_print_summary (void);
+
+G_END_DECLS
@@ -26,14 +26,12 @@ toggle_star (NautilusStarCell *self)
     NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
     g_autoptr (NautilusViewItem) item = NULL;
     NautilusFile *file;
-    g_autofree gchar *uri = NULL;
 
     item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
     g_return_if_fail (item != NULL);
     file = nautilus_view_item_get_file (item);
-    uri = nautilus_file_get_uri (file);
 
-    if (nautilus_tag_manager_file_is_starred (tag_manager, uri))
+    if (nautilus_file_is_starred (file))
     {
         nautilus_tag_manager_unstar_files (tag_manager,
                                            G_OBJECT (item),
@@ -60,9 +58,7 @@ update_star (GtkButton    *star,
 {
     g_return_if_fail (NAUTILUS_IS_FILE (file));
 
-    g_autofree gchar *file_uri = nautilus_file_get_uri (file);
-    gboolean is_starred = nautilus_tag_manager_file_is_starred (nautilus_tag_manager_get (),
-                                                                file_uri);
+    gboolean is_starred = nautilus_file_is_starred (file);
     const gchar *tooltip = is_starred ? _("Unstar") : _("Star");
 
     /* Setting the tooltip is somewhat expensive as it involves system calls, so only
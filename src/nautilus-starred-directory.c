@@ -97,7 +97,6 @@ static void
 nautilus_starred_directory_update_files (NautilusFavoriteDirectory *self,
                                          GList                     *changed_files)
 {
-    NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
     GList *monitor_list;
     FavoriteMonitor *monitor;
     g_autoptr (GHashTable) uri_table = NULL;
@@ -118,11 +117,11 @@ nautilus_starred_directory_update_files (NautilusFavoriteDirectory *self,
     for (GList *l = changed_files; l != NULL; l = next)
     {
         NautilusFile *file = l->data;
-        g_autofree char *uri = nautilus_file_get_uri (file);
+        const char *uri = nautilus_file_peek_uri (file);
 
         next = l->next;
         if (g_hash_table_contains (uri_table, uri) &&
-            !nautilus_tag_manager_file_is_starred (tag_manager, uri))
+            !nautilus_file_is_starred (file))
         {
             disconnect_and_unmonitor_file (file, self);
             nautilus_file_unref (file);
@@ -130,7 +129,7 @@ nautilus_starred_directory_update_files (NautilusFavoriteDirectory *self,
             self->files = g_list_remove (self->files, file);
         }
         else if (!g_hash_table_contains (uri_table, uri) &&
-                 nautilus_tag_manager_file_is_starred (tag_manager, uri))
+                 nautilus_file_is_starred (file))
         {
             for (monitor_list = self->monitor_list; monitor_list; monitor_list = monitor_list->next)
             {
@@ -180,11 +179,7 @@ static gboolean
 real_contains_file (NautilusDirectory *directory,
                     NautilusFile      *file)
 {
-    g_autofree gchar *uri = NULL;
-
-    uri = nautilus_file_get_uri (file);
-
-    return nautilus_tag_manager_file_is_starred (nautilus_tag_manager_get (), uri);
+    return nautilus_file_is_starred (file);
 }
 
 static gboolean
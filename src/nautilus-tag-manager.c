@@ -20,6 +20,7 @@
 
 #include "nautilus-tag-manager.h"
 #include "nautilus-file.h"
+#include "nautilus-file-private.h"
 #include "nautilus-file-undo-operations.h"
 #include "nautilus-file-undo-manager.h"
 #include "nautilus-tracker-utilities.h"
@@ -44,6 +45,7 @@ struct _NautilusTagManager
     GFile *home;
 
     GList *pending_changed_files;
+    gboolean migrate_when_ready;
 
     GCancellable *cancellable;
 };
@@ -85,6 +87,8 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
+static void export_tracker2_data (NautilusTagManager *self);
+
 /* Limit to 10MB output from Tracker -- surely, nobody has over a million starred files. */
 #define TRACKER2_MAX_IMPORT_BYTES 10 * 1024 * 1024
 
@@ -248,6 +252,7 @@ on_get_starred_files_cursor_callback (GObject      *object,
 
     if (file)
     {
+        nautilus_file_set_is_starred (file, TRUE);
         self->pending_changed_files = g_list_prepend (self->pending_changed_files, file);
     }
     else
@@ -322,15 +327,12 @@ nautilus_tag_manager_delete_tag (NautilusTagManager *self,
 
     for (l = selection; l != NULL; l = l->next)
     {
-        g_autofree gchar *uri = NULL;
-
         file = l->data;
 
-        uri = nautilus_file_get_uri (file);
         g_string_append_printf (query,
                                 "    <%s> a nautilus:File ; "
                                 "        nautilus:starred true . ",
-                                uri);
+                                nautilus_file_peek_uri (file));
     }
 
     g_string_append (query, "}");
@@ -350,15 +352,12 @@ nautilus_tag_manager_insert_tag (NautilusTagManager *self,
 
     for (l = selection; l != NULL; l = l->next)
     {
-        g_autofree gchar *uri = NULL;
-
         file = l->data;
 
-        uri = nautilus_file_get_uri (file);
         g_string_append_printf (query,
                                 "    <%s> a nautilus:File ; "
                                 "        nautilus:starred true . ",
-                                uri);
+                                nautilus_file_peek_uri (file));
     }
 
     g_string_append (query, "}");
@@ -509,6 +508,8 @@ on_tracker_notifier_events (TrackerNotifier *notifier,
 
         if (changed_file)
         {
+            nautilus_file_set_is_starred (changed_file, starred);
+
             changed_files = g_list_prepend (NULL, changed_file);
 
             g_signal_emit_by_name (self, "starred-changed", changed_files);
@@ -617,37 +618,10 @@ nautilus_tag_manager_get (void)
 }
 
 static gboolean
-setup_database (NautilusTagManager  *self,
-                GCancellable        *cancellable,
-                GError             **error)
+prepare_queries (NautilusTagManager  *self,
+                 GCancellable        *cancellable,
+                 GError             **error)
 {
-    const gchar *datadir;
-    g_autofree gchar *store_path = NULL;
-    g_autofree gchar *ontology_path = NULL;
-    g_autoptr (GFile) store = NULL;
-    g_autoptr (GFile) ontology = NULL;
-
-    /* Open private database to store nautilus:starred property. */
-
-    datadir = NAUTILUS_DATADIR;
-
-    store_path = g_build_filename (g_get_user_data_dir (), "nautilus", "tags", NULL);
-    ontology_path = g_build_filename (datadir, "ontology", NULL);
-
-    store = g_file_new_for_path (store_path);
-    ontology = g_file_new_for_path (ontology_path);
-
-    self->db = tracker_sparql_connection_new (TRACKER_SPARQL_CONNECTION_FLAGS_NONE,
-                                              store,
-                                              ontology,
-                                              cancellable,
-                                              error);
-
-    if (*error)
-    {
-        return FALSE;
-    }
-
     /* Prepare reusable queries. */
     self->query_file_is_starred = tracker_sparql_connection_query_statement (self->db,
                                                                              QUERY_FILE_IS_STARRED,
@@ -673,26 +647,28 @@ setup_database (NautilusTagManager  *self,
 }
 
 static void
-nautilus_tag_manager_init (NautilusTagManager *self)
+on_database_ready (GObject      *source_object,
+                   GAsyncResult *result,
+                   gpointer      user_data)
 {
+    NautilusTagManager *self;
+    TrackerSparqlConnection *db;
     g_autoptr (GError) error = NULL;
 
-    self->starred_file_uris = g_hash_table_new_full (g_str_hash,
-                                                     g_str_equal,
-                                                     (GDestroyNotify) g_free,
-                                                     /* values are keys */
-                                                     NULL);
-    self->home = g_file_new_for_path (g_get_home_dir ());
-
-    if (make_dummy_instance)
+    db = tracker_sparql_connection_new_finish (result, &error);
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-        /* Skip database initiation for nautilus_tag_manager_new_dummy(). */
         return;
     }
 
-    self->cancellable = g_cancellable_new ();
-    self->database_ok = setup_database (self, self->cancellable, &error);
-    if (error)
+    self = NAUTILUS_TAG_MANAGER (user_data);
+    self->db = db;
+
+    if (error == NULL)
+    {
+        self->database_ok = prepare_queries (self, self->cancellable, &error);
+    }
+    if (error != NULL)
     {
         g_warning ("Unable to initialize tag manager: %s", error->message);
         return;
@@ -700,12 +676,68 @@ nautilus_tag_manager_init (NautilusTagManager *self)
 
     self->notifier = tracker_sparql_connection_create_notifier (self->db);
 
+    /* Starred files light up as they come, see
+     * on_get_starred_files_cursor_callback(). */
     nautilus_tag_manager_query_starred_files (self, self->cancellable);
 
     g_signal_connect (self->notifier,
                       "events",
                       G_CALLBACK (on_tracker_notifier_events),
                       self);
+
+    if (self->migrate_when_ready)
+    {
+        export_tracker2_data (self);
+    }
+}
+
+static void
+setup_database (NautilusTagManager *self)
+{
+    const gchar *datadir;
+    g_autofree gchar *store_path = NULL;
+    g_autofree gchar *ontology_path = NULL;
+    g_autoptr (GFile) store = NULL;
+    g_autoptr (GFile) ontology = NULL;
+
+    /* Open private database to store nautilus:starred property. */
+
+    datadir = NAUTILUS_DATADIR;
+
+    store_path = g_build_filename (g_get_user_data_dir (), "nautilus", "tags", NULL);
+    ontology_path = g_build_filename (datadir, "ontology", NULL);
+
+    store = g_file_new_for_path (store_path);
+    ontology = g_file_new_for_path (ontology_path);
+
+    /* Opening the database can take a while, e.g. when its journal has to
+     * be replayed, so it's done in a thread not to delay startup. */
+    tracker_sparql_connection_new_async (TRACKER_SPARQL_CONNECTION_FLAGS_NONE,
+                                         store,
+                                         ontology,
+                                         self->cancellable,
+                                         on_database_ready,
+                                         self);
+}
+
+static void
+nautilus_tag_manager_init (NautilusTagManager *self)
+{
+    self->starred_file_uris = g_hash_table_new_full (g_str_hash,
+                                                     g_str_equal,
+                                                     (GDestroyNotify) g_free,
+                                                     /* values are keys */
+                                                     NULL);
+    self->home = g_file_new_for_path (g_get_home_dir ());
+
+    if (make_dummy_instance)
+    {
+        /* Skip database initiation for nautilus_tag_manager_new_dummy(). */
+        return;
+    }
+
+    self->cancellable = g_cancellable_new ();
+    setup_database (self);
 }
 
 gboolean
@@ -992,6 +1024,12 @@ nautilus_tag_manager_maybe_migrate_tracker2_data (NautilusTagManager *self)
     {
         g_debug ("Tracker 2 migration: already completed.");
     }
+    else if (!self->database_ok)
+    {
+        /* The starred files can only be imported into an open database */
+        g_debug ("Tracker 2 migration: waiting for the database.");
+        self->migrate_when_ready = TRUE;
+    }
     else
     {
         g_debug ("Tracker 2 migration: starting.");
@@ -29,6 +29,7 @@
 #include "nautilus-directory-notify.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-trace.h"
 #include <math.h>
 #include <gtk/gtk.h>
 #include <errno.h>
@@ -64,6 +65,7 @@ typedef struct
     time_t updated_file_mtime;
 
     GCancellable *cancellable;
+    gint64 trace_start;
 } NautilusThumbnailInfo;
 
 /*
@@ -293,22 +295,16 @@ gboolean
 nautilus_can_thumbnail (NautilusFile *file)
 {
     GnomeDesktopThumbnailFactory *factory;
-    gboolean res;
-    char *uri;
     time_t mtime;
     const char *mime_type = nautilus_file_get_mime_type (file);
 
-    uri = nautilus_file_get_uri (file);
     mtime = nautilus_file_get_mtime (file);
 
     factory = get_thumbnail_factory ();
-    res = gnome_desktop_thumbnail_factory_can_thumbnail (factory,
-                                                         uri,
-                                                         mime_type,
-                                                         mtime);
-    g_free (uri);
-
-    return res;
+    return gnome_desktop_thumbnail_factory_can_thumbnail (factory,
+                                                          nautilus_file_peek_uri (file),
+                                                          mime_type,
+                                                          mtime);
 }
 
 void
@@ -398,6 +394,9 @@ thumbnail_finalize (NautilusThumbnailInfo *info)
     g_hash_table_remove (currently_thumbnailing_hash, info->image_uri);
     running_threads -= 1;
 
+    nautilus_trace_mark_printf (info->trace_start, "thumbnail-create",
+                                "%s", info->image_uri);
+
     /*  If the original file mtime of the request changed, then
      *  we need to redo the thumbnail. */
     if (info->original_file_mtime == info->updated_file_mtime ||
@@ -594,6 +593,7 @@ thumbnail_starter_cb (gpointer data)
 
         running_threads += 1;
         g_hash_table_insert (currently_thumbnailing_hash, info->image_uri, info);
+        info->trace_start = NAUTILUS_TRACE_CURRENT_TIME;
 
         gnome_desktop_thumbnail_factory_generate_thumbnail_async (thumbnail_factory,
                                                                   info->image_uri,
@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+
+#include "nautilus-trace.h"
+
+static const struct
+{
+    const char *name;
+    const char *description;
+} counter_info[NAUTILUS_TRACE_N_COUNTERS] =
+{
+    [NAUTILUS_TRACE_COUNTER_FILES_LOADED] = { "Files loaded", "Files added to directories after loading their info" },
+    [NAUTILUS_TRACE_COUNTER_SEARCH_HITS] = { "Search hits", "Hits reported by search providers" },
+    [NAUTILUS_TRACE_COUNTER_BYTES_COPIED] = { "Bytes copied", "Bytes written by copy and move jobs" },
+};
+
+static guint counter_ids[NAUTILUS_TRACE_N_COUNTERS];
+static gint64 counter_values[NAUTILUS_TRACE_N_COUNTERS];
+G_LOCK_DEFINE_STATIC (counters);
+
+static void
+define_counters (void)
+{
+    SysprofCaptureCounter counters[NAUTILUS_TRACE_N_COUNTERS] = { 0 };
+    guint first_id;
+
+    first_id = sysprof_collector_request_counters (NAUTILUS_TRACE_N_COUNTERS);
+
+    for (guint i = 0; i < NAUTILUS_TRACE_N_COUNTERS; i++)
+    {
+        counter_ids[i] = first_id + i;
+        counters[i].id = counter_ids[i];
+        counters[i].type = SYSPROF_CAPTURE_COUNTER_INT64;
+        counters[i].value.v64 = 0;
+        g_strlcpy (counters[i].category, "Nautilus", sizeof (counters[i].category));
+        g_strlcpy (counters[i].name, counter_info[i].name, sizeof (counters[i].name));
+        g_strlcpy (counters[i].description, counter_info[i].description,
+                   sizeof (counters[i].description));
+    }
+
+    sysprof_collector_define_counters (counters, NAUTILUS_TRACE_N_COUNTERS);
+}
+
+/* Counters are running totals, as sysprof plots the value they are set to. */
+void
+nautilus_trace_counter_add_real (NautilusTraceCounter counter,
+                                 gint64               delta)
+{
+    static gsize counters_defined = 0;
+    SysprofCaptureCounterValue value;
+
+    if (g_once_init_enter (&counters_defined))
+    {
+        define_counters ();
+        g_once_init_leave (&counters_defined, 1);
+    }
+
+    G_LOCK (counters);
+    counter_values[counter] += delta;
+    value.v64 = counter_values[counter];
+    G_UNLOCK (counters);
+
+    sysprof_collector_set_counters (&counter_ids[counter], &value, 1);
+}
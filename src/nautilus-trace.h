@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* Marks and counters for sysprof, built with -Dsysprof=true. They show up in
+ * the "Nautilus" group of a capture, next to the GTK frame timings, which is
+ * how main loop stalls can be attributed to what Nautilus was doing.
+ *
+ * When built without sysprof, everything here compiles to nothing, so call
+ * sites don't need any #ifdef. Only the start time needs to be kept around:
+ *
+ *     gint64 trace_start G_GNUC_UNUSED = NAUTILUS_TRACE_CURRENT_TIME;
+ *     ...
+ *     nautilus_trace_mark_printf (trace_start, "process-pending-files",
+ *                                 "%u files", g_list_length (files));
+ *
+ * The message and counter arguments are only evaluated while sysprof is
+ * recording.
+ */
+
+typedef enum
+{
+    NAUTILUS_TRACE_COUNTER_FILES_LOADED,
+    NAUTILUS_TRACE_COUNTER_SEARCH_HITS,
+    NAUTILUS_TRACE_COUNTER_BYTES_COPIED,
+    NAUTILUS_TRACE_N_COUNTERS
+} NautilusTraceCounter;
+
+#ifdef HAVE_SYSPROF
+
+#define NAUTILUS_TRACE_CURRENT_TIME SYSPROF_CAPTURE_CURRENT_TIME
+
+#define nautilus_trace_mark(start_time, name) \
+        sysprof_collector_mark ((start_time), \
+                                SYSPROF_CAPTURE_CURRENT_TIME - (start_time), \
+                                "Nautilus", (name), NULL)
+
+#define nautilus_trace_mark_printf(start_time, name, ...) \
+        G_STMT_START { \
+            if (sysprof_collector_is_active ()) \
+            { \
+                sysprof_collector_mark_printf ((start_time), \
+                                               SYSPROF_CAPTURE_CURRENT_TIME - (start_time), \
+                                               "Nautilus", (name), __VA_ARGS__); \
+            } \
+        } G_STMT_END
+
+#define nautilus_trace_counter_add(counter, delta) \
+        G_STMT_START { \
+            if (sysprof_collector_is_active ()) \
+            { \
+                nautilus_trace_counter_add_real ((counter), (delta)); \
+            } \
+        } G_STMT_END
+
+void nautilus_trace_counter_add_real (NautilusTraceCounter counter,
+                                      gint64               delta);
+
+#else
+
+#define NAUTILUS_TRACE_CURRENT_TIME 0
+
+#define nautilus_trace_mark(start_time, name) G_STMT_START { } G_STMT_END
+#define nautilus_trace_mark_printf(start_time, name, ...) G_STMT_START { } G_STMT_END
+#define nautilus_trace_counter_add(counter, delta) G_STMT_START { } G_STMT_END
+
+#endif
+
+G_END_DECLS
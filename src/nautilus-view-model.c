@@ -15,7 +15,9 @@ struct _NautilusViewModel
     GtkMultiSelection *selection_model;
 
     gboolean expand_as_a_tree;
-    GList *cut_files;
+    /* Includes cut files not in the model yet, which are marked as they
+     * are added. */
+    GHashTable *cut_files;
 };
 
 static inline GListStore *
@@ -208,7 +210,7 @@ finalize (GObject *object)
     g_hash_table_destroy (self->map_files_to_model);
     g_hash_table_destroy (self->directory_reverse_map);
 
-    g_clear_list (&self->cut_files, g_object_unref);
+    g_hash_table_destroy (self->cut_files);
 }
 
 static void
@@ -328,6 +330,7 @@ nautilus_view_model_class_init (NautilusViewModelClass *klass)
 static void
 nautilus_view_model_init (NautilusViewModel *self)
 {
+    self->cut_files = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 }
 
 static gint
@@ -488,6 +491,11 @@ nautilus_view_model_add_item (NautilusViewModel *self,
     file = nautilus_view_item_get_file (item);
     parent = nautilus_file_get_parent (file);
 
+    if (g_hash_table_contains (self->cut_files, file))
+    {
+        nautilus_view_item_set_cut (item, TRUE);
+    }
+
     g_list_store_append (get_directory_store (self, parent), item);
     g_hash_table_insert (self->map_files_to_model, file, item);
 }
@@ -536,6 +544,11 @@ nautilus_view_model_add_items (NautilusViewModel *self,
         }
         g_set_object (&previous_parent, parent);
 
+        if (g_hash_table_contains (self->cut_files, nautilus_view_item_get_file (item)))
+        {
+            nautilus_view_item_set_cut (item, TRUE);
+        }
+
         g_ptr_array_add (array, item);
         g_hash_table_insert (self->map_files_to_model,
                              nautilus_view_item_get_file (item),
@@ -605,26 +618,48 @@ void
 nautilus_view_model_set_cut_files (NautilusViewModel *self,
                                    GList             *cut_files)
 {
+    GHashTable *old_cut_files = self->cut_files;
     NautilusViewItem *item;
+    GHashTableIter iter;
+    NautilusFile *file;
 
-    for (GList *l = self->cut_files; l != NULL; l = l->next)
+    if (cut_files == NULL && g_hash_table_size (old_cut_files) == 0)
     {
-        item = nautilus_view_model_get_item_for_file (self, l->data);
-        if (item != NULL)
+        return;
+    }
+
+    self->cut_files = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+    for (GList *l = cut_files; l != NULL; l = l->next)
+    {
+        g_hash_table_add (self->cut_files, g_object_ref (l->data));
+    }
+
+    /* Only the items whose state changes are notified. */
+    g_hash_table_iter_init (&iter, old_cut_files);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &file, NULL))
+    {
+        if (!g_hash_table_contains (self->cut_files, file))
         {
-            nautilus_view_item_set_cut (item, FALSE);
+            item = nautilus_view_model_get_item_for_file (self, file);
+            if (item != NULL)
+            {
+                nautilus_view_item_set_cut (item, FALSE);
+            }
         }
     }
-    g_clear_list (&self->cut_files, g_object_unref);
 
-    for (GList *l = cut_files; l != NULL; l = l->next)
+    g_hash_table_iter_init (&iter, self->cut_files);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &file, NULL))
     {
-        item = nautilus_view_model_get_item_for_file (self, l->data);
-        if (item != NULL)
+        if (!g_hash_table_contains (old_cut_files, file))
         {
-            self->cut_files = g_list_prepend (self->cut_files,
-                                              g_object_ref (l->data));
-            nautilus_view_item_set_cut (item, TRUE);
+            item = nautilus_view_model_get_item_for_file (self, file);
+            if (item != NULL)
+            {
+                nautilus_view_item_set_cut (item, TRUE);
+            }
         }
     }
+
+    g_hash_table_destroy (old_cut_files);
 }
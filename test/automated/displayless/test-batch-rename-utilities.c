@@ -0,0 +1,118 @@
+#include <glib.h>
+
+#include <nautilus-batch-rename-dialog.h>
+#include <nautilus-batch-rename-utilities.h>
+#include <nautilus-directory.h>
+#include <nautilus-file.h>
+#include <nautilus-file-utilities.h>
+
+#define N_FILES 30000
+#define TEST_DIRECTORY_URI "file:///tmp/nautilus-test-batch-rename"
+
+static void
+test_batch_rename_conflicts_many_files (void)
+{
+    g_autoptr (NautilusDirectory) directory = nautilus_directory_get_by_uri (TEST_DIRECTORY_URI);
+    GList *selection = NULL;
+    GList *directory_files = NULL;
+    GList *new_names = NULL;
+    GList *conflicts;
+    ConflictData *conflict_data;
+    NautilusFile *existing_file;
+
+    for (guint i = 0; i < N_FILES; i++)
+    {
+        g_autofree char *uri = g_strdup_printf (TEST_DIRECTORY_URI "/file-%05u", i);
+        NautilusFile *file = nautilus_file_get_by_uri (uri);
+        GString *new_name;
+
+        switch (i)
+        {
+            case 100:
+            {
+                /* Clashes with a file which is not renamed. */
+                new_name = g_string_new ("existing");
+            }
+            break;
+
+            case 200:
+            case 201:
+            {
+                /* Clash with each other. */
+                new_name = g_string_new ("same");
+            }
+            break;
+
+            case 300:
+            {
+                /* The file with this name is renamed too, so no conflict. */
+                new_name = g_string_new ("file-00301");
+            }
+            break;
+
+            case 400:
+            {
+                /* Unchanged name, no conflict. */
+                new_name = g_string_new ("file-00400");
+            }
+            break;
+
+            default:
+            {
+                new_name = g_string_new (NULL);
+                g_string_printf (new_name, "renamed-%05u", i);
+            }
+            break;
+        }
+
+        selection = g_list_prepend (selection, file);
+        directory_files = g_list_prepend (directory_files, nautilus_file_ref (file));
+        new_names = g_list_prepend (new_names, new_name);
+    }
+
+    existing_file = nautilus_file_get_by_uri (TEST_DIRECTORY_URI "/existing");
+    directory_files = g_list_prepend (directory_files, existing_file);
+
+    selection = g_list_reverse (selection);
+    new_names = g_list_reverse (new_names);
+
+    conflicts = batch_rename_get_conflicts_in_directory (directory,
+                                                         directory_files,
+                                                         selection,
+                                                         new_names);
+
+    g_assert_cmpint (g_list_length (conflicts), ==, 3);
+
+    conflict_data = g_list_nth_data (conflicts, 0);
+    g_assert_cmpint (conflict_data->index, ==, 100);
+    g_assert_cmpstr (conflict_data->name, ==, "existing");
+    g_assert_false (conflict_data->is_duplicate);
+
+    conflict_data = g_list_nth_data (conflicts, 1);
+    g_assert_cmpint (conflict_data->index, ==, 200);
+    g_assert_cmpstr (conflict_data->name, ==, "same");
+    g_assert_true (conflict_data->is_duplicate);
+
+    conflict_data = g_list_nth_data (conflicts, 2);
+    g_assert_cmpint (conflict_data->index, ==, 201);
+    g_assert_true (conflict_data->is_duplicate);
+
+    g_list_free_full (conflicts, conflict_data_free);
+    g_list_free_full (new_names, string_free);
+    nautilus_file_list_free (directory_files);
+    nautilus_file_list_free (selection);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+
+    g_test_add_func ("/batch-rename-conflicts/many-files",
+                     test_batch_rename_conflicts_many_files);
+
+    return g_test_run ();
+}
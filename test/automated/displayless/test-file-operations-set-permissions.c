@@ -0,0 +1,194 @@
+#include "test-utilities.h"
+#include <src/nautilus-tag-manager.h>
+
+/* Paths relative to the root, in walk order, with the mode each starts with.
+ * Consecutive paths share prefixes of different lengths, including none, so
+ * that every case of the undo log encoding is covered. */
+static const struct
+{
+    const gchar *path;
+    gboolean is_dir;
+    guint32 mode;
+} tree[] =
+{
+    { "a", TRUE, 0750 },
+    { "a/b", TRUE, 0700 },
+    { "a/b/c", FALSE, 0640 },
+    { "a/b/d", FALSE, 0600 },
+    { "a/e", FALSE, 0644 },
+    { "ab", FALSE, 0604 },
+    { "f", TRUE, 0755 },
+    { "f/g", FALSE, 0400 },
+};
+
+static GFile *
+create_tree (const gchar *name)
+{
+    g_autoptr (GFile) root = g_file_new_for_path (test_get_tmp_dir ());
+    GFile *tree_root = g_file_get_child (root, name);
+
+    g_file_make_directory (tree_root, NULL, NULL);
+
+    for (guint i = 0; i < G_N_ELEMENTS (tree); i++)
+    {
+        g_autoptr (GFile) file = g_file_resolve_relative_path (tree_root, tree[i].path);
+
+        if (tree[i].is_dir)
+        {
+            g_file_make_directory (file, NULL, NULL);
+        }
+        else
+        {
+            g_file_replace_contents (file, "", 0, NULL, FALSE,
+                                     G_FILE_CREATE_NONE, NULL, NULL, NULL);
+        }
+    }
+
+    /* Set the modes once the tree is complete, so that read-only
+     * directories don't get in the way. */
+    for (guint i = G_N_ELEMENTS (tree); i > 0; i--)
+    {
+        g_autoptr (GFile) file = g_file_resolve_relative_path (tree_root, tree[i - 1].path);
+
+        g_file_set_attribute_uint32 (file, G_FILE_ATTRIBUTE_UNIX_MODE, tree[i - 1].mode,
+                                     G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+    }
+
+    return tree_root;
+}
+
+static guint32
+get_mode (GFile       *tree_root,
+          const gchar *path)
+{
+    g_autoptr (GFile) file = g_file_resolve_relative_path (tree_root, path);
+    g_autoptr (GFileInfo) info = NULL;
+
+    info = g_file_query_info (file, G_FILE_ATTRIBUTE_UNIX_MODE,
+                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+    g_assert_nonnull (info);
+
+    return g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE) & 07777;
+}
+
+static void
+assert_original_modes (GFile *tree_root)
+{
+    for (guint i = 0; i < G_N_ELEMENTS (tree); i++)
+    {
+        g_assert_cmpuint (get_mode (tree_root, tree[i].path), ==, tree[i].mode);
+    }
+}
+
+static void
+set_permissions_done (gboolean success,
+                      gpointer user_data)
+{
+    gboolean *done = user_data;
+
+    g_assert_true (success);
+    *done = TRUE;
+}
+
+static void
+test_set_permissions_recursive_undo (void)
+{
+    g_autoptr (GFile) root = g_file_new_for_path (test_get_tmp_dir ());
+    g_autoptr (GFile) tree_root = NULL;
+    g_autofree gchar *uri = NULL;
+    gboolean done = FALSE;
+
+    tree_root = create_tree ("set_permissions_recursive");
+    uri = g_file_get_uri (tree_root);
+
+    nautilus_file_set_permissions_recursive (uri, 0666, 07777, 0777, 07777,
+                                             set_permissions_done, &done);
+    while (!done)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS (tree); i++)
+    {
+        g_assert_cmpuint (get_mode (tree_root, tree[i].path), ==,
+                          tree[i].is_dir ? 0777 : 0666);
+    }
+
+    test_operation_undo ();
+
+    assert_original_modes (tree_root);
+
+    empty_directory_by_prefix (root, "set_permissions");
+}
+
+/* Fills the undo log by hand, in an order the walk would not produce, and
+ * checks that undoing restores every mode. */
+static void
+test_rec_permissions_undo_log (void)
+{
+    g_autoptr (GFile) root = g_file_new_for_path (test_get_tmp_dir ());
+    g_autoptr (GFile) tree_root = NULL;
+    g_autoptr (NautilusFileUndoInfo) info = NULL;
+
+    tree_root = create_tree ("set_permissions_log");
+
+    info = nautilus_file_undo_info_rec_permissions_new (tree_root, 0666, 07777, 0777, 07777);
+    for (guint i = G_N_ELEMENTS (tree); i > 0; i--)
+    {
+        nautilus_file_undo_info_rec_permissions_add_file (NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (info),
+                                                          tree[i - 1].path, tree[i - 1].mode);
+    }
+    for (guint i = 0; i < G_N_ELEMENTS (tree); i++)
+    {
+        nautilus_file_undo_info_rec_permissions_add_file (NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS (info),
+                                                          tree[i].path, tree[i].mode);
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS (tree); i++)
+    {
+        g_autoptr (GFile) file = g_file_resolve_relative_path (tree_root, tree[i].path);
+
+        g_file_set_attribute_uint32 (file, G_FILE_ATTRIBUTE_UNIX_MODE,
+                                     tree[i].is_dir ? 0777 : 0666,
+                                     G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+    }
+
+    nautilus_file_undo_manager_set_action (info);
+    test_operation_undo ();
+
+    assert_original_modes (tree_root);
+
+    empty_directory_by_prefix (root, "set_permissions");
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/test-set-permissions-recursive-undo/1.0",
+                     test_set_permissions_recursive_undo);
+    g_test_add_func ("/test-rec-permissions-undo-log/1.0",
+                     test_rec_permissions_undo_log);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (NautilusFileUndoManager) undo_manager = NULL;
+    g_autoptr (NautilusTagManager) tag_manager = NULL;
+    int ret;
+
+    undo_manager = nautilus_file_undo_manager_new ();
+    tag_manager = nautilus_tag_manager_new_dummy ();
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+
+    setup_test_suite ();
+
+    ret = g_test_run ();
+
+    test_clear_tmp_dir ();
+
+    return ret;
+}
@@ -0,0 +1,109 @@
+#include "test-utilities.h"
+
+#include <glib/gstdio.h>
+#include <src/nautilus-file.h>
+#include <src/nautilus-keyfile-metadata.h>
+
+static gchar *
+write_keyfile (const gchar *name,
+               const gchar *contents)
+{
+    gchar *keyfile_filename = g_build_filename (test_get_tmp_dir (), name, NULL);
+
+    g_assert_true (g_file_set_contents (keyfile_filename, contents, -1, NULL));
+
+    return keyfile_filename;
+}
+
+static void
+set_and_save (const gchar *keyfile_filename,
+              const gchar *key,
+              const gchar *value)
+{
+    g_autoptr (GFile) location = g_file_new_for_path (test_get_tmp_dir ());
+    g_autoptr (NautilusFile) file = nautilus_file_get (location);
+
+    nautilus_keyfile_metadata_set_string (file, keyfile_filename, "directory", key, value);
+
+    /* Changes are saved in an idle. */
+    while (g_main_context_iteration (NULL, FALSE))
+    {
+    }
+}
+
+/* The file must read back as a whole, with both the old and new values. */
+static void
+assert_reloads (const gchar *keyfile_filename)
+{
+    g_autoptr (GKeyFile) keyfile = g_key_file_new ();
+    g_autofree gchar *value = NULL;
+
+    g_assert_true (g_key_file_load_from_file (keyfile, keyfile_filename, G_KEY_FILE_NONE, NULL));
+
+    value = g_key_file_get_string (keyfile, "directory", "new-key", NULL);
+    g_assert_cmpstr (value, ==, "new-value");
+}
+
+static void
+test_keyfile_metadata_truncated_tail (void)
+{
+    g_autofree gchar *keyfile_filename = NULL;
+    g_autoptr (GKeyFile) keyfile = g_key_file_new ();
+    g_autofree gchar *value = NULL;
+
+    /* As left by an append that was interrupted in a group name. */
+    keyfile_filename = write_keyfile ("truncated-tail.keyfile",
+                                      "[directory]\nold-key=old-value\n[direc");
+
+    set_and_save (keyfile_filename, "new-key", "new-value");
+    assert_reloads (keyfile_filename);
+
+    g_key_file_load_from_file (keyfile, keyfile_filename, G_KEY_FILE_NONE, NULL);
+    value = g_key_file_get_string (keyfile, "directory", "old-key", NULL);
+    g_assert_cmpstr (value, ==, "old-value");
+
+    /* Later changes are appended to the rewritten file. */
+    set_and_save (keyfile_filename, "new-key", "newer-value");
+    g_key_file_load_from_file (keyfile, keyfile_filename, G_KEY_FILE_NONE, NULL);
+    g_clear_pointer (&value, g_free);
+    value = g_key_file_get_string (keyfile, "directory", "new-key", NULL);
+    g_assert_cmpstr (value, ==, "newer-value");
+
+    g_remove (keyfile_filename);
+}
+
+static void
+test_keyfile_metadata_malformed (void)
+{
+    g_autofree gchar *keyfile_filename = NULL;
+
+    keyfile_filename = write_keyfile ("malformed.keyfile",
+                                      "not a keyfile\n[directory]\nold-key=old-value\n");
+
+    set_and_save (keyfile_filename, "new-key", "new-value");
+    assert_reloads (keyfile_filename);
+
+    g_remove (keyfile_filename);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    int ret;
+
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+
+    g_test_add_func ("/keyfile-metadata/truncated-tail",
+                     test_keyfile_metadata_truncated_tail);
+    g_test_add_func ("/keyfile-metadata/malformed",
+                     test_keyfile_metadata_malformed);
+
+    ret = g_test_run ();
+
+    test_clear_tmp_dir ();
+
+    return ret;
+}
@@ -23,11 +23,22 @@ finished_cb (NautilusSearchEngine         *engine,
 
     g_print ("\nNautilus search engine simple finished!\n");
 
-    delete_search_file_hierarchy ("simple");
-
     g_main_loop_quit (user_data);
 }
 
+static void
+run_search (NautilusSearchEngine *engine,
+            NautilusQuery        *query,
+            GMainLoop            *loop)
+{
+    total_hits = 0;
+    nautilus_search_provider_set_query (NAUTILUS_SEARCH_PROVIDER (engine), query);
+    nautilus_search_engine_start_by_target (NAUTILUS_SEARCH_PROVIDER (engine),
+                                            NAUTILUS_SEARCH_ENGINE_SIMPLE_ENGINE);
+
+    g_main_loop_run (loop);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -37,6 +48,8 @@ main (int   argc,
     g_autoptr (NautilusDirectory) directory = NULL;
     g_autoptr (NautilusQuery) query = NULL;
     g_autoptr (GFile) location = NULL;
+    g_autoptr (GPtrArray) date_range = NULL;
+    g_autoptr (GPtrArray) mime_types = NULL;
 
     loop = g_main_loop_new (NULL, FALSE);
 
@@ -55,7 +68,6 @@ main (int   argc,
 
     query = nautilus_query_new ();
     nautilus_query_set_text (query, "engine_simple");
-    nautilus_search_provider_set_query (NAUTILUS_SEARCH_PROVIDER (engine), query);
 
     location = g_file_new_for_path (test_get_tmp_dir ());
     directory = nautilus_directory_get (location);
@@ -63,12 +75,37 @@ main (int   argc,
 
     create_search_file_hierarchy ("simple");
 
-    nautilus_search_engine_start_by_target (NAUTILUS_SEARCH_PROVIDER (engine),
-                                            NAUTILUS_SEARCH_ENGINE_SIMPLE_ENGINE);
+    run_search (engine, query, loop);
+    g_assert_cmpint (total_hits, ==, 3);
 
-    g_main_loop_run (loop);
+    /* A refined query is answered from the results of the previous one. */
+    nautilus_query_set_text (query, "engine_simple_");
+    run_search (engine, query, loop);
+    g_assert_cmpint (total_hits, ==, 2);
+
+    /* Adding a date filter is also a refinement, and the previous results
+     * must be checked against it. All the files were modified just now. */
+    date_range = g_ptr_array_new_full (2, (GDestroyNotify) g_date_time_unref);
+    g_ptr_array_add (date_range, g_date_time_new_utc (2000, 1, 1, 0, 0, 0));
+    g_ptr_array_add (date_range, g_date_time_new_utc (2000, 1, 2, 0, 0, 0));
+    nautilus_query_set_search_type (query, NAUTILUS_QUERY_SEARCH_TYPE_LAST_MODIFIED);
+    nautilus_query_set_date_range (query, date_range);
+    run_search (engine, query, loop);
+    g_assert_cmpint (total_hits, ==, 0);
+
+    nautilus_query_set_date_range (query, NULL);
+    run_search (engine, query, loop);
+    g_assert_cmpint (total_hits, ==, 2);
+
+    /* Adding a MIME type filter is not a refinement, but must still narrow
+     * down the results. */
+    mime_types = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (mime_types, g_strdup ("image/png"));
+    nautilus_query_set_mime_types (query, mime_types);
+    run_search (engine, query, loop);
+    g_assert_cmpint (total_hits, ==, 0);
 
-    g_assert_cmpint (total_hits, ==, 3);
+    delete_search_file_hierarchy ("simple");
 
     test_clear_tmp_dir ();
 
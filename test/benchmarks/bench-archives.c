@@ -0,0 +1,165 @@
+#include "bench-utilities.h"
+
+#include <src/nautilus-tag-manager.h>
+
+/* Compresses a few directories of synthetic data into .tar.xz archives, one
+ * compress job each, then extracts all the archives with a single extract
+ * job, as when several archives are selected. It reports the throughput of
+ * both, in uncompressed MiB per second. */
+
+#define DEFAULT_N_FILES 256
+#define N_ARCHIVES 8
+#define FILE_SIZE (256 * 1024)
+#define BLOCK_SIZE 4096
+
+/* Half of the blocks are random and half are text, so that the archives
+ * have something to compress without being trivial to. */
+static void
+create_source (GFile *directory,
+               guint  n_files,
+               GRand *rand)
+{
+    g_autofree guint32 *contents = g_new (guint32, FILE_SIZE / sizeof (guint32));
+    static const gchar text[] = "Lorem ipsum dolor sit amet, consectetur adipiscing elit. ";
+
+    g_file_make_directory (directory, NULL, NULL);
+
+    for (guint i = 0; i < n_files; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("file_%u", i);
+        g_autoptr (GFile) file = g_file_get_child (directory, name);
+        guint8 *bytes = (guint8 *) contents;
+
+        for (gsize offset = 0; offset < FILE_SIZE; offset += BLOCK_SIZE)
+        {
+            if (g_rand_boolean (rand))
+            {
+                for (gsize j = 0; j < BLOCK_SIZE / sizeof (guint32); j++)
+                {
+                    contents[(offset / sizeof (guint32)) + j] = g_rand_int (rand);
+                }
+            }
+            else
+            {
+                for (gsize j = 0; j < BLOCK_SIZE; j++)
+                {
+                    bytes[offset + j] = text[j % (sizeof (text) - 1)];
+                }
+            }
+        }
+
+        g_file_replace_contents (file, (const gchar *) contents, FILE_SIZE,
+                                 NULL, FALSE, G_FILE_CREATE_NONE,
+                                 NULL, NULL, NULL);
+    }
+}
+
+static void
+compress_done_cb (GFile    *new_file,
+                  gboolean  success,
+                  gpointer  user_data)
+{
+    gboolean *done = user_data;
+
+    g_assert_true (success);
+    *done = TRUE;
+}
+
+static void
+extract_done_cb (GList    *outputs,
+                 gpointer  user_data)
+{
+    gboolean *done = user_data;
+
+    g_assert_cmpuint (g_list_length (outputs), ==, N_ARCHIVES);
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (NautilusFileUndoManager) undo_manager = NULL;
+    g_autoptr (NautilusTagManager) tag_manager = NULL;
+    g_autoptr (GRand) rand = NULL;
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) sources = NULL;
+    g_autoptr (GFile) archives = NULL;
+    g_autoptr (GFile) extracted = NULL;
+    g_autolist (GFile) archive_files = NULL;
+    BenchReport *report;
+    guint n_files;
+    guint64 n_bytes;
+    gboolean extracted_all = FALSE;
+    gint64 start_time;
+    gint64 duration;
+
+    undo_manager = nautilus_file_undo_manager_new ();
+    tag_manager = nautilus_tag_manager_new_dummy ();
+    bench_init ();
+
+    n_files = MAX (bench_get_n_files (DEFAULT_N_FILES) / N_ARCHIVES, 1);
+    n_bytes = (guint64) n_files * N_ARCHIVES * FILE_SIZE;
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    sources = g_file_get_child (root, "archives_sources");
+    archives = g_file_get_child (root, "archives");
+    extracted = g_file_get_child (root, "archives_extracted");
+    g_file_make_directory (sources, NULL, NULL);
+    g_file_make_directory (archives, NULL, NULL);
+    g_file_make_directory (extracted, NULL, NULL);
+
+    rand = g_rand_new_with_seed (0);
+    for (guint i = 0; i < N_ARCHIVES; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("source_%u", i);
+        g_autoptr (GFile) source = g_file_get_child (sources, name);
+
+        create_source (source, n_files, rand);
+    }
+
+    report = bench_report_new ("archives");
+    bench_report_add_count (report, "files", n_files * N_ARCHIVES);
+    bench_report_add_count (report, "archives", N_ARCHIVES);
+    bench_report_add_count (report, "bytes", n_bytes);
+
+    start_time = g_get_monotonic_time ();
+    for (guint i = 0; i < N_ARCHIVES; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("source_%u", i);
+        g_autofree gchar *archive_name = g_strdup_printf ("source_%u.tar.xz", i);
+        g_autoptr (GFile) source = g_file_get_child (sources, name);
+        GFile *archive = g_file_get_child (archives, archive_name);
+        g_autolist (GFile) files = g_list_prepend (NULL, g_object_ref (source));
+        gboolean compressed = FALSE;
+
+        nautilus_file_operations_compress (files, archive,
+                                           AUTOAR_FORMAT_TAR, AUTOAR_FILTER_XZ,
+                                           NULL, NULL, NULL,
+                                           compress_done_cb, &compressed);
+        bench_wait_for (&compressed);
+
+        archive_files = g_list_append (archive_files, archive);
+    }
+    duration = g_get_monotonic_time () - start_time;
+    bench_report_add_duration (report, "compress", duration);
+    bench_report_add_rate (report, "compress", n_bytes, duration);
+
+    start_time = g_get_monotonic_time ();
+    nautilus_file_operations_extract_files (archive_files, extracted,
+                                            NULL, NULL,
+                                            extract_done_cb, &extracted_all);
+    bench_wait_for (&extracted_all);
+    duration = g_get_monotonic_time () - start_time;
+    bench_report_add_duration (report, "extract", duration);
+    bench_report_add_rate (report, "extract", n_bytes, duration);
+
+    bench_report_finish (report);
+
+    bench_delete_recursively (sources);
+    bench_delete_recursively (archives);
+    bench_delete_recursively (extracted);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
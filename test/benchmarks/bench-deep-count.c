@@ -0,0 +1,90 @@
+#include "bench-utilities.h"
+
+#include <nautilus-file.h>
+
+/* Counts the contents of a tree of directories, first as one deep count of
+ * its root, then as one deep count per subdirectory, all started at once, as
+ * the properties window does for a selection of directories. */
+
+#define DEFAULT_N_FILES 100000
+#define N_DIRECTORIES 100
+
+static guint pending_counts = 0;
+
+static void
+deep_count_ready_cb (NautilusFile *file,
+                     gpointer      user_data)
+{
+    pending_counts--;
+}
+
+static void
+count_files (GList *files)
+{
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        pending_counts++;
+        nautilus_file_call_when_ready (l->data, NAUTILUS_FILE_ATTRIBUTE_DEEP_COUNTS,
+                                       deep_count_ready_cb, NULL);
+    }
+
+    while (pending_counts > 0)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (NautilusFile) root = NULL;
+    g_autoptr (GList) roots = NULL;
+    g_autolist (NautilusFile) directories = NULL;
+    BenchReport *report;
+    guint n_files;
+    guint directory_count;
+    guint file_count;
+    gint64 start_time;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_tree ("deep_count", N_DIRECTORIES,
+                                  MAX (n_files / N_DIRECTORIES, 1));
+
+    root = nautilus_file_get (location);
+    roots = g_list_prepend (NULL, root);
+
+    report = bench_report_new ("deep-count");
+
+    start_time = g_get_monotonic_time ();
+    count_files (roots);
+    bench_report_add_duration (report, "root", g_get_monotonic_time () - start_time);
+
+    nautilus_file_get_deep_counts (root, &directory_count, &file_count,
+                                   NULL, NULL, FALSE);
+    bench_report_add_count (report, "directories", directory_count);
+    bench_report_add_count (report, "files", file_count);
+
+    for (guint i = 0; i < N_DIRECTORIES; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("directory_%u", i);
+        g_autoptr (GFile) child = g_file_get_child (location, name);
+
+        directories = g_list_prepend (directories, nautilus_file_get (child));
+    }
+
+    start_time = g_get_monotonic_time ();
+    count_files (directories);
+    bench_report_add_duration (report, "subdirectories",
+                               g_get_monotonic_time () - start_time);
+
+    bench_report_finish (report);
+
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "bench-utilities.h"
+
+#include <nautilus-directory.h>
+
+/* Loads a large directory through NautilusDirectory, as opening it in a
+ * view does, and reports how long it takes until all files have info. The
+ * load is then repeated with NAUTILUS_DEFER_METADATA set, where files get
+ * their info without metadata, and the metadata of the whole directory is
+ * fetched afterwards; and once more with NAUTILUS_DEFER_EXTENDED_INFO also
+ * set, where files only get the basic attributes. */
+
+#define DEFAULT_N_FILES 100000
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+static gint64
+wait_for_attributes (NautilusDirectory      *directory,
+                     NautilusFileAttributes  attributes)
+{
+    gboolean done = FALSE;
+    gint64 start_time;
+
+    start_time = g_get_monotonic_time ();
+    nautilus_directory_call_when_ready (directory, attributes,
+                                        TRUE, directory_ready_cb, &done);
+    bench_wait_for (&done);
+
+    return g_get_monotonic_time () - start_time;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    NautilusDirectory *directory;
+    BenchReport *report;
+    guint n_files;
+    gint64 load_time;
+    gint64 deferred_load_time;
+    gint64 deferred_metadata_time;
+    gint64 basic_load_time;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("directory_load", n_files);
+
+    /* The monitor keeps the file list loaded between the requests. */
+    directory = nautilus_directory_get (location);
+    nautilus_directory_file_monitor_add (directory, &directory, TRUE,
+                                         NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                         NULL, NULL);
+    load_time = wait_for_attributes (directory,
+                                     NAUTILUS_FILE_ATTRIBUTE_INFO |
+                                     NAUTILUS_FILE_ATTRIBUTE_METADATA);
+    nautilus_directory_file_monitor_remove (directory, &directory);
+    nautilus_directory_unref (directory);
+
+    g_setenv ("NAUTILUS_DEFER_METADATA", "1", TRUE);
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_file_monitor_add (directory, &directory, TRUE,
+                                         NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                         NULL, NULL);
+    deferred_load_time = wait_for_attributes (directory, NAUTILUS_FILE_ATTRIBUTE_INFO);
+    deferred_metadata_time = wait_for_attributes (directory, NAUTILUS_FILE_ATTRIBUTE_METADATA);
+    nautilus_directory_file_monitor_remove (directory, &directory);
+    nautilus_directory_unref (directory);
+
+    g_setenv ("NAUTILUS_DEFER_EXTENDED_INFO", "1", TRUE);
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_file_monitor_add (directory, &directory, TRUE,
+                                         NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                         NULL, NULL);
+    basic_load_time = wait_for_attributes (directory, NAUTILUS_FILE_ATTRIBUTE_INFO);
+    nautilus_directory_file_monitor_remove (directory, &directory);
+    nautilus_directory_unref (directory);
+
+    g_unsetenv ("NAUTILUS_DEFER_EXTENDED_INFO");
+    g_unsetenv ("NAUTILUS_DEFER_METADATA");
+
+    report = bench_report_new ("directory-load");
+    bench_report_add_count (report, "files", n_files);
+    bench_report_add_duration (report, "load", load_time);
+    bench_report_add_duration (report, "deferred_load", deferred_load_time);
+    bench_report_add_duration (report, "deferred_metadata", deferred_metadata_time);
+    bench_report_add_duration (report, "basic_load", basic_load_time);
+    bench_report_finish (report);
+
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
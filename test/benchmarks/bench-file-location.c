@@ -0,0 +1,126 @@
+#include "bench-utilities.h"
+
+#include <nautilus-directory.h>
+#include <nautilus-file.h>
+
+/* Gets the location and uri of each file of a large directory, as the views,
+ * thumbnailer and starred lookups do, and compares it with building them
+ * from the parent and name on every call, as nautilus_file_get_location()
+ * and nautilus_file_get_uri() used to. Each step reports its time and how
+ * many allocations it made. */
+
+#define DEFAULT_N_FILES 100000
+
+static void
+add_step (BenchReport *report,
+          const gchar *key,
+          gint64       start_time,
+          guint64      start_n_allocations)
+{
+    gint64 duration = g_get_monotonic_time () - start_time;
+    guint64 n_allocations = bench_get_n_allocations () - start_n_allocations;
+    g_autofree gchar *allocations_key = g_strconcat (key, "_allocations", NULL);
+
+    bench_report_add_duration (report, key, duration);
+    bench_report_add_count (report, allocations_key, n_allocations);
+}
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    g_autolist (NautilusFile) files = NULL;
+    BenchReport *report;
+    guint n_files;
+    gboolean done = FALSE;
+    gint64 start_time;
+    guint64 start_n_allocations;
+    guint n_equal = 0;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("file_location", n_files);
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE, directory_ready_cb, &done);
+    bench_wait_for (&done);
+
+    files = nautilus_directory_get_file_list (directory);
+
+    report = bench_report_new ("file-location");
+    bench_report_add_count (report, "files", g_list_length (files));
+
+    /* One GFile and one string per file. */
+    start_n_allocations = bench_get_n_allocations ();
+    start_time = g_get_monotonic_time ();
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        g_autoptr (GFile) child = g_file_get_child (location,
+                                                    nautilus_file_get_name (l->data));
+        g_autofree char *uri = g_file_get_uri (child);
+    }
+    add_step (report, "uncached_uri", start_time, start_n_allocations);
+
+    /* The first pass fills the cache, the second one only reads it. */
+    start_n_allocations = bench_get_n_allocations ();
+    start_time = g_get_monotonic_time ();
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        nautilus_file_peek_uri (l->data);
+    }
+    add_step (report, "first_peek_uri", start_time, start_n_allocations);
+
+    start_n_allocations = bench_get_n_allocations ();
+    start_time = g_get_monotonic_time ();
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        nautilus_file_peek_uri (l->data);
+    }
+    add_step (report, "peek_uri", start_time, start_n_allocations);
+
+    /* Two GFiles per comparison. */
+    start_n_allocations = bench_get_n_allocations ();
+    start_time = g_get_monotonic_time ();
+    for (GList *l = files; l != NULL && l->next != NULL; l = l->next)
+    {
+        g_autoptr (GFile) a = g_file_get_child (location,
+                                                nautilus_file_get_name (l->data));
+        g_autoptr (GFile) b = g_file_get_child (location,
+                                                nautilus_file_get_name (l->next->data));
+
+        n_equal += g_file_equal (a, b);
+    }
+    add_step (report, "uncached_compare", start_time, start_n_allocations);
+
+    start_n_allocations = bench_get_n_allocations ();
+    start_time = g_get_monotonic_time ();
+    for (GList *l = files; l != NULL && l->next != NULL; l = l->next)
+    {
+        n_equal += nautilus_file_compare_location (l->data, l->next->data) == 0;
+    }
+    add_step (report, "compare_location", start_time, start_n_allocations);
+
+    g_assert_cmpuint (n_equal, ==, 0);
+
+    bench_report_finish (report);
+
+    g_clear_pointer (&directory, nautilus_directory_unref);
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "bench-utilities.h"
+
+#include <src/nautilus-tag-manager.h>
+
+/* Copies a tree of directories with the copy job, moves the copy with the
+ * move job, changes the permissions of everything in it with the recursive
+ * permissions job, and deletes it with the delete job. */
+
+#define DEFAULT_N_FILES 20000
+#define N_DIRECTORIES 100
+
+static void
+set_permissions_done (gboolean success,
+                      gpointer user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (NautilusFileUndoManager) undo_manager = NULL;
+    g_autoptr (NautilusTagManager) tag_manager = NULL;
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) source = NULL;
+    g_autoptr (GFile) copy_destination = NULL;
+    g_autoptr (GFile) move_destination = NULL;
+    g_autoptr (GFile) copy = NULL;
+    g_autoptr (GFile) moved_copy = NULL;
+    g_autolist (GFile) files = NULL;
+    g_autofree gchar *moved_copy_uri = NULL;
+    BenchReport *report;
+    guint n_files;
+    gboolean permissions_set = FALSE;
+    gint64 start_time;
+
+    undo_manager = nautilus_file_undo_manager_new ();
+    tag_manager = nautilus_tag_manager_new_dummy ();
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    source = bench_create_tree ("file_operations", N_DIRECTORIES,
+                                MAX (n_files / N_DIRECTORIES, 1));
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    copy_destination = g_file_get_child (root, "file_operations_copy_destination");
+    move_destination = g_file_get_child (root, "file_operations_move_destination");
+    g_file_make_directory (copy_destination, NULL, NULL);
+    g_file_make_directory (move_destination, NULL, NULL);
+
+    copy = g_file_get_child (copy_destination, "file_operations");
+    moved_copy = g_file_get_child (move_destination, "file_operations");
+
+    report = bench_report_new ("file-operations");
+    bench_report_add_count (report, "files", n_files);
+
+    files = g_list_prepend (NULL, g_object_ref (source));
+    start_time = g_get_monotonic_time ();
+    nautilus_file_operations_copy_sync (files, copy_destination);
+    bench_report_add_duration (report, "copy", g_get_monotonic_time () - start_time);
+    g_assert_true (g_file_query_exists (copy, NULL));
+    g_list_free_full (g_steal_pointer (&files), g_object_unref);
+
+    files = g_list_prepend (NULL, g_object_ref (copy));
+    start_time = g_get_monotonic_time ();
+    nautilus_file_operations_move_sync (files, move_destination);
+    bench_report_add_duration (report, "move", g_get_monotonic_time () - start_time);
+    g_assert_true (g_file_query_exists (moved_copy, NULL));
+    g_list_free_full (g_steal_pointer (&files), g_object_unref);
+
+    moved_copy_uri = g_file_get_uri (moved_copy);
+    start_time = g_get_monotonic_time ();
+    nautilus_file_set_permissions_recursive (moved_copy_uri, 0600, 0777, 0700, 0777,
+                                             set_permissions_done, &permissions_set);
+    bench_wait_for (&permissions_set);
+    bench_report_add_duration (report, "set_permissions", g_get_monotonic_time () - start_time);
+
+    files = g_list_prepend (NULL, g_object_ref (moved_copy));
+    start_time = g_get_monotonic_time ();
+    nautilus_file_operations_delete_sync (files);
+    bench_report_add_duration (report, "delete", g_get_monotonic_time () - start_time);
+    g_assert_false (g_file_query_exists (moved_copy, NULL));
+
+    bench_report_finish (report);
+
+    bench_delete_recursively (source);
+    bench_delete_recursively (copy_destination);
+    bench_delete_recursively (move_destination);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "bench-utilities.h"
+
+#include <nautilus-directory.h>
+#include <nautilus-file.h>
+
+/* Sorts the files of a large directory with nautilus_file_compare_for_sort(),
+ * for each of the sort types the views offer by default. */
+
+#define DEFAULT_N_FILES 100000
+
+static const struct
+{
+    const gchar *key;
+    NautilusFileSortType sort_type;
+} sort_types[] =
+{
+    { "name", NAUTILUS_FILE_SORT_BY_DISPLAY_NAME },
+    { "size", NAUTILUS_FILE_SORT_BY_SIZE },
+    { "type", NAUTILUS_FILE_SORT_BY_TYPE },
+    { "mtime", NAUTILUS_FILE_SORT_BY_MTIME },
+};
+
+static gint
+compare_files (gconstpointer a,
+               gconstpointer b,
+               gpointer      user_data)
+{
+    NautilusFileSortType sort_type = GPOINTER_TO_INT (user_data);
+
+    return nautilus_file_compare_for_sort (*(NautilusFile **) a,
+                                           *(NautilusFile **) b,
+                                           sort_type, TRUE, FALSE);
+}
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    g_autolist (NautilusFile) files = NULL;
+    g_autoptr (GPtrArray) unsorted = NULL;
+    BenchReport *report;
+    guint n_files;
+    gboolean done = FALSE;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("file_sort", n_files);
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE, directory_ready_cb, &done);
+    bench_wait_for (&done);
+
+    files = nautilus_directory_get_file_list (directory);
+    unsorted = g_ptr_array_new ();
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        g_ptr_array_add (unsorted, l->data);
+    }
+
+    report = bench_report_new ("file-sort");
+    bench_report_add_count (report, "files", unsorted->len);
+
+    for (guint i = 0; i < G_N_ELEMENTS (sort_types); i++)
+    {
+        g_autoptr (GPtrArray) sorted = g_ptr_array_copy (unsorted, NULL, NULL);
+        gint64 start_time = g_get_monotonic_time ();
+
+        g_ptr_array_sort_with_data (sorted, compare_files,
+                                    GINT_TO_POINTER (sort_types[i].sort_type));
+
+        bench_report_add_duration (report, sort_types[i].key,
+                                   g_get_monotonic_time () - start_time);
+    }
+
+    bench_report_finish (report);
+
+    g_clear_pointer (&directory, nautilus_directory_unref);
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "bench-utilities.h"
+
+/* Searches a large, already loaded directory with the model engine, and
+ * reports how long it takes, and for how long the main loop was blocked. */
+
+#define DEFAULT_N_FILES 100000
+#define TICK_INTERVAL_MS 1
+
+static guint total_hits = 0;
+static gint64 search_start_time = 0;
+static gint64 first_hit_time = 0;
+static gint64 last_tick_time = 0;
+static gint64 longest_stall = 0;
+
+static gboolean
+tick_cb (gpointer user_data)
+{
+    gint64 now = g_get_monotonic_time ();
+
+    if (last_tick_time != 0)
+    {
+        longest_stall = MAX (longest_stall, now - last_tick_time);
+    }
+    last_tick_time = now;
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+hits_added_cb (NautilusSearchEngine *engine,
+               GList                *hits)
+{
+    if (first_hit_time == 0)
+    {
+        first_hit_time = g_get_monotonic_time ();
+    }
+
+    total_hits += g_list_length (hits);
+}
+
+static void
+finished_cb (NautilusSearchEngine         *engine,
+             NautilusSearchProviderStatus  status,
+             gpointer                      user_data)
+{
+    gboolean *done = user_data;
+
+    nautilus_search_provider_stop (NAUTILUS_SEARCH_PROVIDER (engine));
+
+    *done = TRUE;
+}
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    NautilusSearchEngine *engine;
+    NautilusSearchEngineModel *model;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    g_autoptr (NautilusQuery) query = NULL;
+    g_autoptr (GFile) location = NULL;
+    BenchReport *report;
+    guint n_files;
+    gboolean done = FALSE;
+    gint64 finish_time;
+    guint tick_id;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("search_model", n_files);
+    directory = nautilus_directory_get (location);
+
+    /* Loading the directory is not part of what is measured. */
+    nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE, directory_ready_cb, &done);
+    bench_wait_for (&done);
+    done = FALSE;
+
+    engine = nautilus_search_engine_new ();
+    g_signal_connect (engine, "hits-added",
+                      G_CALLBACK (hits_added_cb), NULL);
+    g_signal_connect (engine, "finished",
+                      G_CALLBACK (finished_cb), &done);
+
+    query = nautilus_query_new ();
+    nautilus_query_set_text (query, "file 1");
+    nautilus_query_set_location (query, location);
+    nautilus_search_provider_set_query (NAUTILUS_SEARCH_PROVIDER (engine), query);
+
+    model = nautilus_search_engine_get_model_provider (engine);
+    nautilus_search_engine_model_set_model (model, directory);
+
+    tick_id = g_timeout_add (TICK_INTERVAL_MS, tick_cb, NULL);
+
+    search_start_time = g_get_monotonic_time ();
+    nautilus_search_engine_start_by_target (NAUTILUS_SEARCH_PROVIDER (engine),
+                                            NAUTILUS_SEARCH_ENGINE_MODEL_ENGINE);
+    bench_wait_for (&done);
+    finish_time = g_get_monotonic_time ();
+
+    g_source_remove (tick_id);
+
+    g_assert_cmpuint (total_hits, >, 0);
+
+    report = bench_report_new ("search-engine-model");
+    bench_report_add_count (report, "files", n_files);
+    bench_report_add_count (report, "hits", total_hits);
+    bench_report_add_duration (report, "first_hit", first_hit_time - search_start_time);
+    bench_report_add_duration (report, "search", finish_time - search_start_time);
+    bench_report_add_duration (report, "longest_stall", longest_stall);
+    bench_report_finish (report);
+
+    g_object_unref (engine);
+    g_clear_pointer (&directory, nautilus_directory_unref);
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "bench-utilities.h"
+
+/* Searches a tree of directories with the simple engine, then searches it
+ * again with a longer text, as typing in the search bar does. */
+
+#define DEFAULT_N_FILES 100000
+#define N_DIRECTORIES 100
+
+static guint total_hits = 0;
+static gint64 first_hit_time = 0;
+
+static void
+hits_added_cb (NautilusSearchEngine *engine,
+               GList                *hits)
+{
+    if (first_hit_time == 0)
+    {
+        first_hit_time = g_get_monotonic_time ();
+    }
+
+    total_hits += g_list_length (hits);
+}
+
+static void
+finished_cb (NautilusSearchEngine         *engine,
+             NautilusSearchProviderStatus  status,
+             gpointer                      user_data)
+{
+    gboolean *done = user_data;
+
+    nautilus_search_provider_stop (NAUTILUS_SEARCH_PROVIDER (engine));
+
+    *done = TRUE;
+}
+
+static void
+run_search (NautilusSearchEngine *engine,
+            GFile                *location,
+            const gchar          *text,
+            BenchReport          *report,
+            const gchar          *key)
+{
+    g_autofree gchar *hits_key = g_strconcat (key, "_hits", NULL);
+    g_autofree gchar *first_hit_key = g_strconcat (key, "_first_hit", NULL);
+    g_autoptr (NautilusQuery) query = NULL;
+    gboolean done = FALSE;
+    gulong finished_id;
+    gint64 start_time;
+
+    total_hits = 0;
+    first_hit_time = 0;
+
+    query = nautilus_query_new ();
+    nautilus_query_set_text (query, text);
+    nautilus_query_set_location (query, location);
+    nautilus_search_provider_set_query (NAUTILUS_SEARCH_PROVIDER (engine), query);
+
+    finished_id = g_signal_connect (engine, "finished",
+                                    G_CALLBACK (finished_cb), &done);
+
+    start_time = g_get_monotonic_time ();
+    nautilus_search_engine_start_by_target (NAUTILUS_SEARCH_PROVIDER (engine),
+                                            NAUTILUS_SEARCH_ENGINE_SIMPLE_ENGINE);
+    bench_wait_for (&done);
+
+    bench_report_add_duration (report, key, g_get_monotonic_time () - start_time);
+    if (first_hit_time != 0)
+    {
+        bench_report_add_duration (report, first_hit_key, first_hit_time - start_time);
+    }
+    bench_report_add_count (report, hits_key, total_hits);
+
+    g_signal_handler_disconnect (engine, finished_id);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    NautilusSearchEngine *engine;
+    BenchReport *report;
+    guint n_files;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_tree ("search_simple", N_DIRECTORIES,
+                                  MAX (n_files / N_DIRECTORIES, 1));
+
+    engine = nautilus_search_engine_new ();
+    g_signal_connect (engine, "hits-added",
+                      G_CALLBACK (hits_added_cb), NULL);
+
+    report = bench_report_new ("search-engine-simple");
+    bench_report_add_count (report, "files", n_files);
+
+    run_search (engine, location, "file 1", report, "search");
+    run_search (engine, location, "file 12", report, "refine");
+
+    bench_report_finish (report);
+
+    g_object_unref (engine);
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
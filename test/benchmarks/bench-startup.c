@@ -0,0 +1,92 @@
+#include "bench-utilities.h"
+
+#include <nautilus-directory.h>
+#include <nautilus-module.h>
+#include <nautilus-tag-manager.h>
+
+/* Does the startup work that comes before the first window can be shown,
+ * opening the starred files database and loading the extensions, and then
+ * loads a directory as the first window does. It reports how long startup
+ * blocks, how long until the files of the directory have their info, and
+ * how long until the extensions are loaded.
+ *
+ * Extensions are only loaded once per process, so run it once as is and
+ * once with NAUTILUS_DEFER_EXTENSIONS set to compare both startup modes. */
+
+#define DEFAULT_N_FILES 1000
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+static void
+extensions_loaded_cb (gpointer user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (GFile) data_dir = NULL;
+    g_autoptr (NautilusTagManager) tag_manager = NULL;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    BenchReport *report;
+    guint n_files;
+    gboolean files_ready = FALSE;
+    gboolean extensions_loaded = FALSE;
+    gint64 start_time;
+    gint64 startup_time;
+    gint64 first_files_time;
+    gint64 extensions_time;
+
+    /* Keep the starred files database out of the user's data. */
+    data_dir = g_file_new_build_filename (test_get_tmp_dir (), "data", NULL);
+    g_setenv ("XDG_DATA_HOME", g_file_peek_path (data_dir), TRUE);
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("startup", n_files);
+
+    start_time = g_get_monotonic_time ();
+    tag_manager = nautilus_tag_manager_new ();
+    nautilus_module_setup_async (extensions_loaded_cb, &extensions_loaded);
+    startup_time = g_get_monotonic_time () - start_time;
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE, directory_ready_cb, &files_ready);
+    bench_wait_for (&files_ready);
+    first_files_time = g_get_monotonic_time () - start_time;
+
+    bench_wait_for (&extensions_loaded);
+    extensions_time = g_get_monotonic_time () - start_time;
+
+    report = bench_report_new ("startup");
+    bench_report_add_count (report, "files", n_files);
+    bench_report_add_count (report, "deferred_extensions",
+                            g_getenv ("NAUTILUS_DEFER_EXTENSIONS") != NULL);
+    bench_report_add_duration (report, "startup", startup_time);
+    bench_report_add_duration (report, "first_files", first_files_time);
+    bench_report_add_duration (report, "extensions", extensions_time);
+    bench_report_finish (report);
+
+    g_clear_pointer (&directory, nautilus_directory_unref);
+    g_clear_object (&tag_manager);
+    bench_delete_recursively (location);
+    bench_delete_recursively (data_dir);
+    test_clear_tmp_dir ();
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "bench-utilities.h"
+
+#define MAX_FILE_SIZE 4096
+
+#ifdef __GLIBC__
+/* Allocations are counted by wrapping the glibc allocator, which every
+ * library of the process then goes through, including g_malloc(). */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members,
+                            size_t size);
+extern void *__libc_realloc (void   *pointer,
+                             size_t  size);
+
+static guint64 n_allocations = 0;
+
+void *
+malloc (size_t size)
+{
+    __atomic_add_fetch (&n_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members,
+        size_t size)
+{
+    __atomic_add_fetch (&n_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void   *pointer,
+         size_t  size)
+{
+    __atomic_add_fetch (&n_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc (pointer, size);
+}
+#endif
+
+struct _BenchReport
+{
+    GString *json;
+};
+
+static const gchar *extensions[] =
+{
+    "txt", "png", "c", "pdf", "ogg", "tar.gz"
+};
+
+void
+bench_init (void)
+{
+    nautilus_ensure_extension_points ();
+    /* Needed for nautilus-query.c and the file sort preferences. */
+    nautilus_global_preferences_init ();
+}
+
+/* The number of files a benchmark creates can be changed with the
+ * NAUTILUS_BENCH_N_FILES environment variable, e.g. to profile a smaller
+ * run, or to check how a hot path scales. */
+guint
+bench_get_n_files (guint default_n_files)
+{
+    const gchar *n_files_env = g_getenv ("NAUTILUS_BENCH_N_FILES");
+
+    if (n_files_env != NULL)
+    {
+        return (guint) g_ascii_strtoull (n_files_env, NULL, 10);
+    }
+
+    return default_n_files;
+}
+
+/* Returns the number of malloc(), calloc() and realloc() calls so far, in
+ * all threads, or 0 where they can't be counted. Take the difference
+ * around the code to measure. */
+guint64
+bench_get_n_allocations (void)
+{
+#ifdef __GLIBC__
+    return __atomic_load_n (&n_allocations, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+static void
+fill_directory (GFile *directory,
+                guint  n_files)
+{
+    static const gchar contents[MAX_FILE_SIZE] = { 0 };
+
+    for (guint i = 0; i < n_files; i++)
+    {
+        g_autofree gchar *name = NULL;
+        g_autoptr (GFile) file = NULL;
+
+        /* Vary names, types and sizes, so that sorting has something to do. */
+        name = g_strdup_printf ("File %u.%s", i, extensions[i % G_N_ELEMENTS (extensions)]);
+        file = g_file_get_child (directory, name);
+
+        g_file_replace_contents (file, contents, (i * 37) % MAX_FILE_SIZE,
+                                 NULL, FALSE, G_FILE_CREATE_NONE,
+                                 NULL, NULL, NULL);
+    }
+}
+
+GFile *
+bench_create_flat_directory (const gchar *name,
+                             guint        n_files)
+{
+    GFile *directory;
+
+    directory = g_file_new_build_filename (test_get_tmp_dir (), name, NULL);
+    g_file_make_directory (directory, NULL, NULL);
+
+    fill_directory (directory, n_files);
+
+    return directory;
+}
+
+GFile *
+bench_create_tree (const gchar *name,
+                   guint        n_directories,
+                   guint        n_files_per_directory)
+{
+    GFile *root;
+
+    root = g_file_new_build_filename (test_get_tmp_dir (), name, NULL);
+    g_file_make_directory (root, NULL, NULL);
+
+    for (guint i = 0; i < n_directories; i++)
+    {
+        g_autofree gchar *directory_name = g_strdup_printf ("directory_%u", i);
+        g_autoptr (GFile) directory = g_file_get_child (root, directory_name);
+
+        g_file_make_directory (directory, NULL, NULL);
+        fill_directory (directory, n_files_per_directory);
+    }
+
+    return root;
+}
+
+void
+bench_delete_recursively (GFile *file)
+{
+    g_autoptr (GFileEnumerator) enumerator = NULL;
+    GFile *child;
+
+    enumerator = g_file_enumerate_children (file,
+                                            G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                            NULL, NULL);
+
+    while (enumerator != NULL &&
+           g_file_enumerator_iterate (enumerator, NULL, &child, NULL, NULL) &&
+           child != NULL)
+    {
+        bench_delete_recursively (child);
+    }
+
+    g_file_delete (file, NULL, NULL);
+}
+
+void
+bench_wait_for (gboolean *done)
+{
+    while (!*done)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+/* Results are printed as one JSON object per benchmark, e.g.
+ *
+ *   {"benchmark": "directory-load", "files": 100000, "load_ms": 812.402}
+ *
+ * and also appended to the file named by NAUTILUS_BENCH_OUTPUT, if set, so
+ * that a whole `meson test --benchmark` run can be collected in one JSON
+ * Lines file and compared across commits. */
+BenchReport *
+bench_report_new (const gchar *benchmark)
+{
+    BenchReport *report = g_new0 (BenchReport, 1);
+
+    report->json = g_string_new ("{\"benchmark\": ");
+    g_string_append_printf (report->json, "\"%s\"", benchmark);
+
+    return report;
+}
+
+void
+bench_report_add_count (BenchReport *report,
+                        const gchar *key,
+                        guint64      count)
+{
+    g_string_append_printf (report->json, ", \"%s\": %" G_GUINT64_FORMAT, key, count);
+}
+
+void
+bench_report_add_duration (BenchReport *report,
+                           const gchar *key,
+                           gint64       duration_us)
+{
+    gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+
+    /* Not printf, so that the decimal separator doesn't follow the locale. */
+    g_ascii_formatd (buffer, sizeof (buffer), "%.3f", duration_us / 1000.0);
+    g_string_append_printf (report->json, ", \"%s_ms\": %s", key, buffer);
+}
+
+void
+bench_report_add_rate (BenchReport *report,
+                       const gchar *key,
+                       guint64      n_bytes,
+                       gint64       duration_us)
+{
+    gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+    gdouble rate = 0;
+
+    if (duration_us > 0)
+    {
+        rate = (n_bytes / (1024.0 * 1024.0)) / (duration_us / (gdouble) G_USEC_PER_SEC);
+    }
+
+    g_ascii_formatd (buffer, sizeof (buffer), "%.3f", rate);
+    g_string_append_printf (report->json, ", \"%s_mib_per_s\": %s", key, buffer);
+}
+
+void
+bench_report_finish (BenchReport *report)
+{
+    const gchar *output_path;
+
+    g_string_append (report->json, "}\n");
+    g_print ("%s", report->json->str);
+
+    output_path = g_getenv ("NAUTILUS_BENCH_OUTPUT");
+    if (output_path != NULL)
+    {
+        g_autoptr (GFile) output = g_file_new_for_path (output_path);
+        g_autoptr (GFileOutputStream) stream = NULL;
+        g_autoptr (GError) error = NULL;
+
+        stream = g_file_append_to (output, G_FILE_CREATE_NONE, NULL, &error);
+        if (stream == NULL ||
+            !g_output_stream_write_all (G_OUTPUT_STREAM (stream),
+                                        report->json->str, report->json->len,
+                                        NULL, NULL, &error))
+        {
+            g_warning ("Could not write benchmark results to %s: %s",
+                       output_path, error->message);
+        }
+    }
+
+    g_string_free (report->json, TRUE);
+    g_free (report);
+}
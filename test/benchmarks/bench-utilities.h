@@ -0,0 +1,31 @@
+#pragma once
+
+#include "test-utilities.h"
+
+typedef struct _BenchReport BenchReport;
+
+void bench_init (void);
+guint bench_get_n_files (guint default_n_files);
+guint64 bench_get_n_allocations (void);
+
+GFile *bench_create_flat_directory (const gchar *name,
+                                    guint        n_files);
+GFile *bench_create_tree (const gchar *name,
+                          guint        n_directories,
+                          guint        n_files_per_directory);
+void bench_delete_recursively (GFile *file);
+
+void bench_wait_for (gboolean *done);
+
+BenchReport *bench_report_new (const gchar *benchmark);
+void bench_report_add_count (BenchReport *report,
+                             const gchar *key,
+                             guint64      count);
+void bench_report_add_duration (BenchReport *report,
+                                const gchar *key,
+                                gint64       duration_us);
+void bench_report_add_rate (BenchReport *report,
+                            const gchar *key,
+                            guint64      n_bytes,
+                            gint64       duration_us);
+void bench_report_finish (BenchReport *report);
@@ -0,0 +1,103 @@
+#include "bench-utilities.h"
+
+#include <nautilus-directory.h>
+#include <nautilus-file.h>
+#include <nautilus-view-item.h>
+#include <nautilus-view-model.h>
+
+/* Adds the files of a large directory to a sorted NautilusViewModel, as a
+ * view does when loading it, then removes them in a batch, then all at once. */
+
+#define DEFAULT_N_FILES 100000
+
+static gint
+sort_by_name (gconstpointer a,
+              gconstpointer b,
+              gpointer      user_data)
+{
+    NautilusFile *file_a = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) a));
+    NautilusFile *file_b = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) b));
+
+    return nautilus_file_compare_for_sort (file_a, file_b,
+                                           NAUTILUS_FILE_SORT_BY_DISPLAY_NAME,
+                                           TRUE, FALSE);
+}
+
+static void
+directory_ready_cb (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           user_data)
+{
+    gboolean *done = user_data;
+
+    *done = TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    g_autoptr (NautilusViewModel) model = NULL;
+    g_autoptr (GtkCustomSorter) sorter = NULL;
+    g_autolist (NautilusFile) files = NULL;
+    g_autolist (NautilusViewItem) items = NULL;
+    g_autoptr (GList) removed_items = NULL;
+    BenchReport *report;
+    guint n_files;
+    guint i;
+    gboolean done = FALSE;
+    gint64 start_time;
+
+    bench_init ();
+
+    n_files = bench_get_n_files (DEFAULT_N_FILES);
+    location = bench_create_flat_directory ("view_model", n_files);
+
+    directory = nautilus_directory_get (location);
+    nautilus_directory_call_when_ready (directory, NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE, directory_ready_cb, &done);
+    bench_wait_for (&done);
+
+    files = nautilus_directory_get_file_list (directory);
+    i = 0;
+    for (GList *l = files; l != NULL; l = l->next, i++)
+    {
+        NautilusViewItem *item = nautilus_view_item_new (l->data);
+
+        items = g_list_prepend (items, item);
+        if (i % 2 == 0)
+        {
+            removed_items = g_list_prepend (removed_items, item);
+        }
+    }
+
+    model = nautilus_view_model_new ();
+    sorter = gtk_custom_sorter_new (sort_by_name, NULL, NULL);
+    nautilus_view_model_set_sorter (model, GTK_SORTER (sorter));
+
+    report = bench_report_new ("view-model");
+    bench_report_add_count (report, "files", g_list_length (items));
+
+    start_time = g_get_monotonic_time ();
+    nautilus_view_model_add_items (model, items);
+    bench_report_add_duration (report, "add", g_get_monotonic_time () - start_time);
+
+    start_time = g_get_monotonic_time ();
+    nautilus_view_model_remove_items (model, removed_items, directory);
+    bench_report_add_duration (report, "remove_half", g_get_monotonic_time () - start_time);
+
+    start_time = g_get_monotonic_time ();
+    nautilus_view_model_remove_all_items (model);
+    bench_report_add_duration (report, "remove_all", g_get_monotonic_time () - start_time);
+
+    bench_report_finish (report);
+
+    g_clear_object (&model);
+    g_clear_pointer (&directory, nautilus_directory_unref);
+    bench_delete_recursively (location);
+    test_clear_tmp_dir ();
+
+    return 0;
+}